@@ -0,0 +1,65 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BenchmarkBrowser.h"
+#include "VaultGenerator.h"
+
+#include "browser/BrowserService.h"
+#include "core/Database.h"
+#include "crypto/Crypto.h"
+
+#include <QTest>
+
+QTEST_GUILESS_MAIN(BenchmarkBrowser)
+
+void BenchmarkBrowser::initTestCase()
+{
+    QVERIFY(Crypto::init());
+
+    const auto options = VaultGenerator::Options::fromEnvironment();
+    qInfo("Vault: %s", qPrintable(options.toString()));
+    m_db = VaultGenerator::generate(options);
+}
+
+void BenchmarkBrowser::benchmarkSearchEntries_data()
+{
+    QTest::addColumn<QString>("siteUrl");
+    QTest::addColumn<QString>("formUrl");
+
+    // Sites of the generated vault are https://www.site<n>.example.com/login
+    QTest::newRow("exact") << QString("https://www.site7.example.com/login")
+                           << QString("https://www.site7.example.com/login");
+    QTest::newRow("subdomain") << QString("https://accounts.site7.example.com")
+                               << QString("https://accounts.site7.example.com/session");
+    QTest::newRow("unknown") << QString("https://nowhere.org") << QString("https://nowhere.org/login");
+}
+
+/**
+ * Find the entries matching a page, as done for every page the browser
+ * extension asks credentials for.
+ */
+void BenchmarkBrowser::benchmarkSearchEntries()
+{
+    QFETCH(QString, siteUrl);
+    QFETCH(QString, formUrl);
+
+    BrowserService* service = browserService();
+    QBENCHMARK
+    {
+        service->searchEntries(m_db, siteUrl, formUrl);
+    }
+}
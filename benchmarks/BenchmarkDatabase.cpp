@@ -0,0 +1,289 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BenchmarkDatabase.h"
+
+#include "core/Database.h"
+#include "core/EntrySearcher.h"
+#include "core/Group.h"
+#include "core/Merger.h"
+#include "core/PasswordHealth.h"
+#include "core/PlaceholderCache.h"
+#include "core/StringInterner.h"
+#include "crypto/Crypto.h"
+#include "format/KeePass2Reader.h"
+#include "format/KeePass2Writer.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QTest>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#endif
+
+QTEST_GUILESS_MAIN(BenchmarkDatabase)
+
+namespace
+{
+    // Resident memory of the process in bytes, -1 where it is unknown
+    qint64 residentMemory()
+    {
+#ifdef Q_OS_LINUX
+#ifdef __GLIBC__
+        // Return memory freed by earlier runs so that it is not reused unnoticed
+        malloc_trim(0);
+#endif
+        QFile statm("/proc/self/statm");
+        if (statm.open(QIODevice::ReadOnly)) {
+            const QList<QByteArray> fields = statm.readAll().split(' ');
+            if (fields.size() > 1) {
+                return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+            }
+        }
+#endif
+        return -1;
+    }
+
+    // Turn every history item into an Entry, as if the reader did not keep history compact
+    void expandHistory(const Database& db)
+    {
+        const QList<Entry*> entries = db.rootGroup()->entriesRecursive();
+        for (Entry* entry : entries) {
+            entry->historyItems();
+        }
+    }
+} // namespace
+
+void BenchmarkDatabase::initTestCase()
+{
+    QVERIFY(Crypto::init());
+
+    m_options = VaultGenerator::Options::fromEnvironment();
+    qInfo("Vault: %s", qPrintable(m_options.toString()));
+    m_db = VaultGenerator::generate(m_options);
+
+    QBuffer buffer(&m_kdbx);
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    KeePass2Writer writer;
+    QVERIFY2(writer.writeDatabase(&buffer, m_db.data()), qPrintable(writer.errorString()));
+    qInfo("Vault size: %d KiB", m_kdbx.size() / 1024);
+}
+
+void BenchmarkDatabase::benchmarkOpen_data()
+{
+    QTest::addColumn<bool>("expandedHistory");
+
+    QTest::newRow("compact history") << false;
+    QTest::newRow("expanded history") << true;
+}
+
+void BenchmarkDatabase::benchmarkOpen()
+{
+    QFETCH(bool, expandedHistory);
+
+    QBENCHMARK
+    {
+        QBuffer buffer(&m_kdbx);
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+        Database db;
+        KeePass2Reader reader;
+        QVERIFY2(reader.readDatabase(&buffer, m_db->key(), &db), qPrintable(reader.errorString()));
+        if (expandedHistory) {
+            expandHistory(db);
+        }
+    }
+}
+
+void BenchmarkDatabase::benchmarkOpenMemory_data()
+{
+    QTest::addColumn<bool>("interning");
+    QTest::addColumn<bool>("expandedHistory");
+
+    QTest::newRow("interned") << true << false;
+    QTest::newRow("plain") << false << false;
+    QTest::newRow("expanded history") << true << true;
+}
+
+/**
+ * Memory used by an opened vault of at least 100000 entries, with and without
+ * sharing attribute keys, tags and group names through the string interner,
+ * and with the history expanded into entries after reading.
+ * The result is the growth of the resident memory while reading the vault.
+ */
+void BenchmarkDatabase::benchmarkOpenMemory()
+{
+    QFETCH(bool, interning);
+    QFETCH(bool, expandedHistory);
+
+    if (residentMemory() < 0) {
+        QSKIP("Resident memory is not available on this platform");
+    }
+
+    VaultGenerator::Options options = m_options;
+    options.entries = qMax(options.entries, 100000);
+    if (m_largeKdbx.isEmpty()) {
+        QSharedPointer<Database> db = VaultGenerator::generate(options);
+        QBuffer buffer(&m_largeKdbx);
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        KeePass2Writer writer;
+        QVERIFY2(writer.writeDatabase(&buffer, db.data()), qPrintable(writer.errorString()));
+    }
+
+    QBuffer buffer(&m_largeKdbx);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    Database db;
+    db.stringInterner()->setEnabled(interning);
+    KeePass2Reader reader;
+    const qint64 before = residentMemory();
+    QVERIFY2(reader.readDatabase(&buffer, m_db->key(), &db), qPrintable(reader.errorString()));
+    if (expandedHistory) {
+        expandHistory(db);
+    }
+    const qint64 used = residentMemory() - before;
+
+    qInfo("Entries: %d, interning: %s, history: %s, resident memory: %lld KiB, shared strings: %d, "
+          "shared string data: %lld KiB",
+          options.entries,
+          interning ? "on" : "off",
+          expandedHistory ? "expanded" : "compact",
+          used / 1024,
+          db.stringInterner()->size(),
+          db.stringInterner()->sharedBytes() / 1024);
+    QTest::setBenchmarkResult(used, QTest::BytesAllocated);
+}
+
+void BenchmarkDatabase::benchmarkSave()
+{
+    QBENCHMARK
+    {
+        QByteArray data;
+        QBuffer buffer(&data);
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        KeePass2Writer writer;
+        QVERIFY2(writer.writeDatabase(&buffer, m_db.data()), qPrintable(writer.errorString()));
+    }
+}
+
+void BenchmarkDatabase::benchmarkSearch_data()
+{
+    QTest::addColumn<QString>("searchString");
+
+    QTest::newRow("word") << QString("site42");
+    QTest::newRow("missing") << QString("nowhere");
+    QTest::newRow("fields") << QString("title:entry url:example");
+    QTest::newRow("exclude") << QString("-second");
+    QTest::newRow("regex") << QString("*user:^user1.*@");
+}
+
+void BenchmarkDatabase::benchmarkSearch()
+{
+    QFETCH(QString, searchString);
+
+    EntrySearcher searcher;
+    QBENCHMARK
+    {
+        searcher.search(searchString, m_db->rootGroup());
+    }
+}
+
+/**
+ * Merge a copy of the vault in which every tenth entry was changed later.
+ */
+void BenchmarkDatabase::benchmarkMerge()
+{
+    QSharedPointer<Database> source = VaultGenerator::generate(m_options);
+    QSharedPointer<Database> target = VaultGenerator::generate(m_options);
+
+    const QList<Entry*> entries = source->rootGroup()->entriesRecursive();
+    for (int i = 0; i < entries.size(); i += 10) {
+        Entry* entry = entries.at(i);
+        entry->beginUpdate();
+        entry->setNotes(entry->notes() + "\nChanged");
+        entry->endUpdate();
+    }
+
+    Merger merger(source.data(), target.data());
+    QBENCHMARK_ONCE
+    {
+        merger.merge();
+    }
+}
+
+void BenchmarkDatabase::benchmarkHealthCheck()
+{
+    const QList<Entry*> entries = m_db->rootGroup()->entriesRecursive();
+    QBENCHMARK
+    {
+        m_db->passwordHealthCache()->clear();
+        HealthChecker checker(m_db);
+        for (const Entry* entry : entries) {
+            checker.evaluate(entry);
+        }
+    }
+}
+
+void BenchmarkDatabase::benchmarkEntriesRecursive_data()
+{
+    QTest::addColumn<bool>("includeHistoryItems");
+
+    QTest::newRow("entries") << false;
+    QTest::newRow("history") << true;
+}
+
+void BenchmarkDatabase::benchmarkEntriesRecursive()
+{
+    QFETCH(bool, includeHistoryItems);
+
+    QBENCHMARK
+    {
+        m_db->rootGroup()->entriesRecursive(includeHistoryItems);
+    }
+}
+
+void BenchmarkDatabase::benchmarkPlaceholders_data()
+{
+    QTest::addColumn<bool>("cached");
+
+    QTest::newRow("uncached") << false;
+    QTest::newRow("cached") << true;
+}
+
+/**
+ * Resolve the username and password of all entries, the vault refers to
+ * other entries in m_options.references of them.
+ */
+void BenchmarkDatabase::benchmarkPlaceholders()
+{
+    QFETCH(bool, cached);
+
+    const QList<Entry*> entries = m_db->rootGroup()->entriesRecursive();
+    m_db->placeholderCache()->clear();
+    QBENCHMARK
+    {
+        if (!cached) {
+            m_db->placeholderCache()->clear();
+        }
+        for (const Entry* entry : entries) {
+            entry->resolveMultiplePlaceholders(entry->username());
+            entry->resolveMultiplePlaceholders(entry->password());
+        }
+    }
+}
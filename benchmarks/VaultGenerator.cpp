@@ -0,0 +1,222 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "VaultGenerator.h"
+
+#include "core/Database.h"
+#include "core/Group.h"
+#include "core/Metadata.h"
+#include "crypto/kdf/Kdf.h"
+#include "format/KeePass2.h"
+#include "keys/CompositeKey.h"
+#include "keys/PasswordKey.h"
+
+namespace
+{
+    // xorshift64*, deterministic for a given seed unlike the crypto random generator
+    class Random
+    {
+    public:
+        explicit Random(quint64 seed)
+            : m_state(seed ? seed : 1)
+        {
+        }
+
+        quint64 next()
+        {
+            m_state ^= m_state >> 12;
+            m_state ^= m_state << 25;
+            m_state ^= m_state >> 27;
+            return m_state * Q_UINT64_C(2685821657736338717);
+        }
+
+        int bounded(int bound)
+        {
+            return static_cast<int>(next() % static_cast<quint64>(bound));
+        }
+
+        QByteArray bytes(int size)
+        {
+            QByteArray result(size, Qt::Uninitialized);
+            for (int i = 0; i < size; ++i) {
+                result[i] = static_cast<char>(next() >> 56);
+            }
+            return result;
+        }
+
+        QString password(int length)
+        {
+            static const char Characters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!#$%&*+-";
+            QString result;
+            result.reserve(length);
+            for (int i = 0; i < length; ++i) {
+                result.append(QLatin1Char(Characters[bounded(sizeof(Characters) - 1)]));
+            }
+            return result;
+        }
+
+        QUuid uuid()
+        {
+            return QUuid::fromRfc4122(bytes(16));
+        }
+
+    private:
+        quint64 m_state;
+    };
+
+    int environmentValue(const char* name, int defaultValue)
+    {
+        bool ok = false;
+        const int value = qEnvironmentVariableIntValue(name, &ok);
+        return ok && value >= 0 ? value : defaultValue;
+    }
+} // namespace
+
+/**
+ * Read the options from BENCHMARK_ENTRIES, BENCHMARK_HISTORY_DEPTH,
+ * BENCHMARK_ATTACHMENTS, BENCHMARK_ATTACHMENT_SIZE, BENCHMARK_REFERENCES,
+ * BENCHMARK_GROUP_DEPTH, BENCHMARK_GROUP_FANOUT and BENCHMARK_SEED, the
+ * defaults are used for unset variables.
+ */
+VaultGenerator::Options VaultGenerator::Options::fromEnvironment()
+{
+    Options options;
+    options.entries = environmentValue("BENCHMARK_ENTRIES", options.entries);
+    options.historyDepth = environmentValue("BENCHMARK_HISTORY_DEPTH", options.historyDepth);
+    options.attachments = environmentValue("BENCHMARK_ATTACHMENTS", options.attachments);
+    options.attachmentSize = environmentValue("BENCHMARK_ATTACHMENT_SIZE", options.attachmentSize);
+    options.references = environmentValue("BENCHMARK_REFERENCES", options.references);
+    options.groupDepth = environmentValue("BENCHMARK_GROUP_DEPTH", options.groupDepth);
+    options.groupFanout = qMax(1, environmentValue("BENCHMARK_GROUP_FANOUT", options.groupFanout));
+    options.seed = static_cast<quint64>(environmentValue("BENCHMARK_SEED", static_cast<int>(options.seed)));
+    return options;
+}
+
+QString VaultGenerator::Options::toString() const
+{
+    return QStringLiteral("entries=%1 historyDepth=%2 attachments=%3x%4B references=%5 groups=%6^%7 seed=%8")
+        .arg(entries)
+        .arg(historyDepth)
+        .arg(attachments)
+        .arg(attachmentSize)
+        .arg(references)
+        .arg(groupFanout)
+        .arg(groupDepth)
+        .arg(seed);
+}
+
+/**
+ * Generate a database with a cheap key derivation, so saving and opening it
+ * measures the file format rather than the KDF.
+ *
+ * Entries are spread evenly over all groups. Every tenth entry reuses the
+ * password of its predecessor and many entries share a site, so health
+ * checks and URL matching have duplicates to find.
+ */
+QSharedPointer<Database> VaultGenerator::generate(const Options& options)
+{
+    Random random(options.seed);
+
+    auto db = QSharedPointer<Database>::create();
+    auto key = QSharedPointer<CompositeKey>::create();
+    key->addKey(QSharedPointer<PasswordKey>::create("benchmark"));
+    db->setKey(key, true, false, false);
+    auto kdf = KeePass2::uuidToKdf(KeePass2::KDF_ARGON2D);
+    kdf->setRounds(1);
+    kdf->processParameters({{KeePass2::KDFPARAM_ARGON2_MEMORY, 1024}, {KeePass2::KDFPARAM_ARGON2_PARALLELISM, 1}});
+    db->changeKdf(kdf);
+
+    Metadata* metadata = db->metadata();
+    metadata->setHistoryMaxItems(qMax(options.historyDepth, metadata->historyMaxItems()));
+    metadata->setHistoryMaxSize(-1);
+
+    // A fixed time keeps databases generated with the same options identical
+    TimeInfo timeInfo;
+    const QDateTime time(QDate(2021, 1, 1), QTime(0, 0), Qt::UTC);
+    timeInfo.setCreationTime(time);
+    timeInfo.setLastModificationTime(time);
+    timeInfo.setLastAccessTime(time);
+    timeInfo.setLocationChanged(time);
+    db->rootGroup()->setUuid(random.uuid());
+    db->rootGroup()->setTimeInfo(timeInfo);
+
+    QList<Group*> groups{db->rootGroup()};
+    QList<Group*> level{db->rootGroup()};
+    for (int depth = 0; depth < options.groupDepth; ++depth) {
+        QList<Group*> nextLevel;
+        for (Group* parent : level) {
+            for (int i = 0; i < options.groupFanout; ++i) {
+                auto* group = new Group();
+                group->setUuid(random.uuid());
+                group->setName(QStringLiteral("Group %1").arg(groups.size()));
+                group->setParent(parent);
+                group->setTimeInfo(timeInfo);
+                nextLevel.append(group);
+                groups.append(group);
+            }
+        }
+        level = nextLevel;
+    }
+
+    const int sites = qMax(1, options.entries / 4);
+    const int attachmentInterval = options.attachments > 0 ? qMax(1, options.entries / options.attachments) : 0;
+    int attachmentCount = 0;
+    QList<Entry*> entries;
+    entries.reserve(options.entries);
+    QString password;
+    for (int i = 0; i < options.entries; ++i) {
+        auto* entry = new Entry();
+        entry->setUpdateTimeinfo(false);
+        entry->setUuid(random.uuid());
+        entry->setTitle(QStringLiteral("Entry %1").arg(i));
+        entry->setUsername(QStringLiteral("user%1@example.com").arg(i));
+        if (i % 10 != 0 || password.isEmpty()) {
+            password = random.password(8 + random.bounded(16));
+        }
+        entry->setPassword(password);
+        entry->setUrl(QStringLiteral("https://www.site%1.example.com/login").arg(random.bounded(sites)));
+        entry->setNotes(QStringLiteral("Notes of entry %1\nwith a second line").arg(i));
+
+        if (i > 0 && i <= options.references) {
+            const QString target = entries.at(random.bounded(i))->uuidToHex();
+            entry->setUsername(QStringLiteral("{REF:U@I:%1}").arg(target));
+            entry->setPassword(QStringLiteral("{REF:P@I:%1}").arg(target));
+        }
+
+        if (attachmentInterval > 0 && attachmentCount < options.attachments && i % attachmentInterval == 0) {
+            entry->attachments()->set(QStringLiteral("attachment.bin"), random.bytes(options.attachmentSize));
+            ++attachmentCount;
+        }
+
+        for (int h = 0; h < options.historyDepth; ++h) {
+            Entry* historyItem = entry->clone(Entry::CloneNoFlags);
+            historyItem->setUpdateTimeinfo(false);
+            historyItem->setPassword(random.password(12));
+            TimeInfo historyTimeInfo = timeInfo;
+            historyTimeInfo.setLastModificationTime(time.addDays(h - options.historyDepth));
+            historyItem->setTimeInfo(historyTimeInfo);
+            entry->addHistoryItem(historyItem);
+        }
+        entry->setTimeInfo(timeInfo);
+
+        entry->setGroup(groups.at(i % groups.size()));
+        entry->setUpdateTimeinfo(true);
+        entries.append(entry);
+    }
+
+    return db;
+}
@@ -0,0 +1,58 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_VAULTGENERATOR_H
+#define KEEPASSXC_VAULTGENERATOR_H
+
+#include <QSharedPointer>
+#include <QString>
+
+class Database;
+
+/**
+ * Generates synthetic databases for the benchmarks.
+ *
+ * The same options always produce the same database, so results stay
+ * comparable between runs and releases. Every option can be overridden
+ * through an environment variable, see Options::fromEnvironment().
+ */
+class VaultGenerator
+{
+public:
+    struct Options
+    {
+        int entries = 10000;
+        // History items per entry
+        int historyDepth = 5;
+        // Entries with an attachment and the size of each attachment in bytes
+        int attachments = 100;
+        int attachmentSize = 16 * 1024;
+        // Entries whose username and password refer to another entry
+        int references = 1000;
+        // Levels of groups below the root group and child groups per group
+        int groupDepth = 3;
+        int groupFanout = 4;
+        quint64 seed = 1;
+
+        static Options fromEnvironment();
+        QString toString() const;
+    };
+
+    static QSharedPointer<Database> generate(const Options& options);
+};
+
+#endif // KEEPASSXC_VAULTGENERATOR_H
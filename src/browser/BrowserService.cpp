@@ -24,6 +24,8 @@
 #include "BrowserEntrySaveDialog.h"
 #include "BrowserHost.h"
 #include "BrowserSettings.h"
+#include "core/EntryUrl.h"
+#include "core/EntryUrlIndex.h"
 #include "core/Tools.h"
 #include "gui/MainWindow.h"
 #include "gui/MessageBox.h"
@@ -49,6 +51,27 @@ static int KEEPASSXCBROWSER_DEFAULT_ICON = 1;
 // These are for the settings and password conversion
 static const QString KEEPASSHTTP_NAME = QStringLiteral("KeePassHttp Settings");
 static const QString KEEPASSHTTP_GROUP_NAME = QStringLiteral("KeePassHttp Passwords");
+
+// Sort entries in the order of Group::entriesRecursive()
+static void sortByTreeOrder(QList<Entry*>& entries)
+{
+    QList<QPair<QVector<int>, Entry*>> keys;
+    keys.reserve(entries.size());
+    for (auto* entry : asConst(entries)) {
+        // Rows of the groups from the root, entries of a group come before its child groups
+        QVector<int> key{-1, entry->group()->entries().indexOf(entry)};
+        for (const Group* group = entry->group(); group->parentGroup(); group = group->parentGroup()) {
+            key.prepend(group->parentGroup()->children().indexOf(const_cast<Group*>(group)));
+        }
+        keys.append({key, entry});
+    }
+
+    std::sort(keys.begin(), keys.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+    for (int i = 0; i < keys.size(); ++i) {
+        entries[i] = keys.at(i).second;
+    }
+}
+
 // Extra entry related options saved in custom data
 const QString BrowserService::OPTION_SKIP_AUTO_SUBMIT = QStringLiteral("BrowserSkipAutoSubmit");
 const QString BrowserService::OPTION_HIDE_ENTRY = QStringLiteral("BrowserHideEntry");
@@ -642,35 +665,42 @@ BrowserService::searchEntries(const QSharedPointer<Database>& db, const QString&
         return entries;
     }
 
-    for (const auto& group : rootGroup->groupsRecursive(true)) {
-        if (group->isRecycled()
-            || group->resolveCustomDataTriState(BrowserService::OPTION_HIDE_ENTRY) == Group::Enable) {
+    // Only entries with a URL in the domain of the site can match, except for the special schemes
+    QList<Entry*> candidates;
+    if (siteUrlStr.startsWith("keepassxc://") || siteUrlStr.startsWith("file://")) {
+        candidates = rootGroup->entriesRecursive();
+    } else {
+        candidates = db->urlIndex()->entries(getTopLevelDomainFromUrl(QUrl(siteUrlStr).host()));
+        sortByTreeOrder(candidates);
+    }
+
+    QHash<const Group*, bool> hiddenGroups;
+    for (auto* entry : asConst(candidates)) {
+        const Group* group = entry->group();
+        auto hidden = hiddenGroups.constFind(group);
+        if (hidden == hiddenGroups.constEnd()) {
+            hidden = hiddenGroups.insert(group,
+                                         group->isRecycled()
+                                             || group->resolveCustomDataTriState(BrowserService::OPTION_HIDE_ENTRY)
+                                                    == Group::Enable);
+        }
+        if (hidden.value() || entry->isRecycled()
+            || (entry->customData()->contains(BrowserService::OPTION_HIDE_ENTRY)
+                && entry->customData()->value(BrowserService::OPTION_HIDE_ENTRY) == TRUE_STR)) {
             continue;
         }
 
-        for (auto* entry : group->entries()) {
-            if (entry->isRecycled()
-                || (entry->customData()->contains(BrowserService::OPTION_HIDE_ENTRY)
-                    && entry->customData()->value(BrowserService::OPTION_HIDE_ENTRY) == TRUE_STR)) {
-                continue;
-            }
-
-            // Search for additional URL's starting with KP2A_URL
-            for (const auto& key : entry->attributes()->keys()) {
-                if (key.startsWith(ADDITIONAL_URL) && handleURL(entry->attributes()->value(key), siteUrlStr, formUrlStr)
-                    && !entries.contains(entry)) {
-                    entries.append(entry);
-                    continue;
-                }
-            }
-
-            if (!handleEntry(entry, siteUrlStr, formUrlStr)) {
-                continue;
-            }
+        if (handleEntry(entry, siteUrlStr, formUrlStr)) {
+            entries.append(entry);
+            continue;
+        }
 
-            // Additional URL check may have already inserted the entry to the list
-            if (!entries.contains(entry)) {
+        // Search for additional URL's starting with KP2A_URL
+        for (const auto& key : entry->attributes()->keys()) {
+            if (key.startsWith(ADDITIONAL_URL)
+                && handleURL(entry->attributes()->parsedUrl(key), siteUrlStr, formUrlStr)) {
                 entries.append(entry);
+                break;
             }
         }
     }
@@ -709,13 +739,10 @@ BrowserService::searchEntries(const QString& siteUrlStr, const QString& formUrlS
     }
 
     // Search entries matching the hostname
-    QString hostname = QUrl(siteUrlStr).host();
     QList<Entry*> entries;
-    do {
-        for (const auto& db : databases) {
-            entries << searchEntries(db, siteUrlStr, formUrlStr);
-        }
-    } while (entries.isEmpty() && removeFirstDomain(hostname));
+    for (const auto& db : databases) {
+        entries << searchEntries(db, siteUrlStr, formUrlStr);
+    }
 
     return entries;
 }
@@ -977,7 +1004,7 @@ Group* BrowserService::getDefaultEntryGroup(const QSharedPointer<Database>& sele
 
 // Returns the maximum sort priority given a set of match urls and the
 // extension provided site and form url.
-int BrowserService::sortPriority(const QStringList& urls, const QString& siteUrlStr, const QString& formUrlStr)
+int BrowserService::sortPriority(const QList<EntryUrl>& urls, const QString& siteUrlStr, const QString& formUrlStr)
 {
     QList<int> priorityList;
     // NOTE: QUrl::matches is utterly broken in Qt < 5.11, so we work around that
@@ -986,19 +1013,9 @@ int BrowserService::sortPriority(const QStringList& urls, const QString& siteUrl
     const auto siteUrl = QUrl(siteUrlStr).adjusted(stdOpts);
     const auto formUrl = QUrl(formUrlStr).adjusted(stdOpts);
 
-    auto getPriority = [&](const QString& givenUrl) {
-        auto url = QUrl::fromUserInput(givenUrl).adjusted(stdOpts);
-
-        // Default to https scheme if undefined
-        if (url.scheme().isEmpty() || !givenUrl.contains("://")) {
-            url.setScheme("https");
-        }
-
-        // Add the empty path to the URL if it's missing.
-        // URL's from the extension always have a path set, entry URL's can be without.
-        if (url.path().isEmpty() && !url.hasFragment() && !url.hasQuery()) {
-            url.setPath("/");
-        }
+    auto getPriority = [&](const EntryUrl& entryUrl) {
+        // Entry URLs are normalized the same way when they are parsed
+        const auto& url = entryUrl.normalized();
 
         // Reject invalid urls and hosts, except 'localhost', and scheme mismatch
         if (!url.isValid() || (!url.host().contains(".") && url.host() != "localhost")
@@ -1060,23 +1077,6 @@ bool BrowserService::isIpAddress(const QString& host) const
     return address.protocol() == QAbstractSocket::IPv4Protocol || address.protocol() == QAbstractSocket::IPv6Protocol;
 }
 
-bool BrowserService::removeFirstDomain(QString& hostname)
-{
-    int pos = hostname.indexOf(".");
-    if (pos < 0) {
-        return false;
-    }
-
-    // Don't remove the second-level domain if it's the only one
-    if (hostname.count(".") > 1) {
-        hostname = hostname.mid(pos + 1);
-        return !hostname.isEmpty();
-    }
-
-    // Nothing removed
-    return false;
-}
-
 /* Test if a search URL matches a custom entry. If the URL has the schema "keepassxc", some special checks will be made.
  * Otherwise, this simply delegates to handleURL(). */
 bool BrowserService::handleEntry(Entry* entry, const QString& url, const QString& submitUrl)
@@ -1087,61 +1087,56 @@ bool BrowserService::handleEntry(Entry* entry, const QString& url, const QString
     } else if (url.startsWith("keepassxc://by-path/")) {
         return url.endsWith("by-path/" + entry->path());
     }
-    return handleURL(entry->url(), url, submitUrl);
+    return handleURL(entry->attributes()->parsedUrl(EntryAttributes::URLKey), url, submitUrl);
 }
 
 bool BrowserService::handleURL(const QString& entryUrl, const QString& siteUrlStr, const QString& formUrlStr)
 {
-    if (entryUrl.isEmpty()) {
-        return false;
-    }
-
-    QUrl entryQUrl;
-    if (entryUrl.contains("://")) {
-        entryQUrl = entryUrl;
-    } else {
-        entryQUrl = QUrl::fromUserInput(entryUrl);
+    return handleURL(EntryUrl(entryUrl), siteUrlStr, formUrlStr);
+}
 
-        if (browserSettings()->matchUrlScheme()) {
-            entryQUrl.setScheme("https");
-        }
+bool BrowserService::handleURL(const EntryUrl& entryUrl, const QString& siteUrlStr, const QString& formUrlStr)
+{
+    if (entryUrl.text().isEmpty()) {
+        return false;
     }
 
     // Make a direct compare if a local file is used
     if (siteUrlStr.startsWith("file://")) {
-        return entryUrl == formUrlStr;
+        return entryUrl.text() == formUrlStr;
     }
 
     // URL host validation fails
-    if (entryQUrl.host().isEmpty()) {
+    if (entryUrl.host().isEmpty()) {
         return false;
     }
 
     // Match port, if used
     QUrl siteQUrl(siteUrlStr);
-    if (entryQUrl.port() > 0 && entryQUrl.port() != siteQUrl.port()) {
+    if (entryUrl.port() > 0 && entryUrl.port() != siteQUrl.port()) {
         return false;
     }
 
-    // Match scheme
-    if (browserSettings()->matchUrlScheme() && !entryQUrl.scheme().isEmpty()
-        && entryQUrl.scheme().compare(siteQUrl.scheme()) != 0) {
-        return false;
+    // Match scheme, URLs without one are treated as https
+    if (browserSettings()->matchUrlScheme()) {
+        const QString scheme = entryUrl.hasScheme() ? entryUrl.scheme() : QStringLiteral("https");
+        if (!scheme.isEmpty() && scheme.compare(siteQUrl.scheme()) != 0) {
+            return false;
+        }
     }
 
     // Check for illegal characters
-    QRegularExpression re("[<>\\^`{|}]");
-    if (re.match(entryUrl).hasMatch()) {
+    if (entryUrl.hasIllegalCharacters()) {
         return false;
     }
 
     // Match the base domain
-    if (getTopLevelDomainFromUrl(siteQUrl.host()) != getTopLevelDomainFromUrl(entryQUrl.host())) {
+    if (getTopLevelDomainFromUrl(siteQUrl.host()) != entryUrl.domain()) {
         return false;
     }
 
     // Match the subdomains with the limited wildcard
-    if (siteQUrl.host().endsWith(entryQUrl.host())) {
+    if (siteQUrl.host().endsWith(entryUrl.host())) {
         return true;
     }
 
@@ -1155,25 +1150,7 @@ bool BrowserService::handleURL(const QString& entryUrl, const QString& siteUrlSt
  */
 QString BrowserService::getTopLevelDomainFromUrl(const QString& url) const
 {
-    QUrl qurl = QUrl::fromUserInput(url);
-    QString host = qurl.host();
-
-    // If the hostname is an IP address, return it directly
-    if (isIpAddress(host)) {
-        return host;
-    }
-
-    if (host.isEmpty() || !host.contains(qurl.topLevelDomain())) {
-        return {};
-    }
-
-    // Remove the top level domain part from the hostname, e.g. https://another.example.co.uk -> https://another.example
-    host.chop(qurl.topLevelDomain().length());
-    // Split the URL and select the last part, e.g. https://another.example -> example
-    QString baseDomain = host.split('.').last();
-    // Append the top level domain back to the URL, e.g. example -> example.co.uk
-    baseDomain.append(qurl.topLevelDomain());
-    return baseDomain;
+    return EntryUrl::registrableDomain(url);
 }
 
 QSharedPointer<Database> BrowserService::getDatabase()
@@ -1291,15 +1268,16 @@ bool BrowserService::checkLegacySettings(QSharedPointer<Database> db)
     return dialogResult == MessageBox::Yes;
 }
 
-QStringList BrowserService::getEntryURLs(const Entry* entry)
+QList<EntryUrl> BrowserService::getEntryURLs(const Entry* entry)
 {
-    QStringList urlList;
-    urlList << entry->url();
+    const auto* attributes = entry->attributes();
+    QList<EntryUrl> urlList;
+    urlList << attributes->parsedUrl(EntryAttributes::URLKey);
 
     // Handle additional URL's
-    for (const auto& key : entry->attributes()->keys()) {
+    for (const auto& key : attributes->keys()) {
         if (key.startsWith(ADDITIONAL_URL)) {
-            urlList << entry->attributes()->value(key);
+            urlList << attributes->parsedUrl(key);
         }
     }
 
@@ -135,12 +135,12 @@ private:
     QJsonArray getChildrenFromGroup(Group* group);
     Access checkAccess(const Entry* entry, const QString& siteHost, const QString& formHost, const QString& realm);
     Group* getDefaultEntryGroup(const QSharedPointer<Database>& selectedDb = {});
-    int sortPriority(const QStringList& urls, const QString& siteUrlStr, const QString& formUrlStr);
+    int sortPriority(const QList<EntryUrl>& urls, const QString& siteUrlStr, const QString& formUrlStr);
     bool schemeFound(const QString& url);
     bool isIpAddress(const QString& host) const;
-    bool removeFirstDomain(QString& hostname);
     bool handleEntry(Entry* entry, const QString& url, const QString& submitUrl);
     bool handleURL(const QString& entryUrl, const QString& siteUrlStr, const QString& formUrlStr);
+    bool handleURL(const EntryUrl& entryUrl, const QString& siteUrlStr, const QString& formUrlStr);
     QString getTopLevelDomainFromUrl(const QString& url) const;
     QString baseDomain(const QString& hostname) const;
     QSharedPointer<Database> getDatabase();
@@ -148,7 +148,7 @@ private:
     QString getDatabaseRootUuid();
     QString getDatabaseRecycleBinUuid();
     bool checkLegacySettings(QSharedPointer<Database> db);
-    QStringList getEntryURLs(const Entry* entry);
+    QList<EntryUrl> getEntryURLs(const Entry* entry);
     void hideWindow() const;
     void raiseWindow(const bool force = false);
 
@@ -171,6 +171,7 @@ private:
     Q_DISABLE_COPY(BrowserService);
 
     friend class TestBrowser;
+    friend class BenchmarkBrowser;
 };
 
 static inline BrowserService* browserService()
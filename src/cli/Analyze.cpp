@@ -28,7 +28,7 @@ const QCommandLineOption Analyze::HIBPDatabaseOption = QCommandLineOption(
     {"H", "hibp"},
     QObject::tr("Check if any passwords have been publicly leaked. FILENAME must be the path of a file listing "
                 "SHA-1 hashes of leaked passwords in HIBP format, as available from "
-                "https://haveibeenpwned.com/Passwords."),
+                "https://haveibeenpwned.com/Passwords, or an index created from such a file with hibp-index."),
     QObject::tr("FILENAME"));
 
 const QCommandLineOption Analyze::OkonOption =
@@ -36,12 +36,18 @@ const QCommandLineOption Analyze::OkonOption =
                        QObject::tr("Path to okon-cli to search a formatted HIBP file"),
                        QObject::tr("okon-cli"));
 
+const QCommandLineOption Analyze::HIBPOrderedOption =
+    QCommandLineOption("hibp-ordered",
+                       QObject::tr("The HIBP file is ordered by hash, stop reading it after the largest hash of "
+                                   "the passwords. Leaked passwords can be missed if the file is not ordered."));
+
 Analyze::Analyze()
 {
     name = QString("analyze");
     description = QObject::tr("Analyze passwords for weaknesses and problems.");
     options.append(Analyze::HIBPDatabaseOption);
     options.append(Analyze::OkonOption);
+    options.append(Analyze::HIBPOrderedOption);
 }
 
 int Analyze::executeWithDatabase(QSharedPointer<Database> database, QSharedPointer<QCommandLineParser> parser)
@@ -73,11 +79,21 @@ int Analyze::executeWithDatabase(QSharedPointer<Database> database, QSharedPoint
             return EXIT_FAILURE;
         }
 
-        out << QObject::tr("Evaluating database entries against HIBP file, this will take a while…") << endl;
+        if (HibpOffline::isIndex(hibpFile)) {
+            out << QObject::tr("Evaluating database entries against HIBP index…") << endl;
 
-        if (!HibpOffline::report(database, hibpFile, findings, &error)) {
-            err << error << endl;
-            return EXIT_FAILURE;
+            if (!HibpOffline::indexReport(database, hibpFile, findings, &error)) {
+                err << error << endl;
+                return EXIT_FAILURE;
+            }
+        } else {
+            out << QObject::tr("Evaluating database entries against HIBP file, this will take a while…") << endl;
+
+            const bool orderedByHash = parser->isSet(Analyze::HIBPOrderedOption);
+            if (!HibpOffline::report(database, hibpFile, findings, &error, orderedByHash)) {
+                err << error << endl;
+                return EXIT_FAILURE;
+            }
         }
     }
 
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "HibpIndex.h"
+
+#include "Utils.h"
+#include "core/HibpOffline.h"
+
+#include <QCommandLineParser>
+#include <QFile>
+#include <QFileInfo>
+
+HibpIndex::HibpIndex()
+{
+    name = QString("hibp-index");
+    description = QObject::tr("Convert a HIBP file into an index for fast offline checks.");
+    positionalArguments.append({QString("hibp"),
+                                QObject::tr("Path of the file listing SHA-1 hashes of leaked passwords in HIBP format."),
+                                QString("")});
+    positionalArguments.append({QString("index"), QObject::tr("Path of the new index file."), QString("")});
+}
+
+int HibpIndex::execute(const QStringList& arguments)
+{
+    QSharedPointer<QCommandLineParser> parser = getCommandLineParser(arguments);
+    if (parser.isNull()) {
+        return EXIT_FAILURE;
+    }
+
+    auto& out = parser->isSet(Command::QuietOption) ? Utils::DEVNULL : Utils::STDOUT;
+    auto& err = Utils::STDERR;
+
+    const QStringList args = parser->positionalArguments();
+    const QString& hibpPath = args.at(0);
+    const QString& indexPath = args.at(1);
+
+    if (QFileInfo::exists(indexPath)) {
+        err << QObject::tr("File %1 already exists.").arg(indexPath) << endl;
+        return EXIT_FAILURE;
+    }
+
+    QFile hibpFile(hibpPath);
+    if (!hibpFile.open(QFile::ReadOnly)) {
+        err << QObject::tr("Failed to open HIBP file %1: %2").arg(hibpPath, hibpFile.errorString()) << endl;
+        return EXIT_FAILURE;
+    }
+
+    // The index is mapped to sort it, so it must be readable as well
+    QFile indexFile(indexPath);
+    if (!indexFile.open(QFile::ReadWrite)) {
+        err << QObject::tr("Failed to open index file %1: %2").arg(indexPath, indexFile.errorString()) << endl;
+        return EXIT_FAILURE;
+    }
+
+    out << QObject::tr("Converting HIBP file, this will take a while…") << endl;
+
+    QString error;
+    if (!HibpOffline::convertToIndex(hibpFile, indexFile, &error)) {
+        err << error << endl;
+        indexFile.remove();
+        return EXIT_FAILURE;
+    }
+
+    out << QObject::tr("Successfully created HIBP index.") << endl;
+    return EXIT_SUCCESS;
+}
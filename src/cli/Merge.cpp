@@ -87,13 +87,22 @@ int Merge::executeWithDatabase(QSharedPointer<Database> database, QSharedPointer
     }
 
     Merger merger(db2.data(), database.data());
-    QStringList changeList = merger.merge();
+    const Merger::Plan plan = merger.plan();
+    QStringList changeList = merger.merge(plan);
 
     for (auto& mergeChange : changeList) {
         out << "\t" << mergeChange << endl;
     }
 
-    if (!changeList.isEmpty() && !parser->isSet(Merge::DryRunOption)) {
+    if (parser->isSet(Merge::DryRunOption)) {
+        // The changes were only applied to the database in memory, which is never saved
+        out << QObject::tr("Database was not modified by merge operation.") << endl;
+        out << QObject::tr("Entries: %1 missing, %2 differing, %3 identical.")
+                   .arg(plan.count(Merger::CreateEntry))
+                   .arg(plan.count(Merger::UpdateEntry))
+                   .arg(plan.count(Merger::KeepEntry))
+            << endl;
+    } else if (!changeList.isEmpty()) {
         QString errorMessage;
         if (!database->save(Database::Atomic, {}, &errorMessage)) {
             err << QObject::tr("Unable to save database to file : %1").arg(errorMessage) << endl;
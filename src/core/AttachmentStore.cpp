@@ -0,0 +1,296 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AttachmentStore.h"
+
+#include "core/Global.h"
+#include "crypto/CryptoHash.h"
+#include "crypto/Random.h"
+#include "crypto/SymmetricCipher.h"
+
+#include <QDir>
+#include <QTemporaryFile>
+#include <QVector>
+
+#include <algorithm>
+
+const int AttachmentStore::DefaultSpillThreshold = 1024 * 1024;
+
+namespace
+{
+    // Temporary file only readable by the owner, nullptr if it cannot be created
+    QTemporaryFile* createSpillFile()
+    {
+        QScopedPointer<QTemporaryFile> file(new QTemporaryFile(QDir::temp().absoluteFilePath("XXXXXXXXXXXX.tmp")));
+        if (!file->open() || !file->setPermissions(QFile::ReadOwner | QFile::WriteOwner)) {
+            return nullptr;
+        }
+        return file.take();
+    }
+} // namespace
+
+QByteArray AttachmentData::data() const
+{
+    if (!isSpilled()) {
+        return m_data;
+    }
+    return m_store->load(this);
+}
+
+int AttachmentData::size() const
+{
+    return m_size;
+}
+
+/**
+ * @return SHA-256 digest of the data, identifies the content within the store
+ */
+const QByteArray& AttachmentData::hash() const
+{
+    return m_hash;
+}
+
+bool AttachmentData::isSpilled() const
+{
+    return m_spilled;
+}
+
+AttachmentStore::AttachmentStore()
+    : m_spillThreshold(DefaultSpillThreshold)
+{
+}
+
+QSharedPointer<AttachmentStore> AttachmentStore::instance()
+{
+    // Initialized once, even if the first calls come from several threads
+    static const QSharedPointer<AttachmentStore> store = [] {
+        QSharedPointer<AttachmentStore> instance(new AttachmentStore());
+        instance->m_self = instance;
+        return instance;
+    }();
+    return store;
+}
+
+/**
+ * Store attachment data. If the same data is already stored, the existing
+ * instance is returned instead.
+ *
+ * @param data attachment content
+ * @return shared attachment data
+ */
+QSharedPointer<const AttachmentData> AttachmentStore::store(QByteArray data)
+{
+    const QByteArray hash = CryptoHash::hash(data, CryptoHash::Sha256);
+
+    QMutexLocker locker(&m_mutex);
+    QSharedPointer<AttachmentData> attachment = m_attachments.value(hash).toStrongRef();
+    if (attachment) {
+        return attachment;
+    }
+
+    attachment = QSharedPointer<AttachmentData>(new AttachmentData(), &AttachmentStore::release);
+    attachment->m_hash = hash;
+    attachment->m_size = data.size();
+    attachment->m_store = m_self.toStrongRef();
+    if (m_spillThreshold < 0 || data.size() < m_spillThreshold || !spill(attachment.data(), data)) {
+        attachment->m_data = data;
+    }
+    m_attachments.insert(hash, attachment);
+    return attachment;
+}
+
+/**
+ * @return minimum size of data that is moved to the temporary file, -1 if disabled
+ */
+int AttachmentStore::spillThreshold() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spillThreshold;
+}
+
+/**
+ * Set the minimum size of data that is moved to the temporary file.
+ * Only affects data stored afterwards.
+ *
+ * @param bytes minimum size in bytes, -1 to keep all data in memory
+ */
+void AttachmentStore::setSpillThreshold(int bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_spillThreshold = bytes;
+}
+
+/**
+ * @return number of distinct attachment contents currently stored
+ */
+int AttachmentStore::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (auto it = m_attachments.constBegin(); it != m_attachments.constEnd(); ++it) {
+        if (!it.value().isNull()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+/**
+ * @return number of bytes currently held in the temporary file
+ */
+qint64 AttachmentStore::spilledSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spilledSize;
+}
+
+/**
+ * @return size of the temporary file, including the ranges of released data
+ */
+qint64 AttachmentStore::spillFileSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spillFile ? m_spillFile->size() : 0;
+}
+
+bool AttachmentStore::spill(AttachmentData* attachment, const QByteArray& data)
+{
+    if (!m_spillFile) {
+        m_spillFile.reset(createSpillFile());
+        if (!m_spillFile) {
+            return false;
+        }
+        m_spillKey = randomGen()->randomArray(SymmetricCipher::keySize(SymmetricCipher::Aes256_CTR));
+    }
+
+    const QByteArray iv = randomGen()->randomArray(SymmetricCipher::defaultIvSize(SymmetricCipher::Aes256_CTR));
+    QByteArray encrypted = data;
+    SymmetricCipher cipher;
+    if (!cipher.init(SymmetricCipher::Aes256_CTR, SymmetricCipher::Encrypt, m_spillKey, iv)
+        || !cipher.process(encrypted)) {
+        return false;
+    }
+
+    const qint64 offset = m_spillFile->size();
+    if (!m_spillFile->seek(offset) || m_spillFile->write(encrypted) != encrypted.size() || !m_spillFile->flush()) {
+        m_spillFile->resize(offset);
+        return false;
+    }
+
+    attachment->m_spilled = true;
+    attachment->m_offset = offset;
+    attachment->m_iv = iv;
+    m_spilledAttachments.insert(attachment);
+    m_spilledSize += encrypted.size();
+    return true;
+}
+
+QByteArray AttachmentStore::load(const AttachmentData* attachment) const
+{
+    QByteArray data;
+    {
+        QMutexLocker locker(&m_mutex);
+        Q_ASSERT(m_spillFile);
+        uchar* mapped = m_spillFile->map(attachment->m_offset, attachment->m_size);
+        if (mapped) {
+            data = QByteArray(reinterpret_cast<const char*>(mapped), attachment->m_size);
+            m_spillFile->unmap(mapped);
+        } else if (m_spillFile->seek(attachment->m_offset)) {
+            data = m_spillFile->read(attachment->m_size);
+        }
+    }
+
+    SymmetricCipher cipher;
+    if (data.size() != attachment->m_size
+        || !cipher.init(SymmetricCipher::Aes256_CTR, SymmetricCipher::Decrypt, m_spillKey, attachment->m_iv)
+        || !cipher.process(data)) {
+        qWarning("AttachmentStore: unable to read attachment data from temporary file");
+        return {};
+    }
+    return data;
+}
+
+void AttachmentStore::release(AttachmentData* attachment)
+{
+    // Keeps the store alive until the data is gone
+    QSharedPointer<AttachmentStore> store = attachment->m_store;
+    {
+        QMutexLocker locker(&store->m_mutex);
+        // The hash may have been stored again since the last reference was dropped
+        auto it = store->m_attachments.find(attachment->m_hash);
+        if (it != store->m_attachments.end() && it.value().isNull()) {
+            store->m_attachments.erase(it);
+        }
+
+        if (attachment->isSpilled()) {
+            store->m_spilledAttachments.remove(attachment);
+            store->m_spilledSize -= attachment->m_size;
+            if (store->m_spilledSize == 0) {
+                // Everything in the file is unused, start over at the beginning
+                store->m_spillFile->resize(0);
+            } else if (store->m_spillFile->size() - store->m_spilledSize > store->m_spilledSize) {
+                store->compactSpillFile();
+            }
+        }
+    }
+    delete attachment;
+}
+
+/**
+ * Copy the data that is still in use into a new temporary file that replaces
+ * the current one. Called with the mutex locked once the released data
+ * outweighs the data in use, so the file stays at most twice as large.
+ * Offsets only change once every write succeeded, the current file is kept
+ * as it is otherwise.
+ */
+void AttachmentStore::compactSpillFile()
+{
+    QScopedPointer<QTemporaryFile> file(createSpillFile());
+    if (!file) {
+        qWarning("AttachmentStore: unable to compact the temporary file");
+        return;
+    }
+
+    QList<AttachmentData*> attachments = m_spilledAttachments.values();
+    std::sort(attachments.begin(), attachments.end(), [](const AttachmentData* lhs, const AttachmentData* rhs) {
+        return lhs->m_offset < rhs->m_offset;
+    });
+
+    // Data is copied as it is, the IV does not depend on the position
+    QVector<qint64> offsets;
+    offsets.reserve(attachments.size());
+    for (const AttachmentData* attachment : asConst(attachments)) {
+        QByteArray data;
+        if (m_spillFile->seek(attachment->m_offset)) {
+            data = m_spillFile->read(attachment->m_size);
+        }
+        offsets.append(file->pos());
+        if (data.size() != attachment->m_size || file->write(data) != data.size()) {
+            qWarning("AttachmentStore: unable to compact the temporary file");
+            return;
+        }
+    }
+    if (!file->flush()) {
+        qWarning("AttachmentStore: unable to compact the temporary file");
+        return;
+    }
+
+    for (int i = 0; i < attachments.size(); ++i) {
+        attachments[i]->m_offset = offsets.at(i);
+    }
+    m_spillFile.swap(file);
+}
@@ -0,0 +1,107 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_ATTACHMENTSTORE_H
+#define KEEPASSXC_ATTACHMENTSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QScopedPointer>
+#include <QSet>
+#include <QSharedPointer>
+
+class AttachmentStore;
+class QTemporaryFile;
+
+/**
+ * Immutable attachment content, shared by all attachments with the same data.
+ */
+class AttachmentData
+{
+public:
+    QByteArray data() const;
+    int size() const;
+    const QByteArray& hash() const;
+    bool isSpilled() const;
+
+private:
+    AttachmentData() = default;
+    friend class AttachmentStore;
+
+    QByteArray m_hash;
+    QByteArray m_data;
+    int m_size = 0;
+    bool m_spilled = false;
+    // Position in the temporary file, moves when the file is compacted
+    qint64 m_offset = -1;
+    QByteArray m_iv;
+    QSharedPointer<AttachmentStore> m_store;
+};
+
+/**
+ * Deduplicating storage for attachment data.
+ *
+ * Attachments with identical content share a single AttachmentData. Data at or
+ * above the spill threshold is encrypted with a key that only exists in memory
+ * and moved to a temporary file, from which it is mapped and decrypted again
+ * whenever it is read.
+ */
+class AttachmentStore
+{
+public:
+    static QSharedPointer<AttachmentStore> instance();
+
+    QSharedPointer<const AttachmentData> store(QByteArray data);
+
+    int spillThreshold() const;
+    void setSpillThreshold(int bytes);
+    int count() const;
+    qint64 spilledSize() const;
+    qint64 spillFileSize() const;
+
+    static const int DefaultSpillThreshold;
+
+private:
+    AttachmentStore();
+    friend class AttachmentData;
+
+    bool spill(AttachmentData* attachment, const QByteArray& data);
+    QByteArray load(const AttachmentData* attachment) const;
+    static void release(AttachmentData* attachment);
+    void compactSpillFile();
+
+    mutable QMutex m_mutex;
+    QHash<QByteArray, QWeakPointer<AttachmentData>> m_attachments;
+    // Spilled attachments that are alive, removed before they are deleted
+    QSet<AttachmentData*> m_spilledAttachments;
+    QScopedPointer<QTemporaryFile> m_spillFile;
+    QByteArray m_spillKey;
+    qint64 m_spilledSize = 0;
+    int m_spillThreshold;
+
+    QWeakPointer<AttachmentStore> m_self;
+
+    Q_DISABLE_COPY(AttachmentStore)
+};
+
+static inline QSharedPointer<AttachmentStore> attachmentStore()
+{
+    return AttachmentStore::instance();
+}
+
+#endif // KEEPASSXC_ATTACHMENTSTORE_H
@@ -70,6 +70,7 @@ void AutoTypeAssociations::removeEmpty()
         const Association& assoc = i.next();
         if (assoc.window.isEmpty() && assoc.sequence.isEmpty()) {
             i.remove();
+            updateRevision();
         }
     }
 }
@@ -114,6 +115,7 @@ int AutoTypeAssociations::associationsSize() const
 void AutoTypeAssociations::clear()
 {
     m_associations.clear();
+    updateRevision();
 }
 
 bool AutoTypeAssociations::operator==(const AutoTypeAssociations& other) const
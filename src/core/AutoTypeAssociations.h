@@ -50,6 +50,8 @@ public:
     bool operator!=(const AutoTypeAssociations& other) const;
 
 private:
+    friend class EntryHistory;
+
     QList<AutoTypeAssociations::Association> m_associations;
 
 signals:
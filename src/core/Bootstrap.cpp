@@ -17,6 +17,7 @@
 
 #include "Bootstrap.h"
 #include "config-keepassx.h"
+#include "core/Trace.h"
 #include "core/Translator.h"
 
 #ifdef Q_OS_WIN
@@ -73,6 +74,7 @@ namespace Bootstrap
         applyEarlyQNetworkAccessManagerWorkaround();
 
         Translator::installTranslators();
+        Trace::startFromEnvironment();
     }
 
     // LCOV_EXCL_START
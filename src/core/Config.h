@@ -46,6 +46,7 @@ public:
         BackupFilePathPattern,
         UseAtomicSaves,
         UseDirectWriteSaves,
+        PrecomputeDatabaseKey,
         SearchLimitGroup,
         MinimizeOnOpenUrl,
         HideWindowOnCopy,
@@ -67,6 +67,8 @@ private slots:
     void updateLastModified();
 
 private:
+    friend class EntryHistory;
+
     QHash<QString, QString> m_data;
 };
 
@@ -19,8 +19,15 @@
 #include "Database.h"
 
 #include "core/AsyncTask.h"
+#include "core/EntryUrlIndex.h"
 #include "core/FileWatcher.h"
 #include "core/Group.h"
+#include "core/Merger.h"
+#include "core/PasswordHealth.h"
+#include "core/PlaceholderCache.h"
+#include "core/StringInterner.h"
+#include "core/Trace.h"
+#include "format/KdbxXmlFragmentCache.h"
 #include "format/KdbxXmlReader.h"
 #include "format/KeePass2Reader.h"
 #include "format/KeePass2Writer.h"
@@ -39,6 +46,11 @@ Database::Database()
     , m_data()
     , m_rootGroup(nullptr)
     , m_fileWatcher(new FileWatcher(this))
+    , m_placeholderCache(new PlaceholderCache())
+    , m_urlIndex(new EntryUrlIndex())
+    , m_passwordHealthCache(new PasswordHealthCache())
+    , m_xmlFragmentCache(new KdbxXmlFragmentCache())
+    , m_stringInterner(new StringInterner())
     , m_uuid(QUuid::createUuid())
 {
     // setup modified timer
@@ -118,6 +130,7 @@ bool Database::open(QSharedPointer<const CompositeKey> key, QString* error, bool
  */
 bool Database::open(const QString& filePath, QSharedPointer<const CompositeKey> key, QString* error, bool readOnly)
 {
+    Trace::Scope trace("Database::open");
     QFile dbFile(filePath);
     if (!dbFile.exists()) {
         if (error) {
@@ -155,6 +168,7 @@ bool Database::open(const QString& filePath, QSharedPointer<const CompositeKey>
     dbFile.close();
 
     markAsClean();
+    precomputeKey();
 
     emit databaseOpened();
     m_fileWatcher->start(canonicalFilePath(), 30, 1);
@@ -269,6 +283,7 @@ bool Database::saveAs(const QString& filePath, SaveAction action, const QString&
             QFile::setPermissions(realFilePath, QFile::ReadUser | QFile::WriteUser);
         }
         m_fileWatcher->start(realFilePath, 30, 1);
+        precomputeKey();
     } else {
         // Saving failed, don't rewatch file since it does not represent our database
         markAsModified();
@@ -279,6 +294,7 @@ bool Database::saveAs(const QString& filePath, SaveAction action, const QString&
 
 bool Database::performSave(const QString& filePath, SaveAction action, const QString& backupFilePath, QString* error)
 {
+    Trace::Scope trace("Database::performSave");
     if (!backupFilePath.isNull()) {
         backupDatabase(filePath, backupFilePath);
     }
@@ -473,11 +489,15 @@ void Database::releaseData()
 
     m_data.clear();
     m_metadata->clear();
+    precomputeKey();
+    m_offeredKeySource.reset();
+    m_offeredKey.clear();
 
     auto oldGroup = rootGroup();
     setRootGroup(new Group());
     // explicitly delete old group, otherwise it is only deleted when the database object is destructed
     delete oldGroup;
+    m_stringInterner->clear();
 
     m_fileWatcher->stop();
 
@@ -485,6 +505,45 @@ void Database::releaseData()
     m_commonUsernames.clear();
 }
 
+/**
+ * Replace the contents of this database with those of another database in
+ * place, e.g. a new version of this database's file that was opened with the
+ * same key. Only entries and groups that differ are modified, so all pointers
+ * to unchanged items remain valid.
+ *
+ * The modified state is left to the caller.
+ *
+ * @param other database to copy
+ */
+void Database::reloadFrom(const Database* other)
+{
+    Q_ASSERT(other && other != this);
+    Q_ASSERT(other->m_data.key == m_data.key);
+
+    setEmitModified(false);
+
+    Merger merger(other, this);
+    merger.mirror();
+    // Entries were changed without emitting modified signals
+    m_urlIndex->invalidateAll();
+    m_placeholderCache->clear();
+
+    m_data.cipher = other->m_data.cipher;
+    m_data.compressionAlgorithm = other->m_data.compressionAlgorithm;
+    m_data.publicCustomData = other->m_data.publicCustomData;
+    if (other->m_data.key == m_data.key && other->m_data.kdf) {
+        m_data.kdf = other->m_data.kdf->clone();
+        m_data.transformedDatabaseKey->setHash(other->transformedDatabaseKey());
+    }
+
+    if (!m_data.filePath.isEmpty()) {
+        m_fileWatcher->start(canonicalFilePath(), 30, 1);
+    }
+    precomputeKey();
+
+    setEmitModified(true);
+}
+
 /**
  * Remove the old backup and replace it with a new one. Backup name is taken from destinationFilePath.
  * Non-existing parent directories will be created automatically.
@@ -576,8 +635,13 @@ void Database::setRootGroup(Group* group)
         emit databaseDiscarded();
     }
 
+    // The new root group registers its entries with the URL index
+    m_urlIndex->clear();
     m_rootGroup = group;
     m_rootGroup->setParent(this);
+    m_placeholderCache->clear();
+    m_passwordHealthCache->clear();
+    m_xmlFragmentCache->clear();
 }
 
 Metadata* Database::metadata()
@@ -779,8 +843,19 @@ bool Database::setKey(const QSharedPointer<const CompositeKey>& key,
 
     if (!transformKey) {
         transformedDatabaseKey = QByteArray(oldTransformedDatabaseKey.rawKey());
-    } else if (!key->transform(*m_data.kdf, transformedDatabaseKey, &m_keyError)) {
-        return false;
+    } else {
+        const bool reuseOfferedKey = m_offeredKeySource && m_offeredKeySource == key
+                                     && m_offeredKeyKdfParameters == KeePass2::kdfToParameters(m_data.kdf);
+        if (reuseOfferedKey) {
+            transformedDatabaseKey = m_offeredKey;
+        }
+        m_offeredKeySource.reset();
+        m_offeredKeyKdfParameters.clear();
+        m_offeredKey.clear();
+
+        if (!reuseOfferedKey && !key->transform(*m_data.kdf, transformedDatabaseKey, &m_keyError)) {
+            return false;
+        }
     }
 
     m_data.key = key;
@@ -912,6 +987,98 @@ void Database::markNonDataChange()
     m_hasNonDataChange = true;
 }
 
+/**
+ * Find an entry of this database in constant time.
+ *
+ * @param uuid UUID of the entry
+ * @return pointer to the entry or nullptr if it is not part of the database
+ */
+Entry* Database::entryByUuid(const QUuid& uuid) const
+{
+    return m_rootGroup ? m_rootGroup->findEntryByUuid(uuid) : nullptr;
+}
+
+/**
+ * Find a group of this database in constant time.
+ *
+ * @param uuid UUID of the group
+ * @return pointer to the group or nullptr if it is not part of the database
+ */
+Group* Database::groupByUuid(const QUuid& uuid) const
+{
+    return m_rootGroup ? m_rootGroup->findGroupByUuid(uuid) : nullptr;
+}
+
+/**
+ * Cache of resolved placeholders for the entries of this database.
+ * Entries invalidate their cached values when they are modified.
+ */
+PlaceholderCache* Database::placeholderCache() const
+{
+    return m_placeholderCache.data();
+}
+
+/**
+ * Entries of this database by the domains of their URLs, used to find the entries for a site.
+ */
+EntryUrlIndex* Database::urlIndex() const
+{
+    return m_urlIndex.data();
+}
+
+/**
+ * Evaluated passwords of this database, shared by entries and reports.
+ */
+PasswordHealthCache* Database::passwordHealthCache() const
+{
+    return m_passwordHealthCache.data();
+}
+
+/**
+ * Serialized entries of the last save, reused by the next save for unchanged entries.
+ */
+KdbxXmlFragmentCache* Database::xmlFragmentCache() const
+{
+    return m_xmlFragmentCache.data();
+}
+
+/**
+ * Shared copies of the attribute keys, tags and group names of this database.
+ */
+StringInterner* Database::stringInterner() const
+{
+    return m_stringInterner.data();
+}
+
+void Database::registerEntry(Entry* entry)
+{
+    if (!entry->uuid().isNull()) {
+        m_entryIndex.insert(entry->uuid(), entry);
+    }
+    // References may resolve differently now
+    m_placeholderCache->clear();
+    m_urlIndex->invalidate(entry);
+}
+
+void Database::unregisterEntry(Entry* entry, const QUuid& uuid)
+{
+    m_entryIndex.remove(uuid, entry);
+    m_placeholderCache->clear();
+    m_urlIndex->remove(entry);
+}
+
+void Database::registerGroup(Group* group)
+{
+    if (!group->uuid().isNull()) {
+        m_groupIndex.insert(group->uuid(), group);
+    }
+}
+
+void Database::unregisterGroup(Group* group, const QUuid& uuid)
+{
+    m_groupIndex.remove(uuid, group);
+}
+
 /**
  * @param uuid UUID of the database
  * @return pointer to the database or nullptr if no such database exists
@@ -957,6 +1124,114 @@ bool Database::changeKdf(const QSharedPointer<Kdf>& kdf)
     return true;
 }
 
+/**
+ * Randomize the KDF seed and transform the key with it, this has to be done
+ * before every write of the database.
+ *
+ * If key precomputation is enabled and a transformed key for a fresh seed is
+ * available for the current key and KDF parameters, it is used instead of
+ * running the KDF again.
+ *
+ * @return true on success
+ */
+bool Database::rotateTransformSeed()
+{
+    QFuture<PrecomputedKey> precomputedKey;
+    bool hasPrecomputedKey = false;
+    {
+        QMutexLocker locker(&m_precomputedKeyMutex);
+        if (m_precomputedKeySource && m_precomputedKeySource == m_data.key && m_data.kdf
+            && m_precomputedKeyKdfParameters == KeePass2::kdfToParameters(m_data.kdf)) {
+            precomputedKey = m_precomputedKey;
+            hasPrecomputedKey = true;
+        }
+        m_precomputedKey = QFuture<PrecomputedKey>();
+        m_precomputedKeySource.reset();
+        m_precomputedKeyKdfParameters.clear();
+    }
+
+    if (hasPrecomputedKey) {
+        // Waiting for a running computation is never slower than starting over
+        auto result = precomputedKey.result();
+        if (result.ok && m_data.kdf->setSeed(result.seed)) {
+            m_keyError.clear();
+            m_data.transformedDatabaseKey->setHash(result.transformedDatabaseKey);
+            markAsModified();
+            return true;
+        }
+    }
+
+    return setKey(m_data.key, false, true);
+}
+
+/**
+ * Offer the transformed key of another database to the next key transformation,
+ * e.g. when reading a new version of the same file. The offered key is only used
+ * if the composite key and all KDF parameters, including the seed, are identical.
+ *
+ * @param other database to take the transformed key from
+ */
+void Database::offerTransformedKey(const Database* other)
+{
+    m_offeredKeySource.reset();
+    m_offeredKeyKdfParameters.clear();
+    m_offeredKey.clear();
+
+    if (!other || !other->m_data.key || !other->m_data.kdf) {
+        return;
+    }
+
+    m_offeredKeySource = other->m_data.key;
+    m_offeredKeyKdfParameters = KeePass2::kdfToParameters(other->m_data.kdf);
+    m_offeredKey = other->transformedDatabaseKey();
+}
+
+bool Database::isKeyPrecomputationEnabled() const
+{
+    return m_precomputeKey;
+}
+
+/**
+ * Transform the key with the next KDF seed in the background after every
+ * unlock and save, so saving does not have to wait for the KDF.
+ *
+ * @param enabled true to precompute the key for the next save
+ */
+void Database::setKeyPrecomputationEnabled(bool enabled)
+{
+    if (m_precomputeKey != enabled) {
+        m_precomputeKey = enabled;
+        precomputeKey();
+    }
+}
+
+void Database::precomputeKey()
+{
+    QMutexLocker locker(&m_precomputedKeyMutex);
+    m_precomputedKey = QFuture<PrecomputedKey>();
+    m_precomputedKeySource.reset();
+    m_precomputedKeyKdfParameters.clear();
+
+    // Challenge-response keys would prompt for the hardware key in the background
+    if (!m_precomputeKey || !m_data.key || m_data.key->isEmpty() || !m_data.key->challengeResponseKeys().isEmpty()
+        || !m_data.kdf) {
+        return;
+    }
+
+    auto key = m_data.key;
+    auto kdf = m_data.kdf->clone();
+    kdf->randomizeSeed();
+
+    m_precomputedKeySource = key;
+    m_precomputedKeyKdfParameters = KeePass2::kdfToParameters(m_data.kdf);
+    m_precomputedKey = QtConcurrent::run([key, kdf] {
+        PrecomputedKey result;
+        result.seed = kdf->seed();
+        result.ok = key->transform(*kdf, result.transformedDatabaseKey);
+        return result;
+    });
+}
+
 // Prevent warning about QTimer not allowed to be started/stopped from other thread
 void Database::startModifiedTimer()
 {
@@ -20,7 +20,9 @@
 #define KEEPASSX_DATABASE_H
 
 #include <QDateTime>
+#include <QFuture>
 #include <QHash>
+#include <QMultiHash>
 #include <QMutex>
 #include <QPointer>
 #include <QTimer>
@@ -37,6 +39,11 @@ enum class EntryReferenceType;
 class FileWatcher;
 class Group;
 class Metadata;
+class KdbxXmlFragmentCache;
+class PasswordHealthCache;
+class PlaceholderCache;
+class StringInterner;
+class EntryUrlIndex;
 class QIODevice;
 
 struct DeletedObject
@@ -88,6 +95,7 @@ public:
     bool import(const QString& xmlExportPath, QString* error = nullptr);
 
     void releaseData();
+    void reloadFrom(const Database* other);
 
     bool isInitialized() const;
     bool isModified() const;
@@ -140,6 +148,18 @@ public:
     void setKdf(QSharedPointer<Kdf> kdf);
     bool changeKdf(const QSharedPointer<Kdf>& kdf);
     QByteArray transformedDatabaseKey() const;
+    bool rotateTransformSeed();
+    void offerTransformedKey(const Database* other);
+    bool isKeyPrecomputationEnabled() const;
+    void setKeyPrecomputationEnabled(bool enabled);
+
+    Entry* entryByUuid(const QUuid& uuid) const;
+    Group* groupByUuid(const QUuid& uuid) const;
+    PlaceholderCache* placeholderCache() const;
+    EntryUrlIndex* urlIndex() const;
+    PasswordHealthCache* passwordHealthCache() const;
+    KdbxXmlFragmentCache* xmlFragmentCache() const;
+    StringInterner* stringInterner() const;
 
     static Database* databaseByUuid(const QUuid& uuid);
 
@@ -203,7 +223,15 @@ private:
         }
     };
 
+    struct PrecomputedKey
+    {
+        QByteArray seed;
+        QByteArray transformedDatabaseKey;
+        bool ok = false;
+    };
+
     void createRecycleBin();
+    void precomputeKey();
 
     bool writeDatabase(QIODevice* device, QString* error = nullptr);
     bool backupDatabase(const QString& filePath, const QString& destinationFilePath);
@@ -212,6 +240,11 @@ private:
     void startModifiedTimer();
     void stopModifiedTimer();
 
+    void registerEntry(Entry* entry);
+    void unregisterEntry(Entry* entry, const QUuid& uuid);
+    void registerGroup(Group* group);
+    void unregisterGroup(Group* group, const QUuid& uuid);
+
     QPointer<Metadata> const m_metadata;
     DatabaseData m_data;
     QPointer<Group> m_rootGroup;
@@ -225,8 +258,32 @@ private:
 
     QList<QString> m_commonUsernames;
 
+    // Entries and groups of this database indexed by their uuid, maintained by Group and Entry
+    QMultiHash<QUuid, Entry*> m_entryIndex;
+    QMultiHash<QUuid, Group*> m_groupIndex;
+    QScopedPointer<PlaceholderCache> m_placeholderCache;
+    QScopedPointer<EntryUrlIndex> m_urlIndex;
+    QScopedPointer<PasswordHealthCache> m_passwordHealthCache;
+    QScopedPointer<KdbxXmlFragmentCache> m_xmlFragmentCache;
+    QScopedPointer<StringInterner> m_stringInterner;
+
+    // Transformed key for the next save, only valid for the key and KDF parameters it was computed from
+    bool m_precomputeKey = false;
+    QMutex m_precomputedKeyMutex;
+    QFuture<PrecomputedKey> m_precomputedKey;
+    QSharedPointer<const CompositeKey> m_precomputedKeySource;
+    QVariantMap m_precomputedKeyKdfParameters;
+
+    // Transformed key of another database that may be reused by the next setKey()
+    QSharedPointer<const CompositeKey> m_offeredKeySource;
+    QVariantMap m_offeredKeyKdfParameters;
+    QByteArray m_offeredKey;
+
     QUuid m_uuid;
     static QHash<QUuid, QPointer<Database>> s_uuidMap;
+
+    friend class Entry;
+    friend class Group;
 };
 
 #endif // KEEPASSX_DATABASE_H
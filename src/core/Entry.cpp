@@ -20,9 +20,12 @@
 
 #include "core/Config.h"
 #include "core/DatabaseIcons.h"
+#include "core/EntryHistory.h"
+#include "core/EntryUrlIndex.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
 #include "core/PasswordHealth.h"
+#include "core/PlaceholderCache.h"
 #include "core/Tools.h"
 #include "totp/totp.h"
 
@@ -30,6 +33,19 @@
 #include <QRegularExpression>
 #include <QUrl>
 
+namespace
+{
+    // Collects what the placeholder resolution running on this thread depends on
+    struct PlaceholderResolution
+    {
+        QSet<const Entry*> dependencies;
+        bool dependsOnAll = false;
+        bool cacheable = true;
+    };
+
+    thread_local PlaceholderResolution* t_resolution = nullptr;
+} // namespace
+
 const int Entry::DefaultIconNumber = 0;
 const int Entry::ResolveMaximumDepth = 10;
 const QString Entry::AutoTypeSequenceUsername = "{USERNAME}{ENTER}";
@@ -56,6 +72,8 @@ Entry::Entry()
 
     connect(this, &Entry::modified, this, &Entry::updateTimeinfo);
     connect(this, &Entry::modified, this, &Entry::updateModifiedSinceBegin);
+    connect(this, &Entry::modified, this, &Entry::invalidatePlaceholderCache);
+    connect(this, &Entry::modified, this, &Entry::invalidateUrlIndex);
 }
 
 Entry::~Entry()
@@ -246,7 +264,10 @@ QString Entry::defaultAutoTypeSequence() const
 const QSharedPointer<PasswordHealth>& Entry::passwordHealth()
 {
     if (!m_data.passwordHealth) {
-        m_data.passwordHealth.reset(new PasswordHealth(resolvePlaceholder(password())));
+        const auto pwd = resolvePlaceholder(password());
+        const auto db = database();
+        m_data.passwordHealth.reset(db ? new PasswordHealth(db->passwordHealthCache()->entropy(pwd))
+                                       : new PasswordHealth(pwd));
     }
     return m_data.passwordHealth;
 }
@@ -331,9 +352,11 @@ QList<QString> Entry::autoTypeSequences(const QString& windowTitle) const
             return true;
         }
 
-        QUrl url(entryUrl);
-        if (url.isValid() && !url.host().isEmpty()) {
-            return windowTitle.contains(url.host(), Qt::CaseInsensitive);
+        // Only URLs with placeholders need to be parsed again
+        const EntryUrl parsedUrl =
+            entryUrl == url() ? m_attributes->parsedUrl(EntryAttributes::URLKey) : EntryUrl(entryUrl);
+        if (parsedUrl.hasScheme() && parsedUrl.url().isValid() && !parsedUrl.host().isEmpty()) {
+            return windowTitle.contains(parsedUrl.host(), Qt::CaseInsensitive);
         }
 
         return false;
@@ -598,7 +621,20 @@ QString Entry::path() const
 void Entry::setUuid(const QUuid& uuid)
 {
     Q_ASSERT(!uuid.isNull());
-    set(m_uuid, uuid);
+    if (m_uuid == uuid) {
+        return;
+    }
+
+    // Keep the uuid index of the database current
+    Database* db = database();
+    if (db) {
+        db->unregisterEntry(this, m_uuid);
+    }
+    m_uuid = uuid;
+    if (db) {
+        db->registerEntry(this);
+    }
+    emitModified();
 }
 
 void Entry::setIcon(int iconNumber)
@@ -650,6 +686,7 @@ void Entry::setTags(const QString& tags)
 void Entry::setTimeInfo(const TimeInfo& timeInfo)
 {
     m_data.timeInfo = timeInfo;
+    updateRevision();
 }
 
 void Entry::setAutoTypeEnabled(bool enable)
@@ -727,20 +764,115 @@ void Entry::setExpiryTime(const QDateTime& dateTime)
     }
 }
 
+/**
+ * A compact history is materialized on the first call and stays so until
+ * compactHistory() is called. Use readHistoryItems() to only read the items.
+ */
 QList<Entry*> Entry::historyItems()
 {
+    materializeHistory();
     return m_history;
 }
 
+/**
+ * Despite being const, this materializes a compact history like the non-const
+ * overload does. The switch is guarded, so the const history methods may be
+ * called from several threads at once, e.g. by the merge plan, the health check
+ * and searches. Prefer readHistoryItems(), which leaves a compact history as is.
+ * Methods that change the history must not run at the same time.
+ */
 const QList<Entry*>& Entry::historyItems() const
 {
+    materializeHistory();
     return m_history;
 }
 
+/**
+ * Pass the history items to a function without materializing a compact history.
+ * Compact items are expanded into temporary entries that only live for the call.
+ */
+void Entry::readHistoryItems(const std::function<void(const QList<Entry*>&)>& reader) const
+{
+    QList<Entry*> items;
+    bool temporary = false;
+    {
+        QMutexLocker locker(&m_historyMutex);
+        temporary = !m_compactHistory.isNull();
+        items = temporary ? m_compactHistory->materialize(m_uuid) : m_history;
+    }
+
+    reader(items);
+    if (temporary) {
+        qDeleteAll(items);
+    }
+}
+
+void Entry::materializeHistory() const
+{
+    QMutexLocker locker(&m_historyMutex);
+    if (m_compactHistory) {
+        Q_ASSERT(m_history.isEmpty());
+        m_history = m_compactHistory->materialize(m_uuid);
+        m_compactHistory.reset();
+    }
+}
+
+/**
+ * Keep the history in the compact form of EntryHistory until historyItems() is
+ * called again. Pointers returned by historyItems() become invalid.
+ */
+void Entry::compactHistory()
+{
+    if (m_history.isEmpty()) {
+        return;
+    }
+
+    auto* history = new EntryHistory();
+    for (const Entry* item : asConst(m_history)) {
+        history->append(item);
+    }
+    qDeleteAll(m_history);
+    m_history.clear();
+    m_compactHistory.reset(history);
+
+    // The saved fragment of the entry refers to the revisions of the deleted items
+    updateRevision();
+}
+
+/**
+ * Replace the history with a compact one, the entry takes ownership of it.
+ * Readers use this to keep history items from ever becoming entries while loading.
+ */
+void Entry::setCompactHistory(EntryHistory* history)
+{
+    QScopedPointer<EntryHistory> compact(history);
+    if (compact && compact->isEmpty()) {
+        compact.reset();
+    }
+    qDeleteAll(m_history);
+    m_history.clear();
+    m_compactHistory.swap(compact);
+
+    updateRevision();
+}
+
+bool Entry::hasCompactHistory() const
+{
+    QMutexLocker locker(&m_historyMutex);
+    return !m_compactHistory.isNull();
+}
+
+int Entry::historyItemCount() const
+{
+    QMutexLocker locker(&m_historyMutex);
+    return m_compactHistory ? m_compactHistory->size() : m_history.size();
+}
+
 void Entry::addHistoryItem(Entry* entry)
 {
     Q_ASSERT(!entry->parent());
 
+    materializeHistory();
     m_history.append(entry);
     emitModified();
 }
@@ -751,6 +883,7 @@ void Entry::removeHistoryItems(const QList<Entry*>& historyEntries)
         return;
     }
 
+    materializeHistory();
     for (Entry* entry : historyEntries) {
         Q_ASSERT(!entry->parent());
         Q_ASSERT(entry->uuid().isNull() || entry->uuid() == uuid());
@@ -773,6 +906,14 @@ void Entry::truncateHistory()
 
     bool changed = false;
     int histMaxItems = db->metadata()->historyMaxItems();
+    int histMaxSize = db->metadata()->historyMaxSize();
+    if (m_compactHistory) {
+        if (m_compactHistory->truncate(histMaxItems, histMaxSize)) {
+            emitModified();
+        }
+        return;
+    }
+
     if (histMaxItems > -1) {
         int historyCount = 0;
         QMutableListIterator<Entry*> i(m_history);
@@ -788,10 +929,8 @@ void Entry::truncateHistory()
         }
     }
 
-    int histMaxSize = db->metadata()->historyMaxSize();
     if (histMaxSize > -1) {
         int size = 0;
-        QSet<QByteArray> foundAttachments = attachments()->values();
 
         QMutableListIterator<Entry*> i(m_history);
         i.toBack();
@@ -801,7 +940,6 @@ void Entry::truncateHistory()
             // don't calculate size if it's already above the maximum
             if (size <= histMaxSize) {
                 size += historyItem->size();
-                foundAttachments += historyItem->attachments()->values();
             }
 
             if (size > histMaxSize) {
@@ -841,14 +979,18 @@ bool Entry::equals(const Entry* other, CompareItemOptions options) const
         return false;
     }
     if (!options.testFlag(CompareItemIgnoreHistory)) {
-        if (m_history.count() != other->m_history.count()) {
+        if (historyItemCount() != other->historyItemCount()) {
             return false;
         }
-        for (int i = 0; i < m_history.count(); ++i) {
-            if (!m_history[i]->equals(other->m_history[i], options)) {
-                return false;
-            }
-        }
+        bool historyEquals = true;
+        readHistoryItems([&](const QList<Entry*>& history) {
+            other->readHistoryItems([&](const QList<Entry*>& otherHistory) {
+                for (int i = 0; i < history.count() && historyEquals; ++i) {
+                    historyEquals = history[i]->equals(otherHistory[i], options);
+                }
+            });
+        });
+        return historyEquals;
     }
     return true;
 }
@@ -881,13 +1023,26 @@ Entry* Entry::clone(CloneFlags flags) const
 
     entry->m_autoTypeAssociations->copyDataFrom(m_autoTypeAssociations);
     if (flags & CloneIncludeHistory) {
-        for (Entry* historyItem : m_history) {
-            Entry* historyItemClone =
-                historyItem->clone(flags & ~CloneIncludeHistory & ~CloneNewUuid & ~CloneResetTimeInfo);
-            historyItemClone->setUpdateTimeinfo(false);
-            historyItemClone->setUuid(entry->uuid());
-            historyItemClone->setUpdateTimeinfo(true);
-            entry->addHistoryItem(historyItemClone);
+        const CloneFlags historyFlags = flags & ~CloneIncludeHistory & ~CloneNewUuid & ~CloneResetTimeInfo;
+        EntryHistory* compactHistory = nullptr;
+        if (historyFlags == CloneNoFlags) {
+            // Compact items take the uuid of their entry, so they are copied as they are
+            QMutexLocker locker(&m_historyMutex);
+            compactHistory = m_compactHistory ? new EntryHistory(*m_compactHistory) : nullptr;
+        }
+        if (compactHistory) {
+            entry->m_compactHistory.reset(compactHistory);
+        } else {
+            readHistoryItems([entry, historyFlags](const QList<Entry*>& history) {
+                for (Entry* historyItem : history) {
+                    Entry* historyItemClone = historyItem->clone(historyFlags);
+                    historyItemClone->setUpdateTimeinfo(false);
+                    historyItemClone->setUuid(entry->uuid());
+                    historyItemClone->setUpdateTimeinfo(true);
+                    entry->addHistoryItem(historyItemClone);
+                }
+            });
+            entry->compactHistory();
         }
     }
 
@@ -912,11 +1067,13 @@ void Entry::copyDataFrom(const Entry* other)
 {
     setUpdateTimeinfo(false);
     m_data = other->m_data;
+    updateRevision();
     m_customData->copyDataFrom(other->m_customData);
     m_attributes->copyDataFrom(other->m_attributes);
     m_attachments->copyDataFrom(other->m_attachments);
     m_autoTypeAssociations->copyDataFrom(other->m_autoTypeAssociations);
     setUpdateTimeinfo(true);
+    emitDataChanged();
 }
 
 void Entry::beginUpdate()
@@ -939,7 +1096,16 @@ bool Entry::endUpdate()
     Q_ASSERT(!m_tmpHistoryItem.isNull());
     if (m_modifiedSinceBegin) {
         m_tmpHistoryItem->setUpdateTimeinfo(true);
-        addHistoryItem(m_tmpHistoryItem.take());
+        if (m_history.isEmpty()) {
+            // Nobody holds pointers to history items, keep the new one compact
+            if (!m_compactHistory) {
+                m_compactHistory.reset(new EntryHistory());
+            }
+            m_compactHistory->append(m_tmpHistoryItem.data());
+            emitModified();
+        } else {
+            addHistoryItem(m_tmpHistoryItem.take());
+        }
         truncateHistory();
     }
 
@@ -953,6 +1119,22 @@ void Entry::updateModifiedSinceBegin()
     m_modifiedSinceBegin = true;
 }
 
+void Entry::invalidatePlaceholderCache()
+{
+    const Database* db = database();
+    if (db) {
+        db->placeholderCache()->invalidate(this);
+    }
+}
+
+void Entry::invalidateUrlIndex()
+{
+    Database* db = database();
+    if (db) {
+        db->urlIndex()->invalidate(this);
+    }
+}
+
 QString Entry::resolveMultiplePlaceholdersRecursive(const QString& str, int maxDepth) const
 {
     if (maxDepth <= 0) {
@@ -1015,6 +1197,9 @@ QString Entry::resolvePlaceholderRecursive(const QString& placeholder, int maxDe
         }
         return resolveMultiplePlaceholdersRecursive(url(), maxDepth - 1);
     case PlaceholderType::DbDir: {
+        if (t_resolution) {
+            t_resolution->cacheable = false;
+        }
         QFileInfo fileInfo(database()->filePath());
         return fileInfo.absoluteDir().absolutePath();
     }
@@ -1032,6 +1217,9 @@ QString Entry::resolvePlaceholderRecursive(const QString& placeholder, int maxDe
         return resolveUrlPlaceholder(strUrl, typeOfPlaceholder);
     }
     case PlaceholderType::Totp:
+        if (t_resolution) {
+            t_resolution->cacheable = false;
+        }
         // totp can't have placeholder inside
         return totp();
     case PlaceholderType::CustomAttribute: {
@@ -1054,6 +1242,9 @@ QString Entry::resolvePlaceholderRecursive(const QString& placeholder, int maxDe
     case PlaceholderType::DateTimeUtcHour:
     case PlaceholderType::DateTimeUtcMinute:
     case PlaceholderType::DateTimeUtcSecond:
+        if (t_resolution) {
+            t_resolution->cacheable = false;
+        }
         return resolveMultiplePlaceholdersRecursive(resolveDateTimePlaceholder(typeOfPlaceholder), maxDepth - 1);
     }
 
@@ -1143,6 +1334,16 @@ QString Entry::resolveReferencePlaceholderRecursive(const QString& placeholder,
     Q_ASSERT(m_group->database());
     const Entry* refEntry = m_group->database()->rootGroup()->findEntryBySearchTerm(searchText, searchInType);
 
+    if (t_resolution) {
+        // Entries found by uuid only change through their own modification, any other
+        // search may find a different entry whenever an entry changes
+        if (searchInType != EntryReferenceType::QUuid) {
+            t_resolution->dependsOnAll = true;
+        } else if (refEntry) {
+            t_resolution->dependencies.insert(refEntry);
+        }
+    }
+
     if (refEntry) {
         const QString wantedField = match.captured(EntryAttributes::WantedFieldGroupName);
         result = refEntry->referenceFieldValue(Entry::referenceType(wantedField));
@@ -1217,7 +1418,8 @@ void Entry::setGroup(Group* group)
             // copy custom icon to the new database
             if (!iconUuid().isNull() && group->database() && m_group->database()->metadata()->hasCustomIcon(iconUuid())
                 && !group->database()->metadata()->hasCustomIcon(iconUuid())) {
-                group->database()->metadata()->addCustomIcon(iconUuid(), icon());
+                group->database()->metadata()->addCustomIcon(
+                    iconUuid(), m_group->database()->metadata()->customIconData(iconUuid()));
             }
         }
     }
@@ -1229,6 +1431,7 @@ void Entry::setGroup(Group* group)
 
     if (m_updateTimeinfo) {
         m_data.timeInfo.setLocationChanged(Clock::currentDateTimeUtc());
+        updateRevision();
     }
 }
 
@@ -1276,12 +1479,46 @@ Entry* Entry::resolveReference(const QString& str) const
 
 QString Entry::resolveMultiplePlaceholders(const QString& str) const
 {
-    return resolveMultiplePlaceholdersRecursive(str, ResolveMaximumDepth);
+    return resolveCachedPlaceholders(str, true);
 }
 
 QString Entry::resolvePlaceholder(const QString& placeholder) const
 {
-    return resolvePlaceholderRecursive(placeholder, ResolveMaximumDepth);
+    return resolveCachedPlaceholders(placeholder, false);
+}
+
+QString Entry::resolveCachedPlaceholders(const QString& str, bool multiple) const
+{
+    // Nothing to resolve, this is by far the most common case
+    if (!str.contains(QLatin1Char('{'))) {
+        return str;
+    }
+
+    // Nested resolutions are part of the outer one and not cached on their own
+    const Database* db = database();
+    if (!db || t_resolution) {
+        return multiple ? resolveMultiplePlaceholdersRecursive(str, ResolveMaximumDepth)
+                        : resolvePlaceholderRecursive(str, ResolveMaximumDepth);
+    }
+
+    auto cache = db->placeholderCache();
+    QString result;
+    if (cache->value(this, str, multiple, result)) {
+        return result;
+    }
+
+    const quint64 generation = cache->generation();
+    PlaceholderResolution resolution;
+    resolution.dependencies.insert(this);
+    t_resolution = &resolution;
+    result = multiple ? resolveMultiplePlaceholdersRecursive(str, ResolveMaximumDepth)
+                      : resolvePlaceholderRecursive(str, ResolveMaximumDepth);
+    t_resolution = nullptr;
+
+    if (resolution.cacheable) {
+        cache->insert(this, str, multiple, result, resolution.dependencies, resolution.dependsOnAll, generation);
+    }
+    return result;
 }
 
 QString Entry::resolveUrlPlaceholder(const QString& str, Entry::PlaceholderType placeholderType) const
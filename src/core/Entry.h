@@ -20,9 +20,12 @@
 #define KEEPASSX_ENTRY_H
 
 #include <QImage>
+#include <QMutex>
 #include <QPointer>
 #include <QUuid>
 
+#include <functional>
+
 #include "core/AutoTypeAssociations.h"
 #include "core/CustomData.h"
 #include "core/EntryAttachments.h"
@@ -31,6 +34,7 @@
 #include "core/TimeInfo.h"
 
 class Database;
+class EntryHistory;
 class Group;
 class PasswordHealth;
 
@@ -151,9 +155,13 @@ public:
 
     QList<Entry*> historyItems();
     const QList<Entry*>& historyItems() const;
+    void readHistoryItems(const std::function<void(const QList<Entry*>&)>& reader) const;
     void addHistoryItem(Entry* entry);
     void removeHistoryItems(const QList<Entry*>& historyEntries);
     void truncateHistory();
+    void compactHistory();
+    void setCompactHistory(EntryHistory* history);
+    bool hasCompactHistory() const;
 
     bool equals(const Entry* other, CompareItemOptions options = CompareItemDefault) const;
 
@@ -262,8 +270,11 @@ private slots:
     void updateTimeinfo();
     void updateModifiedSinceBegin();
     void updateTotp();
+    void invalidatePlaceholderCache();
+    void invalidateUrlIndex();
 
 private:
+    QString resolveCachedPlaceholders(const QString& str, bool multiple) const;
     QString resolveMultiplePlaceholdersRecursive(const QString& str, int maxDepth) const;
     QString resolvePlaceholderRecursive(const QString& placeholder, int maxDepth) const;
     QString resolveReferencePlaceholderRecursive(const QString& placeholder, int maxDepth) const;
@@ -274,13 +285,22 @@ private:
 
     template <class T> bool set(T& property, const T& value);
 
+    void materializeHistory() const;
+    int historyItemCount() const;
+
+    friend class EntryHistory;
+
     QUuid m_uuid;
     EntryData m_data;
     QPointer<EntryAttributes> m_attributes;
     QPointer<EntryAttachments> m_attachments;
     QPointer<AutoTypeAssociations> m_autoTypeAssociations;
     QPointer<CustomData> m_customData;
-    QList<Entry*> m_history; // Items sorted from oldest to newest
+    // Either the history items or their compact form, the other one is empty
+    mutable QList<Entry*> m_history; // Items sorted from oldest to newest
+    mutable QScopedPointer<EntryHistory> m_compactHistory;
+    // Guards the switch from the compact to the expanded history in const methods
+    mutable QMutex m_historyMutex;
 
     QScopedPointer<Entry> m_tmpHistoryItem;
     bool m_modifiedSinceBegin;
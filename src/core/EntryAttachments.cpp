@@ -49,16 +49,38 @@ bool EntryAttachments::hasKey(const QString& key) const
 
 QSet<QByteArray> EntryAttachments::values() const
 {
-    return asConst(m_attachments).values().toSet();
+    QSet<QByteArray> values;
+    for (const auto& data : m_attachments) {
+        values.insert(data->data());
+    }
+    return values;
 }
 
 QByteArray EntryAttachments::value(const QString& key) const
+{
+    const auto data = m_attachments.value(key);
+    return data ? data->data() : QByteArray();
+}
+
+/**
+ * Access the stored data of an attachment without reading its content.
+ *
+ * @param key attachment name
+ * @return attachment data or nullptr if there is no such attachment
+ */
+QSharedPointer<const AttachmentData> EntryAttachments::attachmentData(const QString& key) const
 {
     return m_attachments.value(key);
 }
 
 void EntryAttachments::set(const QString& key, const QByteArray& value)
 {
+    set(key, attachmentStore()->store(value));
+}
+
+void EntryAttachments::set(const QString& key, const QSharedPointer<const AttachmentData>& data)
+{
+    Q_ASSERT(data);
     bool shouldEmitModified = false;
     bool addAttachment = !m_attachments.contains(key);
 
@@ -66,8 +88,8 @@ void EntryAttachments::set(const QString& key, const QByteArray& value)
         emit aboutToBeAdded(key);
     }
 
-    if (addAttachment || m_attachments.value(key) != value) {
-        m_attachments.insert(key, value);
+    if (addAttachment || m_attachments.value(key) != data) {
+        m_attachments.insert(key, data);
         shouldEmitModified = true;
     }
 
@@ -125,9 +147,9 @@ void EntryAttachments::remove(const QStringList& keys)
 
 void EntryAttachments::rename(const QString& key, const QString& newKey)
 {
-    const QByteArray val = value(key);
+    const auto data = attachmentData(key);
     remove(key);
-    set(newKey, val);
+    set(newKey, data);
 }
 
 bool EntryAttachments::isEmpty() const
@@ -207,7 +229,7 @@ int EntryAttachments::attachmentsSize() const
 {
     int size = 0;
     for (auto it = m_attachments.constBegin(); it != m_attachments.constEnd(); ++it) {
-        size += it.key().toUtf8().size() + it.value().size();
+        size += it.key().toUtf8().size() + it.value()->size();
     }
     return size;
 }
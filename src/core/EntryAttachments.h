@@ -18,6 +18,7 @@
 #ifndef KEEPASSX_ENTRYATTACHMENTS_H
 #define KEEPASSX_ENTRYATTACHMENTS_H
 
+#include "core/AttachmentStore.h"
 #include "core/FileWatcher.h"
 #include "core/ModifiableObject.h"
 
@@ -39,7 +40,9 @@ public:
     bool hasKey(const QString& key) const;
     QSet<QByteArray> values() const;
     QByteArray value(const QString& key) const;
+    QSharedPointer<const AttachmentData> attachmentData(const QString& key) const;
     void set(const QString& key, const QByteArray& value);
+    void set(const QString& key, const QSharedPointer<const AttachmentData>& data);
     void remove(const QString& key);
     void remove(const QStringList& keys);
     void rename(const QString& key, const QString& newKey);
@@ -65,9 +68,12 @@ private slots:
     void attachmentFileModified(const QString& path);
 
 private:
+    friend class EntryHistory;
+
     void disconnectAndEraseExternalFile(const QString& path);
 
-    QMap<QString, QByteArray> m_attachments;
+    // Attachments with the same content share their data, so comparing the pointers compares the content
+    QMap<QString, QSharedPointer<const AttachmentData>> m_attachments;
     QHash<QString, QString> m_openedAttachments;
     QHash<QString, QString> m_openedAttachmentsInverse;
     QHash<QString, QSharedPointer<FileWatcher>> m_attachmentFileWatchers;
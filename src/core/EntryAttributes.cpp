@@ -18,7 +18,10 @@
 
 #include "EntryAttributes.h"
 
+#include "core/Database.h"
+#include "core/Entry.h"
 #include "core/Global.h"
+#include "core/StringInterner.h"
 
 #include <QRegularExpression>
 #include <QUuid>
@@ -118,7 +121,9 @@ void EntryAttributes::set(const QString& key, const QString& value, bool protect
     }
 
     if (addAttribute || changeValue) {
-        m_attributes.insert(key, value);
+        StringInterner* interner = stringInterner();
+        m_attributes.insert(interner ? interner->intern(key) : key, value);
+        invalidateParsedUrls(key);
         shouldEmitModified = true;
     }
 
@@ -144,6 +149,16 @@ void EntryAttributes::set(const QString& key, const QString& value, bool protect
     }
 }
 
+/**
+ * @return the string interner of the database of the entry, if any
+ */
+StringInterner* EntryAttributes::stringInterner() const
+{
+    auto entry = qobject_cast<Entry*>(parent());
+    Database* db = entry ? entry->database() : nullptr;
+    return db ? db->stringInterner() : nullptr;
+}
+
 void EntryAttributes::remove(const QString& key)
 {
     Q_ASSERT(!isDefaultAttribute(key));
@@ -156,6 +171,7 @@ void EntryAttributes::remove(const QString& key)
 
     m_attributes.remove(key);
     m_protectedAttributes.remove(key);
+    invalidateParsedUrls(key);
 
     emit removed(key);
     emitModified();
@@ -183,6 +199,8 @@ void EntryAttributes::rename(const QString& oldKey, const QString& newKey)
 
     m_attributes.remove(oldKey);
     m_attributes.insert(newKey, data);
+    invalidateParsedUrls(oldKey);
+    invalidateParsedUrls(newKey);
     if (protect) {
         m_protectedAttributes.remove(oldKey);
         m_protectedAttributes.insert(newKey);
@@ -218,6 +236,7 @@ void EntryAttributes::copyCustomKeysFrom(const EntryAttributes* other)
             }
         }
     }
+    invalidateParsedUrls();
 
     emit reset();
     emitModified();
@@ -251,6 +270,7 @@ void EntryAttributes::copyDataFrom(const EntryAttributes* other)
 
         m_attributes = other->m_attributes;
         m_protectedAttributes = other->m_protectedAttributes;
+        invalidateParsedUrls();
 
         emit reset();
         emitModified();
@@ -275,6 +295,33 @@ QUuid EntryAttributes::referenceUuid(const QString& key) const
     return {};
 }
 
+/**
+ * Value of an attribute parsed as URL. The value is parsed once and
+ * reused until the attribute changes.
+ */
+EntryUrl EntryAttributes::parsedUrl(const QString& key) const
+{
+    QMutexLocker locker(&m_parsedUrlsMutex);
+    auto it = m_parsedUrls.constFind(key);
+    if (it == m_parsedUrls.constEnd()) {
+        it = m_parsedUrls.insert(key, EntryUrl(m_attributes.value(key)));
+    }
+    return it.value();
+}
+
+/**
+ * Drop the parsed URL of the given attribute or of all attributes if no key is given.
+ */
+void EntryAttributes::invalidateParsedUrls(const QString& key)
+{
+    QMutexLocker locker(&m_parsedUrlsMutex);
+    if (key.isNull()) {
+        m_parsedUrls.clear();
+    } else {
+        m_parsedUrls.remove(key);
+    }
+}
+
 bool EntryAttributes::operator==(const EntryAttributes& other) const
 {
     return (m_attributes == other.m_attributes && m_protectedAttributes == other.m_protectedAttributes);
@@ -304,6 +351,7 @@ void EntryAttributes::clear()
     for (const QString& key : DefaultAttributes) {
         m_attributes.insert(key, "");
     }
+    invalidateParsedUrls();
 
     emit reset();
     emitModified();
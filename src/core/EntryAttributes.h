@@ -19,12 +19,17 @@
 #ifndef KEEPASSX_ENTRYATTRIBUTES_H
 #define KEEPASSX_ENTRYATTRIBUTES_H
 
+#include <QHash>
 #include <QMap>
+#include <QMutex>
 #include <QObject>
 #include <QSet>
 
+#include "core/EntryUrl.h"
 #include "core/ModifiableObject.h"
 
+class StringInterner;
+
 class EntryAttributes : public ModifiableObject
 {
     Q_OBJECT
@@ -49,6 +54,7 @@ public:
     int attributesSize() const;
     void copyDataFrom(const EntryAttributes* other);
     QUuid referenceUuid(const QString& key) const;
+    EntryUrl parsedUrl(const QString& key) const;
     bool operator==(const EntryAttributes& other) const;
     bool operator!=(const EntryAttributes& other) const;
 
@@ -80,8 +86,17 @@ signals:
     void reset();
 
 private:
+    friend class EntryHistory;
+
+    void invalidateParsedUrls(const QString& key = {});
+    StringInterner* stringInterner() const;
+
     QMap<QString, QString> m_attributes;
     QSet<QString> m_protectedAttributes;
+
+    // Parsed values of the attributes that were used as URLs
+    mutable QMutex m_parsedUrlsMutex;
+    mutable QHash<QString, EntryUrl> m_parsedUrls;
 };
 
 #endif // KEEPASSX_ENTRYATTRIBUTES_H
@@ -0,0 +1,236 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EntryHistory.h"
+
+#include <QRegularExpression>
+
+bool EntryHistory::isEmpty() const
+{
+    return m_items.isEmpty();
+}
+
+int EntryHistory::size() const
+{
+    return m_items.size();
+}
+
+/**
+ * Append a copy of the item as the newest one. The previous newest item
+ * drops the attributes it shares with the new one.
+ */
+void EntryHistory::append(const Entry* item)
+{
+    append(version(item));
+}
+
+/**
+ * Append the version as the newest item, without creating an Entry for it.
+ */
+void EntryHistory::append(const Version& version)
+{
+    Item newest{version, {}, size(version)};
+
+    if (!m_items.isEmpty()) {
+        Item& previous = m_items.last();
+        Version& older = previous.version;
+        const Version& newer = newest.version;
+
+        QMap<QString, QString> changedAttributes;
+        for (auto it = older.attributes.constBegin(); it != older.attributes.constEnd(); ++it) {
+            const auto newerIt = newer.attributes.constFind(it.key());
+            if (newerIt == newer.attributes.constEnd() || newerIt.value() != it.value()) {
+                changedAttributes.insert(it.key(), it.value());
+            }
+        }
+        for (auto it = newer.attributes.constBegin(); it != newer.attributes.constEnd(); ++it) {
+            if (!older.attributes.contains(it.key())) {
+                previous.removedAttributes.append(it.key());
+            }
+        }
+        older.attributes = changedAttributes;
+
+        // Unchanged parts share their data with the newer item
+        if (older.protectedAttributes == newer.protectedAttributes) {
+            older.protectedAttributes = newer.protectedAttributes;
+        }
+        if (older.attachments == newer.attachments) {
+            older.attachments = newer.attachments;
+        }
+        if (older.autoTypeAssociations == newer.autoTypeAssociations) {
+            older.autoTypeAssociations = newer.autoTypeAssociations;
+        }
+        if (older.customData == newer.customData) {
+            older.customData = newer.customData;
+        }
+    }
+
+    m_items.append(newest);
+}
+
+/**
+ * Remove the oldest items that exceed the limits, like Entry::truncateHistory() does.
+ *
+ * @param maxItems maximum number of items, -1 for no limit
+ * @param maxSize maximum size of all items in bytes, -1 for no limit
+ * @return true if items were removed
+ */
+bool EntryHistory::truncate(int maxItems, int maxSize)
+{
+    int keep = m_items.size();
+    if (maxItems > -1) {
+        keep = qMin(keep, maxItems);
+    }
+
+    if (maxSize > -1) {
+        int size = 0;
+        int count = 0;
+        for (int i = m_items.size() - 1; i >= m_items.size() - keep; --i) {
+            size += m_items.at(i).size;
+            if (size > maxSize) {
+                break;
+            }
+            ++count;
+        }
+        keep = count;
+    }
+
+    if (keep == m_items.size()) {
+        return false;
+    }
+
+    // Newer items do not depend on older ones
+    m_items.erase(m_items.begin(), m_items.begin() + (m_items.size() - keep));
+    return true;
+}
+
+/**
+ * @return all data of every item, sorted from oldest to newest
+ */
+QList<EntryHistory::Version> EntryHistory::versions() const
+{
+    QList<Version> result;
+    result.reserve(m_items.size());
+
+    QMap<QString, QString> attributes;
+    for (int i = m_items.size() - 1; i >= 0; --i) {
+        const Item& item = m_items.at(i);
+        if (i == m_items.size() - 1) {
+            attributes = item.version.attributes;
+        } else {
+            for (const QString& key : item.removedAttributes) {
+                attributes.remove(key);
+            }
+            for (auto it = item.version.attributes.constBegin(); it != item.version.attributes.constEnd(); ++it) {
+                attributes.insert(it.key(), it.value());
+            }
+        }
+
+        Version version = item.version;
+        version.attributes = attributes;
+        result.prepend(version);
+    }
+
+    return result;
+}
+
+/**
+ * Create history items, the caller takes ownership of them.
+ *
+ * @param uuid uuid of the entry the history belongs to
+ * @return items sorted from oldest to newest
+ */
+QList<Entry*> EntryHistory::materialize(const QUuid& uuid) const
+{
+    QList<Entry*> result;
+
+    const QList<Version> allVersions = versions();
+    for (const Version& version : allVersions) {
+        auto* item = new Entry();
+        item->m_uuid = uuid;
+        item->m_data = version.data;
+        item->m_attributes->m_attributes = version.attributes;
+        item->m_attributes->m_protectedAttributes = version.protectedAttributes;
+        item->m_attachments->m_attachments = version.attachments;
+        item->m_autoTypeAssociations->m_associations = version.autoTypeAssociations;
+        item->m_customData->m_data = version.customData;
+        if (!item->m_data.totpSettings) {
+            // Versions that were never an Entry do not have their TOTP settings parsed
+            item->updateTotp();
+        }
+        result.append(item);
+    }
+
+    return result;
+}
+
+EntryHistory::Version EntryHistory::version(const Entry* item)
+{
+    Version result;
+    result.data = item->m_data;
+    result.attributes = item->m_attributes->m_attributes;
+    result.protectedAttributes = item->m_attributes->m_protectedAttributes;
+    result.attachments = item->m_attachments->m_attachments;
+    result.autoTypeAssociations = item->m_autoTypeAssociations->m_associations;
+    result.customData = item->m_customData->m_data;
+    return result;
+}
+
+/**
+ * @return size of the version in bytes, the same as Entry::size() of its item
+ */
+int EntryHistory::size(const Version& version)
+{
+    int size = 0;
+    for (auto it = version.attributes.constBegin(); it != version.attributes.constEnd(); ++it) {
+        size += it.key().toUtf8().size() + it.value().toUtf8().size();
+    }
+    for (const AutoTypeAssociations::Association& association : version.autoTypeAssociations) {
+        size += association.sequence.toUtf8().size() + association.window.toUtf8().size();
+    }
+    for (auto it = version.attachments.constBegin(); it != version.attachments.constEnd(); ++it) {
+        size += it.key().toUtf8().size() + it.value()->size();
+    }
+    for (auto it = version.customData.constBegin(); it != version.customData.constEnd(); ++it) {
+        size += it.key().toUtf8().size() + it.value().toUtf8().size();
+    }
+    const QStringList tags = version.data.tags.split(QRegularExpression(",|:|;"), QString::SkipEmptyParts);
+    for (const QString& tag : tags) {
+        size += tag.toUtf8().size();
+    }
+    return size;
+}
+
+/**
+ * Data of the history items of an entry, without materializing its history if it is compact.
+ *
+ * @return versions sorted from oldest to newest
+ */
+QList<EntryHistory::Version> EntryHistory::historyVersions(const Entry* entry)
+{
+    QMutexLocker locker(&entry->m_historyMutex);
+    if (entry->m_compactHistory) {
+        return entry->m_compactHistory->versions();
+    }
+
+    QList<Version> result;
+    result.reserve(entry->m_history.size());
+    for (const Entry* item : asConst(entry->m_history)) {
+        result.append(version(item));
+    }
+    return result;
+}
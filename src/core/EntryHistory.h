@@ -0,0 +1,72 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_ENTRYHISTORY_H
+#define KEEPASSXC_ENTRYHISTORY_H
+
+#include "core/Entry.h"
+
+/**
+ * Compact history of an entry.
+ *
+ * The newest item is kept with all of its attributes, every older item only
+ * keeps the attributes that differ from the next newer one. Items share the
+ * uuid of their entry and are only turned into Entry objects when they are
+ * needed, see Entry::historyItems() and Entry::readHistoryItems().
+ */
+class EntryHistory
+{
+public:
+    /**
+     * All data of a history item as plain values.
+     */
+    struct Version
+    {
+        EntryData data;
+        QMap<QString, QString> attributes;
+        QSet<QString> protectedAttributes;
+        QMap<QString, QSharedPointer<const AttachmentData>> attachments;
+        QList<AutoTypeAssociations::Association> autoTypeAssociations;
+        QHash<QString, QString> customData;
+    };
+
+    bool isEmpty() const;
+    int size() const;
+    void append(const Entry* item);
+    void append(const Version& version);
+    bool truncate(int maxItems, int maxSize);
+    QList<Version> versions() const;
+    QList<Entry*> materialize(const QUuid& uuid) const;
+
+    static Version version(const Entry* item);
+    static int size(const Version& version);
+    static QList<Version> historyVersions(const Entry* entry);
+
+private:
+    struct Item
+    {
+        // Holds only the changed attributes, except for the newest item
+        Version version;
+        // Attributes of the next newer item that this item does not have
+        QStringList removedAttributes;
+        int size;
+    };
+
+    QList<Item> m_items; // Items sorted from oldest to newest
+};
+
+#endif // KEEPASSXC_ENTRYHISTORY_H
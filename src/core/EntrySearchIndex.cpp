@@ -0,0 +1,207 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EntrySearchIndex.h"
+
+#include "core/Group.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Don't bother compacting small indexes
+    const int MinStalePostings = 4096;
+} // namespace
+
+EntrySearchIndex::EntrySearchIndex(QObject* parent)
+    : QObject(parent)
+{
+}
+
+/**
+ * Index all entries of the given group and its children,
+ * replacing the previous contents of the index.
+ *
+ * @param baseGroup group to start from, cannot be null
+ */
+void EntrySearchIndex::build(const Group* baseGroup)
+{
+    Q_ASSERT(baseGroup);
+
+    clear();
+    for (const auto entry : baseGroup->entriesRecursive()) {
+        addEntry(entry);
+    }
+}
+
+void EntrySearchIndex::clear()
+{
+    for (auto it = m_entryTrigrams.constBegin(); it != m_entryTrigrams.constEnd(); ++it) {
+        it.key()->disconnect(this);
+    }
+    for (const auto entry : asConst(m_unfiltered)) {
+        entry->disconnect(this);
+    }
+
+    m_postings.clear();
+    m_entryTrigrams.clear();
+    m_unfiltered.clear();
+    m_postingCount = 0;
+    m_stalePostingCount = 0;
+}
+
+/**
+ * Add an entry to the index. The entry is dropped from the index again
+ * as soon as it is modified or deleted.
+ *
+ * @param entry entry to index
+ */
+void EntrySearchIndex::addEntry(const Entry* entry)
+{
+    if (isIndexed(entry)) {
+        return;
+    }
+
+    connect(entry, &Entry::modified, this, [this, entry] { removeEntry(entry); });
+    connect(entry, &QObject::destroyed, this, [this, entry] { removeEntry(entry); });
+
+    const QString title = entry->title();
+    const QString username = entry->username();
+    const QString url = entry->url();
+    if (title.contains('{') || username.contains('{') || url.contains('{')) {
+        m_unfiltered.insert(entry);
+        return;
+    }
+
+    QVector<quint64> trigrams;
+    appendTrigrams(title, trigrams);
+    appendTrigrams(username, trigrams);
+    appendTrigrams(url, trigrams);
+    appendTrigrams(entry->notes(), trigrams);
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+    for (const auto trigram : asConst(trigrams)) {
+        m_postings[trigram].append(entry);
+    }
+    m_postingCount += trigrams.size();
+    m_entryTrigrams.insert(entry, trigrams);
+
+    if (m_stalePostingCount > MinStalePostings && m_stalePostingCount > m_postingCount / 2) {
+        compact();
+    }
+}
+
+/**
+ * Remove an entry from the index. The entry pointer is never dereferenced,
+ * so this is safe to call for entries that are being destroyed.
+ *
+ * @param entry entry to remove
+ */
+void EntrySearchIndex::removeEntry(const Entry* entry)
+{
+    entry->disconnect(this);
+    m_unfiltered.remove(entry);
+
+    auto it = m_entryTrigrams.find(entry);
+    if (it != m_entryTrigrams.end()) {
+        // Leave the posting lists alone, the stale references are skipped on lookup
+        m_stalePostingCount += it->size();
+        m_entryTrigrams.erase(it);
+    }
+}
+
+bool EntrySearchIndex::isIndexed(const Entry* entry) const
+{
+    return m_entryTrigrams.contains(entry) || m_unfiltered.contains(entry);
+}
+
+/**
+ * Collect the indexed entries that contain all of the given words in
+ * one of their indexed fields, ignoring case. Entries that are not
+ * indexed are never part of the result and must be checked by the caller.
+ *
+ * @param words plain words without wildcards
+ * @param result indexed entries that may match
+ * @return false if the words are too short to narrow down the entries
+ */
+bool EntrySearchIndex::candidates(const QStringList& words, QSet<const Entry*>& result) const
+{
+    QVector<quint64> query;
+    for (const auto& word : words) {
+        appendTrigrams(word, query);
+    }
+    if (query.isEmpty()) {
+        return false;
+    }
+
+    std::sort(query.begin(), query.end());
+    query.erase(std::unique(query.begin(), query.end()), query.end());
+
+    result = m_unfiltered;
+
+    // Verify the entries of the shortest posting list against all trigrams
+    const QVector<const Entry*>* shortest = nullptr;
+    for (const auto trigram : asConst(query)) {
+        auto it = m_postings.constFind(trigram);
+        if (it == m_postings.constEnd()) {
+            return true;
+        }
+        if (!shortest || it->size() < shortest->size()) {
+            shortest = &it.value();
+        }
+    }
+
+    for (const auto entry : *shortest) {
+        auto trigrams = m_entryTrigrams.constFind(entry);
+        if (trigrams == m_entryTrigrams.constEnd()) {
+            continue;
+        }
+        bool found = std::all_of(query.constBegin(), query.constEnd(), [&trigrams](quint64 trigram) {
+            return std::binary_search(trigrams->constBegin(), trigrams->constEnd(), trigram);
+        });
+        if (found) {
+            result.insert(entry);
+        }
+    }
+
+    return true;
+}
+
+void EntrySearchIndex::appendTrigrams(const QString& text, QVector<quint64>& trigrams)
+{
+    const QString folded = text.toCaseFolded();
+    for (int i = 0; i + 2 < folded.size(); ++i) {
+        trigrams.append(static_cast<quint64>(folded.at(i).unicode()) << 32
+                        | static_cast<quint64>(folded.at(i + 1).unicode()) << 16
+                        | static_cast<quint64>(folded.at(i + 2).unicode()));
+    }
+}
+
+void EntrySearchIndex::compact()
+{
+    m_postings.clear();
+    m_postingCount = 0;
+    m_stalePostingCount = 0;
+
+    for (auto it = m_entryTrigrams.constBegin(); it != m_entryTrigrams.constEnd(); ++it) {
+        for (const auto trigram : it.value()) {
+            m_postings[trigram].append(it.key());
+        }
+        m_postingCount += it->size();
+    }
+}
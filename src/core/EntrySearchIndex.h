@@ -0,0 +1,66 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSX_ENTRYSEARCHINDEX_H
+#define KEEPASSX_ENTRYSEARCHINDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+class Entry;
+class Group;
+
+/**
+ * Trigram index over the title, username, url and notes of entries.
+ *
+ * The index is only used to discard entries that cannot match a plain word,
+ * every candidate is still confirmed by the regular search. Entries that were
+ * modified since they were indexed are treated as unknown until they are
+ * indexed again, so the index never hides a match.
+ */
+class EntrySearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EntrySearchIndex(QObject* parent = nullptr);
+
+    void build(const Group* baseGroup);
+    void clear();
+
+    void addEntry(const Entry* entry);
+    void removeEntry(const Entry* entry);
+    bool isIndexed(const Entry* entry) const;
+    bool candidates(const QStringList& words, QSet<const Entry*>& result) const;
+
+private:
+    static void appendTrigrams(const QString& text, QVector<quint64>& trigrams);
+    void compact();
+
+    // Posting lists may hold outdated entries, these are filtered against m_entryTrigrams
+    QHash<quint64, QVector<const Entry*>> m_postings;
+    QHash<const Entry*, QVector<quint64>> m_entryTrigrams;
+    // Entries with placeholders in their fields can match anything after resolving them
+    QSet<const Entry*> m_unfiltered;
+    int m_postingCount = 0;
+    int m_stalePostingCount = 0;
+};
+
+#endif // KEEPASSX_ENTRYSEARCHINDEX_H
@@ -18,12 +18,19 @@
 
 #include "EntrySearcher.h"
 
+#include "core/EntrySearchIndex.h"
 #include "core/Group.h"
 #include "core/Tools.h"
+#include "core/Trace.h"
+
+#include <QtConcurrentFilter>
+
+const int EntrySearcher::DefaultParallelThreshold = 2000;
 
 EntrySearcher::EntrySearcher(bool caseSensitive, bool skipProtected)
     : m_caseSensitive(caseSensitive)
     , m_skipProtected(skipProtected)
+    , m_parallelThreshold(DefaultParallelThreshold)
     , m_termParser(R"re(([-!*+]+)?(?:(\w*):)?(?:(?=")"((?:[^"\\]|\\.)*)"|([^ ]*))( |$))re")
 // Group 1 = modifiers, Group 2 = field, Group 3 = quoted string, Group 4 = unquoted string
 {
@@ -38,8 +45,10 @@ EntrySearcher::EntrySearcher(bool caseSensitive, bool skipProtected)
  */
 QList<Entry*> EntrySearcher::search(const QList<SearchTerm>& searchTerms, const Group* baseGroup, bool forceSearch)
 {
+    Trace::Scope trace("EntrySearcher::search");
     Q_ASSERT(baseGroup);
     m_searchTerms = searchTerms;
+    m_indexWords.clear();
     return repeat(baseGroup, forceSearch);
 }
 
@@ -54,6 +63,7 @@ QList<Entry*> EntrySearcher::search(const QList<SearchTerm>& searchTerms, const
  */
 QList<Entry*> EntrySearcher::search(const QString& searchString, const Group* baseGroup, bool forceSearch)
 {
+    Trace::Scope trace("EntrySearcher::search");
     Q_ASSERT(baseGroup);
     parseSearchTerms(searchString);
     return repeat(baseGroup, forceSearch);
@@ -70,17 +80,20 @@ QList<Entry*> EntrySearcher::repeat(const Group* baseGroup, bool forceSearch)
 {
     Q_ASSERT(baseGroup);
 
-    QList<Entry*> results;
+    QSet<const Entry*> candidates;
+    bool filtered = m_searchIndex && m_searchIndex->candidates(m_indexWords, candidates);
+
+    QList<Entry*> entries;
     for (const auto group : baseGroup->groupsRecursive(true)) {
         if (forceSearch || group->resolveSearchingEnabled()) {
             for (const auto entry : group->entries()) {
-                if (searchEntryImpl(entry)) {
-                    results.append(entry);
+                if (!skipEntry(entry, filtered ? &candidates : nullptr)) {
+                    entries.append(entry);
                 }
             }
         }
     }
-    return results;
+    return evaluate(entries);
 }
 
 /**
@@ -93,6 +106,7 @@ QList<Entry*> EntrySearcher::repeat(const Group* baseGroup, bool forceSearch)
 QList<Entry*> EntrySearcher::searchEntries(const QList<SearchTerm>& searchTerms, const QList<Entry*>& entries)
 {
     m_searchTerms = searchTerms;
+    m_indexWords.clear();
     return repeatEntries(entries);
 }
 
@@ -118,13 +132,16 @@ QList<Entry*> EntrySearcher::searchEntries(const QString& searchString, const QL
  */
 QList<Entry*> EntrySearcher::repeatEntries(const QList<Entry*>& entries)
 {
-    QList<Entry*> results;
+    QSet<const Entry*> candidates;
+    bool filtered = m_searchIndex && m_searchIndex->candidates(m_indexWords, candidates);
+
+    QList<Entry*> remaining;
     for (auto* entry : entries) {
-        if (searchEntryImpl(entry)) {
-            results.append(entry);
+        if (!skipEntry(entry, filtered ? &candidates : nullptr)) {
+            remaining.append(entry);
         }
     }
-    return results;
+    return evaluate(remaining);
 }
 
 /**
@@ -142,14 +159,65 @@ bool EntrySearcher::isCaseSensitive() const
     return m_caseSensitive;
 }
 
-bool EntrySearcher::searchEntryImpl(const Entry* entry)
+/**
+ * Use a search index to skip entries that cannot match the
+ * plain words of the search string. The index is not owned
+ * by the searcher, pass nullptr to search without it.
+ *
+ * @param index search index of the searched database
+ */
+void EntrySearcher::setSearchIndex(EntrySearchIndex* index)
+{
+    m_searchIndex = index;
+}
+
+/**
+ * Set the number of entries from which on the search terms are
+ * evaluated on the global thread pool instead of the calling thread.
+ * Results are returned in the same order either way.
+ *
+ * @param threshold minimum number of entries, a negative value disables parallel searches
+ */
+void EntrySearcher::setParallelThreshold(int threshold)
 {
-    // Pre-load in case they are needed
-    auto attributes_keys = entry->attributes()->customKeys();
-    auto attributes = QStringList(attributes_keys + entry->attributes()->values(attributes_keys));
-    auto attachments = QStringList(entry->attachments()->keys());
-    // Build a group hierarchy to allow searching for e.g. /group1/subgroup*
-    auto hierarchy = entry->group()->hierarchy().join('/').prepend("/");
+    m_parallelThreshold = threshold;
+}
+
+QList<Entry*> EntrySearcher::evaluate(const QList<Entry*>& entries) const
+{
+    if (m_parallelThreshold >= 0 && entries.size() >= m_parallelThreshold) {
+        return QtConcurrent::blockingFiltered(entries, [this](const Entry* entry) { return searchEntryImpl(entry); });
+    }
+
+    QList<Entry*> results;
+    for (auto* entry : entries) {
+        if (searchEntryImpl(entry)) {
+            results.append(entry);
+        }
+    }
+    return results;
+}
+
+bool EntrySearcher::skipEntry(const Entry* entry, const QSet<const Entry*>* candidates)
+{
+    if (!m_searchIndex) {
+        return false;
+    }
+    if (!m_searchIndex->isIndexed(entry)) {
+        // New or modified entry, index it for the next search and check it the slow way
+        m_searchIndex->addEntry(entry);
+        return false;
+    }
+    return candidates && !candidates->contains(entry);
+}
+
+bool EntrySearcher::searchEntryImpl(const Entry* entry) const
+{
+    // Loaded on demand, most searches do not need them
+    QStringList attributes;
+    QStringList attachments;
+    bool attributesLoaded = false;
+    bool attachmentsLoaded = false;
 
     // By default, empty term matches every entry.
     // However when skipping protected fields, we will recject everything instead
@@ -175,9 +243,18 @@ bool EntrySearcher::searchEntryImpl(const Entry* entry)
             found = term.regex.match(entry->notes()).hasMatch();
             break;
         case Field::AttributeKV:
+            if (!attributesLoaded) {
+                auto attributes_keys = entry->attributes()->customKeys();
+                attributes = QStringList(attributes_keys + entry->attributes()->values(attributes_keys));
+                attributesLoaded = true;
+            }
             found = !attributes.filter(term.regex).empty();
             break;
         case Field::Attachment:
+            if (!attachmentsLoaded) {
+                attachments = QStringList(entry->attachments()->keys());
+                attachmentsLoaded = true;
+            }
             found = !attachments.filter(term.regex).empty();
             break;
         case Field::AttributeValue:
@@ -190,6 +267,8 @@ bool EntrySearcher::searchEntryImpl(const Entry* entry)
         case Field::Group:
             // Match against the full hierarchy if the word contains a '/' otherwise just the group name
             if (term.word.contains('/')) {
+                // Build a group hierarchy to allow searching for e.g. /group1/subgroup*
+                auto hierarchy = entry->group()->hierarchy().join('/').prepend("/");
                 found = term.regex.match(hierarchy).hasMatch();
             } else {
                 found = term.regex.match(entry->group()->name()).hasMatch();
@@ -230,8 +309,10 @@ void EntrySearcher::parseSearchTerms(const QString& searchString)
         {QStringLiteral("url"), Field::Url},
         {QStringLiteral("username"), Field::Username},
         {QStringLiteral("group"), Field::Group}};
+    static const QRegularExpression wildcards("[*?|]");
 
     m_searchTerms.clear();
+    m_indexWords.clear();
     auto results = m_termParser.globalMatch(searchString);
     while (results.hasNext()) {
         auto result = results.next();
@@ -279,6 +360,14 @@ void EntrySearcher::parseSearchTerms(const QString& searchString)
             }
         }
 
+        // Plain words in the default fields can be looked up in the search index
+        bool indexedField = term.field == Field::Undefined || term.field == Field::Title
+                            || term.field == Field::Username || term.field == Field::Url
+                            || term.field == Field::Notes;
+        if (indexedField && !term.exclude && !mods.contains("*") && !term.word.contains(wildcards)) {
+            m_indexWords.append(term.word);
+        }
+
         m_searchTerms.append(term);
     }
 }
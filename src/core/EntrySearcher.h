@@ -19,10 +19,13 @@
 #ifndef KEEPASSX_ENTRYSEARCHER_H
 #define KEEPASSX_ENTRYSEARCHER_H
 
+#include <QPointer>
 #include <QRegularExpression>
+#include <QSet>
 
 class Group;
 class Entry;
+class EntrySearchIndex;
 
 class EntrySearcher
 {
@@ -62,15 +65,25 @@ public:
 
     void setCaseSensitive(bool state);
     bool isCaseSensitive() const;
+    void setSearchIndex(EntrySearchIndex* index);
+    void setParallelThreshold(int threshold);
+
+    static const int DefaultParallelThreshold;
 
 private:
-    bool searchEntryImpl(const Entry* entry);
+    QList<Entry*> evaluate(const QList<Entry*>& entries) const;
+    bool searchEntryImpl(const Entry* entry) const;
+    bool skipEntry(const Entry* entry, const QSet<const Entry*>* candidates);
     void parseSearchTerms(const QString& searchString);
 
     bool m_caseSensitive;
     bool m_skipProtected;
+    int m_parallelThreshold;
     QRegularExpression m_termParser;
     QList<SearchTerm> m_searchTerms;
+    // Plain words of the search terms that every matching entry must contain
+    QStringList m_indexWords;
+    QPointer<EntrySearchIndex> m_searchIndex;
 
     friend class TestEntrySearcher;
 };
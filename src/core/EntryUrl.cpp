@@ -0,0 +1,161 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EntryUrl.h"
+
+#include "core/Tools.h"
+
+#include <QHostAddress>
+#include <QRegularExpression>
+
+EntryUrl::EntryUrl(const QString& text)
+    : m_text(text)
+    , m_hasScheme(text.contains("://"))
+    , m_valid(Tools::checkUrlValid(text))
+{
+    if (text.isEmpty()) {
+        return;
+    }
+
+    static const QRegularExpression illegalCharacters("[<>\\^`{|}]");
+    m_illegalCharacters = illegalCharacters.match(text).hasMatch();
+
+    m_url = m_hasScheme ? QUrl(text) : QUrl::fromUserInput(text);
+    m_scheme = m_url.scheme();
+    m_host = m_url.host();
+    m_domain = m_host.isEmpty() ? QString() : registrableDomain(m_host);
+    m_port = m_url.port();
+    m_path = m_url.path();
+
+    // NOTE: QUrl::matches is utterly broken in Qt < 5.11, so parts that are
+    // never matched are removed instead
+    m_normalized = QUrl::fromUserInput(text).adjusted(QUrl::RemoveFragment | QUrl::RemoveUserInfo);
+    // Default to https scheme if undefined
+    if (m_normalized.scheme().isEmpty() || !m_hasScheme) {
+        m_normalized.setScheme("https");
+    }
+    // URLs from the browser extension always have a path, entry URLs can be without
+    if (m_normalized.path().isEmpty() && !m_normalized.hasFragment() && !m_normalized.hasQuery()) {
+        m_normalized.setPath("/");
+    }
+}
+
+/**
+ * The URL as it is stored in the entry.
+ */
+const QString& EntryUrl::text() const
+{
+    return m_text;
+}
+
+/**
+ * True if the URL was given with a scheme, e.g. https://example.com but not example.com.
+ */
+bool EntryUrl::hasScheme() const
+{
+    return m_hasScheme;
+}
+
+/**
+ * True if the URL can be used by the browser integration, see Tools::checkUrlValid().
+ */
+bool EntryUrl::isValid() const
+{
+    return m_valid;
+}
+
+/**
+ * True if the URL contains characters that are never part of a site URL.
+ */
+bool EntryUrl::hasIllegalCharacters() const
+{
+    return m_illegalCharacters;
+}
+
+/**
+ * The URL as parsed for matching sites. URLs without a scheme are parsed as user input,
+ * so example.com has the host example.com.
+ */
+const QUrl& EntryUrl::url() const
+{
+    return m_url;
+}
+
+const QString& EntryUrl::scheme() const
+{
+    return m_scheme;
+}
+
+const QString& EntryUrl::host() const
+{
+    return m_host;
+}
+
+/**
+ * Registrable domain of the host, e.g. example.co.uk for login.example.co.uk.
+ */
+const QString& EntryUrl::domain() const
+{
+    return m_domain;
+}
+
+/**
+ * Port of the URL or -1 if it has none.
+ */
+int EntryUrl::port() const
+{
+    return m_port;
+}
+
+const QString& EntryUrl::path() const
+{
+    return m_path;
+}
+
+/**
+ * The URL prepared for comparing it to a site URL: without fragment and user info,
+ * with the https scheme if none was given and with at least the root path.
+ */
+const QUrl& EntryUrl::normalized() const
+{
+    return m_normalized;
+}
+
+/**
+ * Base domain of a host or URL, e.g. https://another.example.co.uk -> example.co.uk.
+ * IP addresses are returned as they are.
+ */
+QString EntryUrl::registrableDomain(const QString& url)
+{
+    const QUrl qurl = QUrl::fromUserInput(url);
+    QString host = qurl.host();
+
+    const QHostAddress address(host);
+    if (address.protocol() == QAbstractSocket::IPv4Protocol || address.protocol() == QAbstractSocket::IPv6Protocol) {
+        return host;
+    }
+
+    const QString topLevelDomain = qurl.topLevelDomain();
+    if (host.isEmpty() || !host.contains(topLevelDomain)) {
+        return {};
+    }
+
+    // Remove the top level domain, e.g. another.example.co.uk -> another.example
+    host.chop(topLevelDomain.length());
+    // Keep the last part and append the top level domain again, e.g. example.co.uk
+    return host.split('.').last() + topLevelDomain;
+}
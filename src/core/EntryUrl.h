@@ -0,0 +1,67 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSX_ENTRYURL_H
+#define KEEPASSX_ENTRYURL_H
+
+#include <QString>
+#include <QUrl>
+
+/**
+ * URL of an entry, parsed once in the forms that browser integration and
+ * Auto-Type match sites and windows against.
+ *
+ * Entries cache the parsed values of their URL attributes,
+ * see EntryAttributes::parsedUrl().
+ */
+class EntryUrl
+{
+public:
+    EntryUrl() = default;
+    explicit EntryUrl(const QString& text);
+
+    const QString& text() const;
+    bool hasScheme() const;
+    bool isValid() const;
+    bool hasIllegalCharacters() const;
+
+    const QUrl& url() const;
+    const QString& scheme() const;
+    const QString& host() const;
+    const QString& domain() const;
+    int port() const;
+    const QString& path() const;
+
+    const QUrl& normalized() const;
+
+    static QString registrableDomain(const QString& url);
+
+private:
+    QString m_text;
+    bool m_hasScheme = false;
+    bool m_valid = true;
+    bool m_illegalCharacters = false;
+    QUrl m_url;
+    QString m_scheme;
+    QString m_host;
+    QString m_domain;
+    int m_port = -1;
+    QString m_path;
+    QUrl m_normalized;
+};
+
+#endif // KEEPASSX_ENTRYURL_H
@@ -0,0 +1,131 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EntryUrlIndex.h"
+
+#include "core/Entry.h"
+#include "core/EntryUrl.h"
+#include "core/Global.h"
+
+namespace
+{
+    const QString AdditionalUrlPrefix = QStringLiteral("KP2A_URL");
+
+    QStringList entryDomains(const Entry* entry)
+    {
+        const EntryAttributes* attributes = entry->attributes();
+        QStringList keys{EntryAttributes::URLKey};
+        for (const QString& key : attributes->keys()) {
+            if (key.startsWith(AdditionalUrlPrefix)) {
+                keys << key;
+            }
+        }
+
+        QStringList domains;
+        for (const QString& key : asConst(keys)) {
+            // URLs without a host never match a site
+            const EntryUrl url = attributes->parsedUrl(key);
+            if (url.host().isEmpty()) {
+                continue;
+            }
+            if (!domains.contains(url.domain())) {
+                domains << url.domain();
+            }
+        }
+        return domains;
+    }
+} // namespace
+
+/**
+ * Entries with at least one URL within the given registrable domain.
+ * The entries are in no particular order.
+ *
+ * @param domain registrable domain as returned by EntryUrl::registrableDomain()
+ */
+QList<Entry*> EntryUrlIndex::entries(const QString& domain)
+{
+    QMutexLocker locker(&m_mutex);
+    update();
+    return m_entries.value(domain).values();
+}
+
+/**
+ * Index the entry again on the next lookup, it was added or its URLs changed.
+ */
+void EntryUrlIndex::invalidate(Entry* entry)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending.insert(entry);
+}
+
+/**
+ * Index all entries again on the next lookup, e.g. after they were modified
+ * without emitting the modified signal.
+ */
+void EntryUrlIndex::invalidateAll()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_domains.constBegin(); it != m_domains.constEnd(); ++it) {
+        m_pending.insert(it.key());
+    }
+}
+
+void EntryUrlIndex::remove(Entry* entry)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending.remove(entry);
+    const QStringList domains = m_domains.take(entry);
+    for (const QString& domain : domains) {
+        auto it = m_entries.find(domain);
+        if (it != m_entries.end()) {
+            it->remove(entry);
+            if (it->isEmpty()) {
+                m_entries.erase(it);
+            }
+        }
+    }
+}
+
+void EntryUrlIndex::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_domains.clear();
+    m_pending.clear();
+}
+
+void EntryUrlIndex::update()
+{
+    for (Entry* entry : asConst(m_pending)) {
+        for (const QString& domain : m_domains.value(entry)) {
+            auto it = m_entries.find(domain);
+            if (it != m_entries.end()) {
+                it->remove(entry);
+                if (it->isEmpty()) {
+                    m_entries.erase(it);
+                }
+            }
+        }
+
+        const QStringList domains = entryDomains(entry);
+        for (const QString& domain : domains) {
+            m_entries[domain].insert(entry);
+        }
+        m_domains.insert(entry, domains);
+    }
+    m_pending.clear();
+}
@@ -0,0 +1,57 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSX_ENTRYURLINDEX_H
+#define KEEPASSX_ENTRYURLINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+
+class Entry;
+
+/**
+ * Entries of one database by the registrable domain of their URLs, e.g.
+ * example.co.uk for https://login.example.co.uk/. Both the URL of an entry
+ * and its additional KP2A_URL attributes are indexed.
+ *
+ * Entries that were added or modified are indexed again on the next lookup,
+ * so keeping the index up to date costs almost nothing while editing.
+ * The index is safe to use from multiple threads.
+ */
+class EntryUrlIndex
+{
+public:
+    QList<Entry*> entries(const QString& domain);
+    void invalidate(Entry* entry);
+    void invalidateAll();
+    void remove(Entry* entry);
+    void clear();
+
+private:
+    void update();
+
+    QMutex m_mutex;
+    QHash<QString, QSet<Entry*>> m_entries;
+    // Domains of every indexed entry, including entries without any
+    QHash<Entry*, QStringList> m_domains;
+    QSet<Entry*> m_pending;
+};
+
+#endif // KEEPASSX_ENTRYURLINDEX_H
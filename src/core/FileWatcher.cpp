@@ -18,6 +18,7 @@
 #include "FileWatcher.h"
 
 #include "core/AsyncTask.h"
+#include "core/Trace.h"
 
 #ifdef Q_OS_LINUX
 #include <sys/statfs.h>
@@ -130,6 +131,7 @@ void FileWatcher::checkFileChanged()
 
 QByteArray FileWatcher::calculateChecksum()
 {
+    Trace::Scope trace("FileWatcher::calculateChecksum");
     QFile file(m_filePath);
     if (file.open(QFile::ReadOnly)) {
         QCryptographicHash hash(QCryptographicHash::Sha256);
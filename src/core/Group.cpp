@@ -21,6 +21,7 @@
 
 #include "core/Config.h"
 #include "core/DatabaseIcons.h"
+#include "core/EntryHistory.h"
 #include "core/Metadata.h"
 #include "core/Tools.h"
 
@@ -30,6 +31,19 @@
 
 #include <QtConcurrentFilter>
 
+namespace
+{
+    bool isInSubtree(const Group* group, const Group* root)
+    {
+        for (; group; group = group->parentGroup()) {
+            if (group == root) {
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
 const int Group::DefaultIconNumber = 48;
 const int Group::RecycleBinIconNumber = 43;
 const QString Group::RootAutoTypeSequence = "{USERNAME}{TAB}{PASSWORD}{ENTER}";
@@ -71,6 +85,10 @@ Group::~Group()
         m_db->addDeletedObject(delGroup);
     }
 
+    if (m_db) {
+        m_db->unregisterGroup(this, m_uuid);
+    }
+
     cleanupParent();
 }
 
@@ -316,7 +334,7 @@ bool Group::equals(const Group* other, CompareItemOptions options) const
     if (!m_data.equals(other->m_data, options)) {
         return false;
     }
-    if (m_customData != other->m_customData) {
+    if (*m_customData != *other->m_customData) {
         return false;
     }
     if (m_children.count() != other->m_children.count()) {
@@ -340,7 +358,18 @@ bool Group::equals(const Group* other, CompareItemOptions options) const
 
 void Group::setUuid(const QUuid& uuid)
 {
-    set(m_uuid, uuid);
+    if (m_uuid == uuid) {
+        return;
+    }
+
+    if (m_db) {
+        m_db->unregisterGroup(this, m_uuid);
+    }
+    m_uuid = uuid;
+    if (m_db) {
+        m_db->registerGroup(this);
+    }
+    emitModified();
 }
 
 void Group::setName(const QString& name)
@@ -469,7 +498,7 @@ void Group::setParent(Group* parent, int index)
             // copy custom icon to the new database
             if (!iconUuid().isNull() && parent->m_db && m_db->metadata()->hasCustomIcon(iconUuid())
                 && !parent->m_db->metadata()->hasCustomIcon(iconUuid())) {
-                parent->m_db->metadata()->addCustomIcon(iconUuid(), icon());
+                parent->m_db->metadata()->addCustomIcon(iconUuid(), m_db->metadata()->customIconData(iconUuid()));
             }
         }
         if (m_db != parent->m_db) {
@@ -607,6 +636,18 @@ Entry* Group::findEntryByUuid(const QUuid& uuid, bool recursive) const
         return nullptr;
     }
 
+    if (m_db) {
+        // The database index may also hold entries outside of this group, only accept those below it
+        const auto& index = m_db->m_entryIndex;
+        for (auto it = index.constFind(uuid); it != index.constEnd() && it.key() == uuid; ++it) {
+            Entry* entry = it.value();
+            if (recursive ? isInSubtree(entry->group(), this) : entry->group() == this) {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
     auto entries = m_entries;
     if (recursive) {
         entries = entriesRecursive(false);
@@ -642,6 +683,10 @@ Entry* Group::findEntryBySearchTerm(const QString& term, EntryReferenceType refe
                "Database::findEntryRecursive",
                "Can't search entry with \"referenceType\" parameter equal to \"Unknown\"");
 
+    if (referenceType == EntryReferenceType::QUuid) {
+        return findEntryByUuid(QUuid::fromRfc4122(QByteArray::fromHex(term.toLatin1())));
+    }
+
     const QList<Group*> groups = groupsRecursive(true);
 
     for (const Group* group : groups) {
@@ -814,11 +859,18 @@ QSet<QUuid> Group::customIconsRecursive() const
         result.insert(iconUuid());
     }
 
-    const QList<Entry*> entryList = entriesRecursive(true);
+    const QList<Entry*> entryList = entriesRecursive();
     for (Entry* entry : entryList) {
         if (!entry->iconUuid().isNull()) {
             result.insert(entry->iconUuid());
         }
+        // Read the icons of history items without materializing a compact history
+        const QList<EntryHistory::Version> versions = EntryHistory::historyVersions(entry);
+        for (const EntryHistory::Version& version : versions) {
+            if (!version.data.customIcon.isNull()) {
+                result.insert(version.data.customIcon);
+            }
+        }
     }
 
     for (Group* group : m_children) {
@@ -870,6 +922,16 @@ Group* Group::findGroupByUuid(const QUuid& uuid)
         return nullptr;
     }
 
+    if (m_db) {
+        const auto& index = m_db->m_groupIndex;
+        for (auto it = index.constFind(uuid); it != index.constEnd() && it.key() == uuid; ++it) {
+            if (isInSubtree(it.value(), this)) {
+                return it.value();
+            }
+        }
+        return nullptr;
+    }
+
     for (Group* group : groupsRecursive(true)) {
         if (group->uuid() == uuid) {
             return group;
@@ -961,6 +1023,7 @@ void Group::addEntry(Entry* entry)
     connect(entry, &Entry::entryDataChanged, this, &Group::entryDataChanged);
     if (m_db) {
         connect(entry, &Entry::modified, m_db, &Database::markAsModified);
+        m_db->registerEntry(entry);
     }
 
     emitModified();
@@ -978,6 +1041,7 @@ void Group::removeEntry(Entry* entry)
     entry->disconnect(this);
     if (m_db) {
         entry->disconnect(m_db);
+        m_db->unregisterEntry(entry, entry->uuid());
     }
     m_entries.removeAll(entry);
     emitModified();
@@ -1014,18 +1078,22 @@ void Group::connectDatabaseSignalsRecursive(Database* db)
 {
     if (m_db) {
         disconnect(m_db);
+        m_db->unregisterGroup(this, m_uuid);
     }
 
     for (Entry* entry : asConst(m_entries)) {
         if (m_db) {
             entry->disconnect(m_db);
+            m_db->unregisterEntry(entry, entry->uuid());
         }
         if (db) {
             connect(entry, &Entry::modified, db, &Database::markAsModified);
+            db->registerEntry(entry);
         }
     }
 
     if (db) {
+        db->registerGroup(this);
         // clang-format off
         connect(this, &Group::groupDataChanged, db, &Database::groupDataChanged);
         connect(this, &Group::groupAboutToRemove, db, &Database::groupAboutToRemove);
@@ -20,90 +20,371 @@
 #include "core/Group.h"
 
 #include <QCryptographicHash>
+#include <QFile>
 #include <QProcess>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
 
 namespace HibpOffline
 {
     const std::size_t SHA1_BYTES = 20;
 
-    enum class ParseResult
+    /*
+     * The index is a header followed by the records of the HIBP file, sorted by hash.
+     * All numbers are big endian.
+     *
+     *   char    magic[8]     "KPXCHIBP"
+     *   quint32 version      INDEX_VERSION
+     *   quint32 recordSize   sizeof(IndexRecord)
+     *   IndexRecord records[]
+     */
+    const char INDEX_MAGIC[] = "KPXCHIBP";
+    const qint64 INDEX_MAGIC_SIZE = 8;
+    const quint32 INDEX_VERSION = 1;
+    const qint64 INDEX_HEADER_SIZE = INDEX_MAGIC_SIZE + 2 * sizeof(quint32);
+
+    struct IndexRecord
+    {
+        char sha1[SHA1_BYTES];
+        quint32 count;
+    };
+    static_assert(sizeof(IndexRecord) == SHA1_BYTES + sizeof(quint32), "Index records must not be padded");
+
+    bool operator<(const IndexRecord& lhs, const IndexRecord& rhs)
+    {
+        return std::memcmp(lhs.sha1, rhs.sha1, SHA1_BYTES) < 0;
+    }
+
+    const int HEX_SHA1_SIZE = SHA1_BYTES * 2;
+    const qint64 SCAN_CHUNK_SIZE = 4 * 1024 * 1024;
+    const int MAX_LINE_SIZE = 1024;
+
+    enum class ScanResult
     {
         Ok,
-        Eof,
+        Stopped,
         Error
     };
 
-    ParseResult parseHibpLine(QIODevice& input, QByteArray& sha1, int& count)
+    /**
+     * Decode 8 hex digits at once, all bytes of a 64 bit word are processed in parallel.
+     *
+     * @return false if any of the characters is not a hex digit
+     */
+    inline bool decodeHex8(const char* hex, char* out)
     {
-        QByteArray hexSha1(SHA1_BYTES * 2, '\0');
-        const qint64 rc = input.read(hexSha1.data(), hexSha1.size());
-        if (rc == 0) {
-            return ParseResult::Eof;
-        } else if (rc != hexSha1.size()) {
-            return ParseResult::Error;
-        }
+        const quint64 ones = Q_UINT64_C(0x0101010101010101);
+        const quint64 high = ones * 0x80;
 
-        sha1 = QByteArray::fromHex(hexSha1);
+        const auto x = qFromLittleEndian<quint64>(hex);
+        if (x & high) {
+            return false;
+        }
 
-        char c;
-        if (!input.getChar(&c) || c != ':') {
-            return ParseResult::Error;
+        // All bytes are below 0x80, so the additions never carry into the next byte
+        const quint64 digit = (x + ones * (0x80 - '0')) & ~(x + ones * (0x80 - '9' - 1)) & high;
+        const quint64 lower = x | ones * 0x20;
+        const quint64 letter = (lower + ones * (0x80 - 'a')) & ~(lower + ones * (0x80 - 'f' - 1)) & high;
+        if ((digit | letter) != high) {
+            return false;
         }
 
-        count = 0;
-        while (true) {
-            if (!input.getChar(&c)) {
-                return ParseResult::Error;
+        // Convert to nibbles, combine pairs of them into bytes and gather these
+        const quint64 nibbles = (x & ones * 0x0F) + (letter >> 7) * 9;
+        quint64 bytes = ((nibbles << 4) | (nibbles >> 8)) & Q_UINT64_C(0x00FF00FF00FF00FF);
+        bytes = (bytes | (bytes >> 8)) & Q_UINT64_C(0x0000FFFF0000FFFF);
+        bytes = (bytes | (bytes >> 16)) & Q_UINT64_C(0x00000000FFFFFFFF);
+        qToLittleEndian(quint32(bytes), out);
+        return true;
+    }
+
+    /**
+     * Parse the lines in [pos, end) and pass their hash and count to the callback.
+     *
+     * @param pos start of the data, set to the start of the first line that was not parsed
+     * @param atEnd true if the data is not followed by more data, otherwise an incomplete last line is left
+     * @param lineNum number of lines parsed so far
+     */
+    template <typename Callback>
+    ScanResult scanLines(const char*& pos, const char* end, bool atEnd, quint64& lineNum, Callback& callback)
+    {
+        char sha1[SHA1_BYTES];
+        while (pos < end) {
+            if (*pos == '\n' || *pos == '\r') {
+                ++pos;
+                continue;
+            }
+
+            auto lineEnd = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+            if (!lineEnd) {
+                if (!atEnd) {
+                    return ScanResult::Ok;
+                }
+                lineEnd = end;
+            }
+            const char* next = lineEnd < end ? lineEnd + 1 : end;
+            if (lineEnd[-1] == '\r') {
+                --lineEnd;
             }
 
-            if (c == '\n' || c == '\r') {
-                break;
+            if (lineEnd - pos <= HEX_SHA1_SIZE || pos[HEX_SHA1_SIZE] != ':') {
+                return ScanResult::Error;
+            }
+            for (int i = 0; i < HEX_SHA1_SIZE / 8; ++i) {
+                if (!decodeHex8(pos + 8 * i, sha1 + 4 * i)) {
+                    return ScanResult::Error;
+                }
             }
 
-            if (!('0' <= c && c <= '9')) {
-                return ParseResult::Error;
+            qint64 count = 0;
+            for (const char* c = pos + HEX_SHA1_SIZE + 1; c < lineEnd; ++c) {
+                if (*c < '0' || *c > '9' || count > std::numeric_limits<int>::max() / 10) {
+                    return ScanResult::Error;
+                }
+                count = count * 10 + (*c - '0');
+            }
+            if (count > std::numeric_limits<int>::max()) {
+                return ScanResult::Error;
             }
 
-            count *= 10;
-            count += (c - '0');
+            ++lineNum;
+            pos = next;
+            if (!callback(static_cast<const char*>(sha1), static_cast<int>(count))) {
+                return ScanResult::Stopped;
+            }
         }
+        return ScanResult::Ok;
+    }
 
-        while (1 == input.peek(&c, 1) && (c == '\n' || c == '\r')) {
-            input.getChar(&c);
+    /**
+     * Parse a HIBP file and pass the hash and count of every line to the callback,
+     * until it returns false. Files are memory mapped, other devices are read in large chunks.
+     */
+    template <typename Callback> bool scan(QIODevice& input, Callback callback, QString* error)
+    {
+        quint64 lineNum = 0;
+
+        auto file = qobject_cast<QFile*>(&input);
+        if (file && file->isOpen() && !file->isSequential() && file->size() > file->pos()) {
+            const qint64 offset = file->pos();
+            const qint64 size = file->size() - offset;
+            uchar* data = file->map(offset, size);
+            if (data) {
+                const char* pos = reinterpret_cast<const char*>(data);
+                const auto result = scanLines(pos, pos + size, true, lineNum, callback);
+                file->unmap(data);
+                if (result == ScanResult::Error) {
+                    *error = QObject::tr("HIBP file, line %1: parse error").arg(lineNum + 1);
+                    return false;
+                }
+                return true;
+            }
+            // Fall back to reading, e.g. if the address space is too small for the file
         }
 
-        return ParseResult::Ok;
+        QByteArray buffer;
+        int carried = 0;
+        while (true) {
+            buffer.resize(carried + SCAN_CHUNK_SIZE);
+            const qint64 bytesRead = input.read(buffer.data() + carried, SCAN_CHUNK_SIZE);
+            if (bytesRead < 0) {
+                *error = QObject::tr("Failed to read HIBP file: %1").arg(input.errorString());
+                return false;
+            }
+
+            const bool atEnd = bytesRead == 0;
+            const char* pos = buffer.constData();
+            const char* end = pos + carried + bytesRead;
+            const auto result = scanLines(pos, end, atEnd, lineNum, callback);
+            if (result == ScanResult::Stopped || (result == ScanResult::Ok && atEnd)) {
+                return true;
+            }
+
+            // Keep the incomplete last line for the next chunk
+            carried = end - pos;
+            if (result == ScanResult::Error || carried > MAX_LINE_SIZE) {
+                *error = QObject::tr("HIBP file, line %1: parse error").arg(lineNum + 1);
+                return false;
+            }
+            std::memmove(buffer.data(), pos, carried);
+        }
     }
 
-    bool
-    report(QSharedPointer<Database> db, QIODevice& hibpInput, QList<QPair<const Entry*, int>>& findings, QString* error)
+    /**
+     * Look up the passwords of all entries in a HIBP file.
+     *
+     * @param orderedByHash true if the file is ordered by hash, reading stops after the largest hash of the entries.
+     *                      The order is only verified up to that point, the rest of an unordered file is missed.
+     */
+    bool report(QSharedPointer<Database> db,
+                QIODevice& hibpInput,
+                QList<QPair<const Entry*, int>>& findings,
+                QString* error,
+                bool orderedByHash)
     {
+        // Most lines are rejected by the first 8 bytes of their hash alone
         QMultiHash<QByteArray, const Entry*> entriesBySha1;
+        QVector<quint64> prefixes;
         for (const auto* entry : db->rootGroup()->entriesRecursive()) {
             if (!entry->isRecycled()) {
                 const auto sha1 = QCryptographicHash::hash(entry->password().toUtf8(), QCryptographicHash::Sha1);
                 entriesBySha1.insert(sha1, entry);
+                prefixes << qFromBigEndian<quint64>(sha1.constData());
             }
         }
+        std::sort(prefixes.begin(), prefixes.end());
+        const quint64 lastPrefix = prefixes.isEmpty() ? 0 : prefixes.last();
 
-        QByteArray sha1;
-        for (quint64 lineNum = 1;; ++lineNum) {
-            int count = 0;
+        quint64 previousPrefix = 0;
+        auto ordered = orderedByHash;
+        return scan(
+            hibpInput,
+            [&](const char* sha1, int count) {
+                const auto prefix = qFromBigEndian<quint64>(sha1);
+                if (ordered) {
+                    if (prefix < previousPrefix) {
+                        // Not ordered after all, read the whole file
+                        ordered = false;
+                    } else if (prefix > lastPrefix) {
+                        return false;
+                    }
+                    previousPrefix = prefix;
+                }
+
+                if (std::binary_search(prefixes.cbegin(), prefixes.cend(), prefix)) {
+                    for (const auto* entry : entriesBySha1.values(QByteArray(sha1, SHA1_BYTES))) {
+                        findings.append({entry, count});
+                    }
+                }
+                return true;
+            },
+            error);
+    }
+
+    /**
+     * @return true if the input is an index created by convertToIndex(), the input is not consumed
+     */
+    bool isIndex(QIODevice& input)
+    {
+        return input.peek(INDEX_MAGIC_SIZE) == QByteArray(INDEX_MAGIC, INDEX_MAGIC_SIZE);
+    }
+
+    /**
+     * Convert a HIBP file into an index that can be searched without reading it completely.
+     * The index is sorted in place if the HIBP file is not ordered by hash.
+     *
+     * @param hibpInput HIBP file in text format
+     * @param indexFile empty file, opened for reading and writing
+     */
+    bool convertToIndex(QIODevice& hibpInput, QFile& indexFile, QString* error)
+    {
+        QByteArray header(INDEX_HEADER_SIZE, '\0');
+        std::memcpy(header.data(), INDEX_MAGIC, INDEX_MAGIC_SIZE);
+        qToBigEndian(INDEX_VERSION, header.data() + INDEX_MAGIC_SIZE);
+        qToBigEndian(quint32(sizeof(IndexRecord)), header.data() + INDEX_MAGIC_SIZE + sizeof(quint32));
+        if (indexFile.write(header) != header.size()) {
+            *error = QObject::tr("Failed to write HIBP index: %1").arg(indexFile.errorString());
+            return false;
+        }
 
-            switch (parseHibpLine(hibpInput, sha1, count)) {
-            case ParseResult::Eof:
+        IndexRecord previous{};
+        qint64 recordCount = 0;
+        bool sorted = true;
+        bool written = true;
+        const bool parsed = scan(
+            hibpInput,
+            [&](const char* sha1, int count) {
+                IndexRecord record;
+                std::memcpy(record.sha1, sha1, SHA1_BYTES);
+                record.count = qToBigEndian(quint32(count));
+                if (recordCount > 0 && record < previous) {
+                    sorted = false;
+                }
+                if (indexFile.write(reinterpret_cast<const char*>(&record), sizeof(record)) != sizeof(record)) {
+                    written = false;
+                    return false;
+                }
+                previous = record;
+                ++recordCount;
                 return true;
-            case ParseResult::Error:
-                *error = QObject::tr("HIBP file, line %1: parse error").arg(lineNum);
+            },
+            error);
+        if (!written) {
+            *error = QObject::tr("Failed to write HIBP index: %1").arg(indexFile.errorString());
+            return false;
+        } else if (!parsed) {
+            return false;
+        }
+
+        if (!indexFile.flush()) {
+            *error = QObject::tr("Failed to write HIBP index: %1").arg(indexFile.errorString());
+            return false;
+        }
+
+        if (!sorted) {
+            uchar* data = indexFile.map(0, indexFile.size());
+            if (!data) {
+                *error = QObject::tr("Failed to sort HIBP index: %1").arg(indexFile.errorString());
                 return false;
-            default:
-                break;
             }
+            auto records = reinterpret_cast<IndexRecord*>(data + INDEX_HEADER_SIZE);
+            std::sort(records, records + recordCount);
+            indexFile.unmap(data);
+        }
+
+        return true;
+    }
 
-            for (const auto* entry : entriesBySha1.values(sha1)) {
-                findings.append({entry, count});
+    /**
+     * Look up the passwords of all entries in an index created by convertToIndex().
+     * The index is memory mapped and binary searched, so only a few pages of it are read per entry.
+     */
+    bool indexReport(QSharedPointer<Database> db,
+                     QFile& indexFile,
+                     QList<QPair<const Entry*, int>>& findings,
+                     QString* error)
+    {
+        const qint64 size = indexFile.size();
+        const qint64 recordCount = (size - INDEX_HEADER_SIZE) / qint64(sizeof(IndexRecord));
+        if (size < INDEX_HEADER_SIZE || size != INDEX_HEADER_SIZE + recordCount * qint64(sizeof(IndexRecord))) {
+            *error = QObject::tr("Invalid HIBP index file");
+            return false;
+        }
+
+        uchar* data = indexFile.map(0, size);
+        if (!data) {
+            *error = QObject::tr("Failed to map HIBP index: %1").arg(indexFile.errorString());
+            return false;
+        }
+        if (std::memcmp(data, INDEX_MAGIC, INDEX_MAGIC_SIZE) != 0
+            || qFromBigEndian<quint32>(data + INDEX_MAGIC_SIZE) != INDEX_VERSION
+            || qFromBigEndian<quint32>(data + INDEX_MAGIC_SIZE + sizeof(quint32)) != sizeof(IndexRecord)) {
+            indexFile.unmap(data);
+            *error = QObject::tr("Invalid HIBP index file");
+            return false;
+        }
+
+        const auto begin = reinterpret_cast<const IndexRecord*>(data + INDEX_HEADER_SIZE);
+        const auto end = begin + recordCount;
+
+        for (const auto* entry : db->rootGroup()->entriesRecursive()) {
+            if (!entry->isRecycled()) {
+                const auto sha1 = QCryptographicHash::hash(entry->password().toUtf8(), QCryptographicHash::Sha1);
+                IndexRecord key;
+                std::memcpy(key.sha1, sha1.constData(), SHA1_BYTES);
+
+                const auto it = std::lower_bound(begin, end, key);
+                if (it != end && !(key < *it)) {
+                    findings.append({entry, int(qFromBigEndian(it->count))});
+                }
             }
         }
+
+        indexFile.unmap(data);
+        return true;
     }
 
     bool okonReport(QSharedPointer<Database> db,
@@ -20,6 +20,7 @@
 
 #include <QSharedPointer>
 
+class QFile;
 class QIODevice;
 
 class Database;
@@ -30,7 +31,17 @@ namespace HibpOffline
     bool report(QSharedPointer<Database> db,
                 QIODevice& hibpInput,
                 QList<QPair<const Entry*, int>>& findings,
-                QString* error);
+                QString* error,
+                bool orderedByHash = false);
+
+    bool isIndex(QIODevice& input);
+
+    bool convertToIndex(QIODevice& hibpInput, QFile& indexFile, QString* error);
+
+    bool indexReport(QSharedPointer<Database> db,
+                     QFile& indexFile,
+                     QList<QPair<const Entry*, int>>& findings,
+                     QString* error);
 
     bool okonReport(QSharedPointer<Database> db,
                     const QString& okon,
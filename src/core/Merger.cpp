@@ -18,6 +18,11 @@
 #include "Merger.h"
 
 #include "core/Metadata.h"
+#include "core/Trace.h"
+
+#include <QtConcurrentMap>
+
+#include <algorithm>
 
 Merger::Merger(const Database* sourceDb, Database* targetDb)
     : m_mode(Group::Default)
@@ -57,14 +62,85 @@ void Merger::resetForcedMergeMode()
     m_mode = Group::Default;
 }
 
+int Merger::Plan::count(EntryAction action) const
+{
+    int result = 0;
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        if (it.value() == action) {
+            ++result;
+        }
+    }
+    return result;
+}
+
+/**
+ * Compare every entry of the source with its counterpart in the target.
+ *
+ * Neither database is modified, so the entries are compared on all cores.
+ * Conflicts are not resolved here, that depends on the order in which
+ * merge() applies its changes.
+ *
+ * @return action merge() takes for each source entry
+ */
+Merger::Plan Merger::plan() const
+{
+    Trace::Scope trace("Merger::plan");
+    Plan result;
+    if (!m_context.m_sourceGroup || !m_context.m_targetRootGroup) {
+        return result;
+    }
+
+    struct Item
+    {
+        const Entry* sourceEntry;
+        EntryAction action;
+    };
+    QVector<Item> items;
+    const QList<Entry*> sourceEntries = m_context.m_sourceGroup->entriesRecursive(false);
+    items.reserve(sourceEntries.size());
+    for (const Entry* sourceEntry : sourceEntries) {
+        items.append({sourceEntry, UpdateEntry});
+    }
+
+    const Group* targetRootGroup = m_context.m_targetRootGroup;
+    QtConcurrent::blockingMap(items, [targetRootGroup](Item& item) {
+        const Entry* targetEntry = targetRootGroup->findEntryByUuid(item.sourceEntry->uuid());
+        if (!targetEntry) {
+            item.action = CreateEntry;
+        } else if (targetEntry->equals(item.sourceEntry, CompareItemIgnoreMilliseconds | CompareItemIgnoreLocation)) {
+            item.action = KeepEntry;
+        }
+    });
+
+    result.entries.reserve(items.size());
+    for (const Item& item : asConst(items)) {
+        result.entries.insert(item.sourceEntry->uuid(), item.action);
+    }
+    return result;
+}
+
 QStringList Merger::merge()
 {
+    return merge(plan());
+}
+
+/**
+ * Apply a plan computed by plan(), both databases must be unchanged since.
+ *
+ * @return list of changes
+ */
+QStringList Merger::merge(const Plan& plan)
+{
+    Trace::Scope trace("Merger::merge");
+    m_plan = plan;
+
     // Order of merge steps is important - it is possible that we
     // create some items before deleting them afterwards
     ChangeList changes;
     changes << mergeGroup(m_context);
     changes << mergeDeletions(m_context);
     changes << mergeMetadata(m_context);
+    m_plan = {};
 
     // qDebug("Merged %s", qPrintable(changes.join("\n\t")));
 
@@ -75,12 +151,206 @@ QStringList Merger::merge()
     return changes;
 }
 
+/**
+ * Make the target database an exact copy of the source database, for example
+ * to apply a reloaded database file to the open database.
+ *
+ * Unlike merge(), nothing of the target is kept. Entries and groups that are
+ * identical in both databases are left untouched, so views on the target
+ * database keep their state.
+ *
+ * @return list of changes
+ */
+QStringList Merger::mirror()
+{
+    Trace::Scope trace("Merger::mirror");
+    Q_ASSERT(m_context.m_sourceDb && m_context.m_targetDb);
+    if (!m_context.m_sourceDb || !m_context.m_targetDb) {
+        return {};
+    }
+
+    ChangeList changes;
+    const Metadata* sourceMetadata = m_context.m_sourceDb->metadata();
+    Metadata* targetMetadata = m_context.m_targetDb->metadata();
+    targetMetadata->setUpdateDatetime(false);
+
+    // Icons have to be present before entries and groups refer to them
+    const auto sourceIcons = sourceMetadata->customIconsOrder();
+    for (const auto& iconUuid : sourceIcons) {
+        const QByteArray iconData = sourceMetadata->customIconData(iconUuid);
+        if (!targetMetadata->hasCustomIcon(iconUuid)) {
+            targetMetadata->addCustomIcon(iconUuid, iconData);
+            changes << tr("Adding missing icon %1").arg(QString::fromLatin1(iconUuid.toRfc4122().toHex()));
+        } else if (targetMetadata->customIconData(iconUuid) != iconData) {
+            targetMetadata->removeCustomIcon(iconUuid);
+            targetMetadata->addCustomIcon(iconUuid, iconData);
+            changes << tr("Updating icon %1").arg(QString::fromLatin1(iconUuid.toRfc4122().toHex()));
+        }
+    }
+
+    const Group* sourceRootGroup = m_context.m_sourceDb->rootGroup();
+    Group* targetRootGroup = m_context.m_targetDb->rootGroup();
+    if (targetRootGroup->uuid() != sourceRootGroup->uuid()) {
+        targetRootGroup->setUuid(sourceRootGroup->uuid());
+    }
+    changes << mirrorGroup(sourceRootGroup, targetRootGroup);
+    changes << mirrorDeletions();
+
+    targetMetadata->copyAttributesFrom(sourceMetadata);
+    targetMetadata->customData()->copyDataFrom(sourceMetadata->customData());
+    targetMetadata->setSettingsChanged(sourceMetadata->settingsChanged());
+    targetMetadata->setDatabaseKeyChanged(sourceMetadata->databaseKeyChanged());
+    const Group* recycleBin = sourceMetadata->recycleBin();
+    targetMetadata->setRecycleBin(recycleBin ? targetRootGroup->findGroupByUuid(recycleBin->uuid()) : nullptr);
+    targetMetadata->setRecycleBinChanged(sourceMetadata->recycleBinChanged());
+    const Group* templatesGroup = sourceMetadata->entryTemplatesGroup();
+    targetMetadata->setEntryTemplatesGroup(templatesGroup ? targetRootGroup->findGroupByUuid(templatesGroup->uuid())
+                                                          : nullptr);
+    targetMetadata->setEntryTemplatesGroupChanged(sourceMetadata->entryTemplatesGroupChanged());
+
+    const auto targetIcons = targetMetadata->customIconsOrder();
+    for (const auto& iconUuid : targetIcons) {
+        if (!sourceMetadata->hasCustomIcon(iconUuid)) {
+            targetMetadata->removeCustomIcon(iconUuid);
+            changes << tr("Removing icon %1").arg(QString::fromLatin1(iconUuid.toRfc4122().toHex()));
+        }
+    }
+
+    targetMetadata->setUpdateDatetime(true);
+    return changes;
+}
+
+Merger::ChangeList Merger::mirrorGroup(const Group* sourceGroup, Group* targetGroup)
+{
+    ChangeList changes;
+    const bool groupUpdateTimeInfo = targetGroup->canUpdateTimeinfo();
+    targetGroup->setUpdateTimeinfo(false);
+
+    if (!targetGroup->equals(sourceGroup, CompareItemDefault)) {
+        targetGroup->copyDataFrom(sourceGroup);
+    }
+
+    const QList<Entry*> sourceEntries = sourceGroup->entries();
+    for (int i = 0; i < sourceEntries.size(); ++i) {
+        const Entry* sourceEntry = sourceEntries[i];
+        Entry* targetEntry = m_context.m_targetRootGroup->findEntryByUuid(sourceEntry->uuid());
+        if (!targetEntry) {
+            changes << tr("Creating missing %1 [%2]").arg(sourceEntry->title(), sourceEntry->uuidToHex());
+            targetEntry = sourceEntry->clone(Entry::CloneIncludeHistory);
+            moveEntry(targetEntry, targetGroup);
+        } else {
+            if (targetEntry->group() != targetGroup) {
+                changes << tr("Relocating %1 [%2]").arg(sourceEntry->title(), sourceEntry->uuidToHex());
+                moveEntry(targetEntry, targetGroup);
+            }
+            if (!targetEntry->equals(sourceEntry, CompareItemDefault)) {
+                changes << tr("Overwriting %1 [%2]").arg(sourceEntry->title(), sourceEntry->uuidToHex());
+                mirrorEntry(sourceEntry, targetEntry);
+            }
+        }
+        // The entries before i are already in place
+        for (int row = targetGroup->entries().indexOf(targetEntry); row > i; --row) {
+            targetGroup->moveEntryUp(targetEntry);
+        }
+    }
+
+    const QList<Group*> sourceChildGroups = sourceGroup->children();
+    for (int i = 0; i < sourceChildGroups.size(); ++i) {
+        const Group* sourceChildGroup = sourceChildGroups[i];
+        Group* targetChildGroup = m_context.m_targetRootGroup->findGroupByUuid(sourceChildGroup->uuid());
+        if (!targetChildGroup) {
+            changes << tr("Creating missing %1 [%2]").arg(sourceChildGroup->name(), sourceChildGroup->uuidToHex());
+            targetChildGroup = sourceChildGroup->clone(Entry::CloneNoFlags, Group::CloneNoFlags);
+            moveGroup(targetChildGroup, targetGroup, i);
+        } else {
+            if (targetChildGroup->parentGroup() != targetGroup) {
+                changes << tr("Relocating %1 [%2]").arg(sourceChildGroup->name(), sourceChildGroup->uuidToHex());
+            }
+            // Parents are placed before their children, so this never moves a group below itself
+            moveGroup(targetChildGroup, targetGroup, i);
+        }
+        changes << mirrorGroup(sourceChildGroup, targetChildGroup);
+    }
+
+    targetGroup->setUpdateTimeinfo(groupUpdateTimeInfo);
+    return changes;
+}
+
+void Merger::mirrorEntry(const Entry* sourceEntry, Entry* targetEntry)
+{
+    targetEntry->copyDataFrom(sourceEntry);
+
+    const bool updateTimeInfo = targetEntry->canUpdateTimeinfo();
+    targetEntry->setUpdateTimeinfo(false);
+    targetEntry->removeHistoryItems(targetEntry->historyItems());
+    sourceEntry->readHistoryItems([targetEntry](const QList<Entry*>& sourceHistoryItems) {
+        for (const Entry* historyItem : sourceHistoryItems) {
+            targetEntry->addHistoryItem(historyItem->clone(Entry::CloneNoFlags));
+        }
+    });
+    targetEntry->compactHistory();
+    targetEntry->setUpdateTimeinfo(updateTimeInfo);
+}
+
+Merger::ChangeList Merger::mirrorDeletions()
+{
+    ChangeList changes;
+    QSet<QUuid> sourceGroups;
+    QSet<QUuid> sourceEntries;
+    const QList<const Group*> sourceGroupList = m_context.m_sourceRootGroup->groupsRecursive(true);
+    for (const Group* group : sourceGroupList) {
+        sourceGroups.insert(group->uuid());
+        for (const Entry* entry : group->entries()) {
+            sourceEntries.insert(entry->uuid());
+        }
+    }
+
+    // Everything that is still part of the source has been moved out of obsolete groups,
+    // so only the topmost obsolete group of each subtree has to be deleted
+    QList<Group*> groups;
+    QList<Entry*> entries;
+    const QList<Group*> targetGroupList = m_context.m_targetRootGroup->groupsRecursive(true);
+    for (Group* group : targetGroupList) {
+        if (!sourceGroups.contains(group->uuid())) {
+            continue;
+        }
+        const QList<Group*> children = group->children();
+        for (Group* child : children) {
+            if (!sourceGroups.contains(child->uuid())) {
+                groups << child;
+            }
+        }
+        const QList<Entry*> groupEntries = group->entries();
+        for (Entry* entry : groupEntries) {
+            if (!sourceEntries.contains(entry->uuid())) {
+                entries << entry;
+            }
+        }
+    }
+
+    for (Entry* entry : asConst(entries)) {
+        changes << tr("Deleting %1 [%2]").arg(entry->title(), entry->uuidToHex());
+        eraseEntry(entry);
+    }
+    for (Group* group : asConst(groups)) {
+        changes << tr("Deleting %1 [%2]").arg(group->name(), group->uuidToHex());
+        eraseGroup(group);
+    }
+
+    if (m_context.m_targetDb->deletedObjects() != m_context.m_sourceDb->deletedObjects()) {
+        changes << tr("Changed deleted objects");
+        m_context.m_targetDb->setDeletedObjects(m_context.m_sourceDb->deletedObjects());
+    }
+    return changes;
+}
+
 Merger::ChangeList Merger::mergeGroup(const MergeContext& context)
 {
     ChangeList changes;
     // merge entries
     const QList<Entry*> sourceEntries = context.m_sourceGroup->entries();
     for (Entry* sourceEntry : sourceEntries) {
+        const EntryAction action = m_plan.entries.value(sourceEntry->uuid(), UpdateEntry);
         Entry* targetEntry = context.m_targetRootGroup->findEntryByUuid(sourceEntry->uuid());
         if (!targetEntry) {
             changes << tr("Creating missing %1 [%2]").arg(sourceEntry->title(), sourceEntry->uuidToHex());
@@ -95,7 +365,10 @@ Merger::ChangeList Merger::mergeGroup(const MergeContext& context)
                 changes << tr("Relocating %1 [%2]").arg(sourceEntry->title(), sourceEntry->uuidToHex());
                 moveEntry(targetEntry, context.m_targetGroup);
             }
-            changes << resolveEntryConflict(context, sourceEntry, targetEntry);
+            // Resolving identical entries never changes them
+            if (action != KeepEntry) {
+                changes << resolveEntryConflict(context, sourceEntry, targetEntry);
+            }
         }
     }
 
@@ -196,11 +469,11 @@ void Merger::moveEntry(Entry* entry, Group* targetGroup)
     }
 }
 
-void Merger::moveGroup(Group* group, Group* targetGroup)
+void Merger::moveGroup(Group* group, Group* targetGroup, int index)
 {
     Q_ASSERT(group);
     Group* sourceGroup = group->parentGroup();
-    if (sourceGroup == targetGroup) {
+    if (sourceGroup == targetGroup && (index == -1 || targetGroup->children().indexOf(group) == index)) {
         return;
     }
     const bool sourceGroupUpdateTimeInfo = sourceGroup ? sourceGroup->canUpdateTimeinfo() : false;
@@ -214,7 +487,7 @@ void Merger::moveGroup(Group* group, Group* targetGroup)
     const bool groupUpdateTimeInfo = group->canUpdateTimeinfo();
     group->setUpdateTimeinfo(false);
 
-    group->setParent(targetGroup);
+    group->setParent(targetGroup, index);
 
     group->setUpdateTimeinfo(groupUpdateTimeInfo);
     if (targetGroup) {
@@ -230,6 +503,21 @@ void Merger::eraseEntry(Entry* entry)
     Database* database = entry->database();
     // most simple method to remove an item from DeletedObjects :(
     const QList<DeletedObject> deletions = database->deletedObjects();
+    deleteEntry(entry);
+    database->setDeletedObjects(deletions);
+}
+
+void Merger::eraseGroup(Group* group)
+{
+    Database* database = group->database();
+    // most simple method to remove an item from DeletedObjects :(
+    const QList<DeletedObject> deletions = database->deletedObjects();
+    deleteGroup(group);
+    database->setDeletedObjects(deletions);
+}
+
+void Merger::deleteEntry(Entry* entry)
+{
     Group* parentGroup = entry->group();
     const bool groupUpdateTimeInfo = parentGroup ? parentGroup->canUpdateTimeinfo() : false;
     if (parentGroup) {
@@ -239,14 +527,10 @@ void Merger::eraseEntry(Entry* entry)
     if (parentGroup) {
         parentGroup->setUpdateTimeinfo(groupUpdateTimeInfo);
     }
-    database->setDeletedObjects(deletions);
 }
 
-void Merger::eraseGroup(Group* group)
+void Merger::deleteGroup(Group* group)
 {
-    Database* database = group->database();
-    // most simple method to remove an item from DeletedObjects :(
-    const QList<DeletedObject> deletions = database->deletedObjects();
     Group* parentGroup = group->parentGroup();
     const bool groupUpdateTimeInfo = parentGroup ? parentGroup->canUpdateTimeinfo() : false;
     if (parentGroup) {
@@ -256,7 +540,6 @@ void Merger::eraseGroup(Group* group)
     if (parentGroup) {
         parentGroup->setUpdateTimeinfo(groupUpdateTimeInfo);
     }
-    database->setDeletedObjects(deletions);
 }
 
 Merger::ChangeList
@@ -406,7 +689,6 @@ bool Merger::mergeHistory(const Entry* sourceEntry, Entry* targetEntry, Group::M
 {
     Q_UNUSED(mergeMethod);
     const auto targetHistoryItems = targetEntry->historyItems();
-    const auto sourceHistoryItems = sourceEntry->historyItems();
     const int comparison = compare(sourceEntry->timeInfo().lastModificationTime(),
                                    targetEntry->timeInfo().lastModificationTime(),
                                    CompareItemIgnoreMilliseconds);
@@ -426,25 +708,28 @@ bool Merger::mergeHistory(const Entry* sourceEntry, Entry* targetEntry, Group::M
         }
         merged[modificationTime] = historyItem->clone(Entry::CloneNoFlags);
     }
-    for (Entry* historyItem : sourceHistoryItems) {
-        // Items with same modification-time changes will be regarded as same (like KeePass2)
-        const QDateTime modificationTime = Clock::serialized(historyItem->timeInfo().lastModificationTime());
-        if (merged.contains(modificationTime)
-            && !merged[modificationTime]->equals(historyItem, CompareItemIgnoreMilliseconds)) {
-            ::qWarning(
-                "History entry of %s[%s] at %s contains conflicting changes - conflict resolution may lose data!",
-                qPrintable(sourceEntry->title()),
-                qPrintable(sourceEntry->uuidToHex()),
-                qPrintable(modificationTime.toString("yyyy-MM-dd HH-mm-ss-zzz")));
-        }
-        if (preferRemote && merged.contains(modificationTime)) {
-            // forcefully apply the remote history item
-            delete merged.take(modificationTime);
-        }
-        if (!merged.contains(modificationTime)) {
-            merged[modificationTime] = historyItem->clone(Entry::CloneNoFlags);
+    // The source database is only read, its history stays compact
+    sourceEntry->readHistoryItems([&](const QList<Entry*>& sourceHistoryItems) {
+        for (Entry* historyItem : sourceHistoryItems) {
+            // Items with same modification-time changes will be regarded as same (like KeePass2)
+            const QDateTime modificationTime = Clock::serialized(historyItem->timeInfo().lastModificationTime());
+            if (merged.contains(modificationTime)
+                && !merged[modificationTime]->equals(historyItem, CompareItemIgnoreMilliseconds)) {
+                ::qWarning(
+                    "History entry of %s[%s] at %s contains conflicting changes - conflict resolution may lose data!",
+                    qPrintable(sourceEntry->title()),
+                    qPrintable(sourceEntry->uuidToHex()),
+                    qPrintable(modificationTime.toString("yyyy-MM-dd HH-mm-ss-zzz")));
+            }
+            if (preferRemote && merged.contains(modificationTime)) {
+                // forcefully apply the remote history item
+                delete merged.take(modificationTime);
+            }
+            if (!merged.contains(modificationTime)) {
+                merged[modificationTime] = historyItem->clone(Entry::CloneNoFlags);
+            }
         }
-    }
+    });
 
     const QDateTime targetModificationTime = Clock::serialized(targetEntry->timeInfo().lastModificationTime());
     const QDateTime sourceModificationTime = Clock::serialized(sourceEntry->timeInfo().lastModificationTime());
@@ -505,6 +790,8 @@ bool Merger::mergeHistory(const Entry* sourceEntry, Entry* targetEntry, Group::M
         targetEntry->addHistoryItem(historyItem);
     }
     targetEntry->truncateHistory();
+    // The previous history items were deleted, so nothing can refer to the new ones
+    targetEntry->compactHistory();
     targetEntry->blockSignals(blockedSignals);
     targetEntry->setUpdateTimeinfo(updateTimeInfo);
     Q_ASSERT(timeInfo == targetEntry->timeInfo());
@@ -525,14 +812,17 @@ Merger::ChangeList Merger::mergeDeletions(const MergeContext& context)
     const auto sourceDeletions = context.m_sourceDb->deletedObjects();
 
     QList<DeletedObject> deletions;
-    QMap<QUuid, DeletedObject> mergedDeletions;
+    QHash<QUuid, DeletedObject> mergedDeletions;
     QList<Entry*> entries;
-    QList<Group*> groups;
+    QList<QPair<int, Group*>> groups;
 
+    mergedDeletions.reserve(targetDeletions.size() + sourceDeletions.size());
     for (const auto& object : (targetDeletions + sourceDeletions)) {
-        if (!mergedDeletions.contains(object.uuid)) {
-            mergedDeletions[object.uuid] = object;
+        auto it = mergedDeletions.find(object.uuid);
+        if (it == mergedDeletions.end()) {
+            mergedDeletions.insert(object.uuid, object);
 
+            // Both lookups use the uuid index of the database
             auto* entry = context.m_targetRootGroup->findEntryByUuid(object.uuid);
             if (entry) {
                 entries << entry;
@@ -540,19 +830,24 @@ Merger::ChangeList Merger::mergeDeletions(const MergeContext& context)
             }
             auto* group = context.m_targetRootGroup->findGroupByUuid(object.uuid);
             if (group) {
-                groups << group;
+                int depth = 0;
+                for (const Group* parent = group->parentGroup(); parent; parent = parent->parentGroup()) {
+                    ++depth;
+                }
+                groups.append({depth, group});
                 continue;
             }
             deletions << object;
             continue;
         }
-        if (mergedDeletions[object.uuid].deletionTime > object.deletionTime) {
-            mergedDeletions[object.uuid] = object;
+        if (it->deletionTime > object.deletionTime) {
+            *it = object;
         }
     }
 
-    while (!entries.isEmpty()) {
-        auto* entry = entries.takeFirst();
+    // Items are deleted without restoring the deleted objects of the target every time,
+    // they are replaced by the merged deletions at the end.
+    for (auto* entry : asConst(entries)) {
         const auto& object = mergedDeletions[entry->uuid()];
         if (entry->timeInfo().lastModificationTime() > object.deletionTime) {
             // keep deleted entry since it was changed after deletion date
@@ -564,23 +859,21 @@ Merger::ChangeList Merger::mergeDeletions(const MergeContext& context)
         } else {
             changes << tr("Deleting orphan %1 [%2]").arg(entry->title(), entry->uuidToHex());
         }
-        // Entry is inserted into deletedObjects after deletions are processed
-        eraseEntry(entry);
+        deleteEntry(entry);
     }
 
-    while (!groups.isEmpty()) {
-        auto* group = groups.takeFirst();
-        if (!(group->children().toSet() & groups.toSet()).isEmpty()) {
-            // we need to finish all children before we are able to determine if the group can be removed
-            groups << group;
-            continue;
-        }
+    // Bottom-up, so all children of a group are finished before it is decided whether the group can be removed
+    std::stable_sort(groups.begin(), groups.end(), [](const QPair<int, Group*>& lhs, const QPair<int, Group*>& rhs) {
+        return lhs.first > rhs.first;
+    });
+    for (const auto& pair : asConst(groups)) {
+        auto* group = pair.second;
         const auto& object = mergedDeletions[group->uuid()];
         if (group->timeInfo().lastModificationTime() > object.deletionTime) {
             // keep deleted group since it was changed after deletion date
             continue;
         }
-        if (!group->entriesRecursive(false).isEmpty() || !group->groupsRecursive(false).isEmpty()) {
+        if (!group->entries().isEmpty() || !group->children().isEmpty()) {
             // keep deleted group since it contains undeleted content
             continue;
         }
@@ -590,10 +883,10 @@ Merger::ChangeList Merger::mergeDeletions(const MergeContext& context)
         } else {
             changes << tr("Deleting orphan %1 [%2]").arg(group->name(), group->uuidToHex());
         }
-        eraseGroup(group);
+        deleteGroup(group);
     }
     // Put every deletion to the earliest date of deletion
-    if (deletions != context.m_targetDb->deletedObjects()) {
+    if (deletions != targetDeletions) {
         changes << tr("Changed deleted objects");
     }
     context.m_targetDb->setDeletedObjects(deletions);
@@ -611,8 +904,7 @@ Merger::ChangeList Merger::mergeMetadata(const MergeContext& context)
 
     for (const auto& iconUuid : sourceMetadata->customIconsOrder()) {
         if (!targetMetadata->hasCustomIcon(iconUuid)) {
-            QImage customIcon = sourceMetadata->customIcon(iconUuid);
-            targetMetadata->addCustomIcon(iconUuid, customIcon);
+            targetMetadata->addCustomIcon(iconUuid, sourceMetadata->customIconData(iconUuid));
             changes << tr("Adding missing icon %1").arg(QString::fromLatin1(iconUuid.toRfc4122().toHex()));
         }
     }
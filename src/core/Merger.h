@@ -27,11 +27,35 @@ class Merger : public QObject
 {
     Q_OBJECT
 public:
+    enum EntryAction
+    {
+        // The entry is missing in the target and is created
+        CreateEntry,
+        // The entries differ, the conflict is resolved according to the merge mode
+        UpdateEntry,
+        // The entries are identical including their history and are left untouched
+        KeepEntry
+    };
+
+    /**
+     * Result of comparing the entries of both databases, computed without
+     * modifying either of them. It is only valid until one of them changes.
+     */
+    struct Plan
+    {
+        QHash<QUuid, EntryAction> entries;
+
+        int count(EntryAction action) const;
+    };
+
     Merger(const Database* sourceDb, Database* targetDb);
     Merger(const Group* sourceGroup, Group* targetGroup);
     void setForcedMergeMode(Group::MergeMode mode);
     void resetForcedMergeMode();
+    Plan plan() const;
     QStringList merge();
+    QStringList merge(const Plan& plan);
+    QStringList mirror();
 
 private:
     typedef QString Change;
@@ -49,14 +73,21 @@ private:
     ChangeList mergeGroup(const MergeContext& context);
     ChangeList mergeDeletions(const MergeContext& context);
     ChangeList mergeMetadata(const MergeContext& context);
+    ChangeList mirrorGroup(const Group* sourceGroup, Group* targetGroup);
+    ChangeList mirrorDeletions();
+    void mirrorEntry(const Entry* sourceEntry, Entry* targetEntry);
     bool markOlderEntry(Entry* entry);
     bool mergeHistory(const Entry* sourceEntry, Entry* targetEntry, Group::MergeMode mergeMethod);
     void moveEntry(Entry* entry, Group* targetGroup);
-    void moveGroup(Group* group, Group* targetGroup);
+    void moveGroup(Group* group, Group* targetGroup, int index = -1);
     // remove an entry without a trace in the deletedObjects - needed for elemination cloned entries
     void eraseEntry(Entry* entry);
     // remove an entry without a trace in the deletedObjects - needed for elemination cloned entries
     void eraseGroup(Group* group);
+    // remove an entry without touching the timeinfo of its group - it is added to the deletedObjects
+    void deleteEntry(Entry* entry);
+    // remove a group without touching the timeinfo of its parent - it is added to the deletedObjects
+    void deleteGroup(Group* group);
     ChangeList resolveEntryConflict(const MergeContext& context, const Entry* existingEntry, Entry* otherEntry);
     ChangeList resolveGroupConflict(const MergeContext& context, const Group* existingGroup, Group* otherGroup);
     Merger::ChangeList
@@ -73,6 +104,7 @@ private:
 private:
     MergeContext m_context;
     Group::MergeMode m_mode;
+    Plan m_plan;
 };
 
 #endif // KEEPASSXC_MERGER_H
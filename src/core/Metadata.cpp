@@ -21,13 +21,21 @@
 #include "core/Group.h"
 
 #include <QApplication>
+#include <QBuffer>
 #include <QCryptographicHash>
 
 const int Metadata::DefaultHistoryMaxItems = 10;
 const int Metadata::DefaultHistoryMaxSize = 6 * 1024 * 1024;
 
+namespace
+{
+    // Decoded icons kept for display, vaults with downloaded favicons have thousands
+    const int MaxDecodedCustomIcons = 512;
+} // namespace
+
 Metadata::Metadata(QObject* parent)
     : ModifiableObject(parent)
+    , m_customIcons(MaxDecodedCustomIcons)
     , m_customData(new CustomData(this))
     , m_updateDatetime(true)
 {
@@ -64,7 +72,7 @@ void Metadata::clear()
 {
     init();
     m_customIcons.clear();
-    m_customIconsRaw.clear();
+    m_customIconsData.clear();
     m_customIconsOrder.clear();
     m_customIconsHashes.clear();
     m_customData->clear();
@@ -175,9 +183,20 @@ bool Metadata::protectNotes() const
     return m_data.protectNotes;
 }
 
+/**
+ * Decode a custom icon, this is done on every call.
+ */
 QImage Metadata::customIcon(const QUuid& uuid) const
 {
-    return m_customIconsRaw.value(uuid);
+    return QImage::fromData(m_customIconsData.value(uuid));
+}
+
+/**
+ * Encoded data of a custom icon as it is stored in the database, usually PNG.
+ */
+QByteArray Metadata::customIconData(const QUuid& uuid) const
+{
+    return m_customIconsData.value(uuid);
 }
 
 QPixmap Metadata::customIconPixmap(const QUuid& uuid, IconSize size) const
@@ -185,7 +204,23 @@ QPixmap Metadata::customIconPixmap(const QUuid& uuid, IconSize size) const
     if (!hasCustomIcon(uuid)) {
         return {};
     }
-    return m_customIcons.value(uuid).pixmap(databaseIcons()->iconSize(size));
+
+    QIcon* icon = m_customIcons.object(uuid);
+    if (!icon) {
+        icon = new QIcon();
+        // TODO: This check can go away when we move all QIcon handling outside of core
+        // On older versions of Qt, loading a QPixmap from QImage outside of a GUI
+        // environment causes ASAN to fail and crash on nullptr violation
+        static bool isGui = qApp->inherits("QGuiApplication");
+        if (isGui) {
+            // Generate QIcon with pre-baked resolutions
+            const QImage image = customIcon(uuid);
+            *icon = QIcon(
+                QPixmap::fromImage(image.scaled(64, 64, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)));
+        }
+        m_customIcons.insert(uuid, icon);
+    }
+    return icon->pixmap(databaseIcons()->iconSize(size));
 }
 
 QHash<QUuid, QPixmap> Metadata::customIconsPixmaps(IconSize size) const
@@ -201,7 +236,7 @@ QHash<QUuid, QPixmap> Metadata::customIconsPixmaps(IconSize size) const
 
 bool Metadata::hasCustomIcon(const QUuid& uuid) const
 {
-    return m_customIconsRaw.contains(uuid);
+    return m_customIconsData.contains(uuid);
 }
 
 QList<QUuid> Metadata::customIconsOrder() const
@@ -358,31 +393,27 @@ void Metadata::setProtectNotes(bool value)
 }
 
 void Metadata::addCustomIcon(const QUuid& uuid, const QImage& image)
+{
+    addCustomIcon(uuid, encodeImage(image));
+}
+
+/**
+ * Add a custom icon from its encoded data, e.g. PNG. The data is stored
+ * and saved unchanged, it is only decoded when the icon is displayed.
+ */
+void Metadata::addCustomIcon(const QUuid& uuid, const QByteArray& iconData)
 {
     Q_ASSERT(!uuid.isNull());
-    Q_ASSERT(!m_customIconsRaw.contains(uuid));
+    Q_ASSERT(!m_customIconsData.contains(uuid));
 
-    m_customIconsRaw[uuid] = image;
+    m_customIconsData[uuid] = iconData;
+    m_customIcons.remove(uuid);
     // remove all uuids to prevent duplicates in release mode
     m_customIconsOrder.removeAll(uuid);
     m_customIconsOrder.append(uuid);
-    // Associate image hash to uuid
-    QByteArray hash = hashImage(image);
-    m_customIconsHashes[hash] = uuid;
-    Q_ASSERT(m_customIconsRaw.count() == m_customIconsOrder.count());
-
-    // TODO: This check can go away when we move all QIcon handling outside of core
-    // On older versions of Qt, loading a QPixmap from QImage outside of a GUI
-    // environment causes ASAN to fail and crash on nullptr violation
-    static bool isGui = qApp->inherits("QGuiApplication");
-    if (isGui) {
-        // Generate QIcon with pre-baked resolutions
-        auto basePixmap = QPixmap::fromImage(image.scaled(64, 64, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
-        QIcon icon(basePixmap);
-        m_customIcons.insert(uuid, icon);
-    } else {
-        m_customIcons.insert(uuid, QIcon());
-    }
+    // Associate data hash to uuid
+    m_customIconsHashes[hashIconData(iconData)] = uuid;
+    Q_ASSERT(m_customIconsData.count() == m_customIconsOrder.count());
 
     emitModified();
 }
@@ -390,25 +421,32 @@ void Metadata::addCustomIcon(const QUuid& uuid, const QImage& image)
 void Metadata::removeCustomIcon(const QUuid& uuid)
 {
     Q_ASSERT(!uuid.isNull());
-    Q_ASSERT(m_customIconsRaw.contains(uuid));
+    Q_ASSERT(m_customIconsData.contains(uuid));
 
     // Remove hash record only if this is the same uuid
-    QByteArray hash = hashImage(m_customIconsRaw[uuid]);
+    QByteArray hash = hashIconData(m_customIconsData[uuid]);
     if (m_customIconsHashes.contains(hash) && m_customIconsHashes[hash] == uuid) {
         m_customIconsHashes.remove(hash);
     }
 
     m_customIcons.remove(uuid);
-    m_customIconsRaw.remove(uuid);
+    m_customIconsData.remove(uuid);
     m_customIconsOrder.removeAll(uuid);
-    Q_ASSERT(m_customIconsRaw.count() == m_customIconsOrder.count());
+    Q_ASSERT(m_customIconsData.count() == m_customIconsOrder.count());
     emitModified();
 }
 
+/**
+ * Find an icon with the same encoded data as the image would have when added.
+ */
 QUuid Metadata::findCustomIcon(const QImage& candidate)
 {
-    QByteArray hash = hashImage(candidate);
-    return m_customIconsHashes.value(hash, QUuid());
+    return findCustomIcon(encodeImage(candidate));
+}
+
+QUuid Metadata::findCustomIcon(const QByteArray& candidate)
+{
+    return m_customIconsHashes.value(hashIconData(candidate), QUuid());
 }
 
 void Metadata::copyCustomIcons(const QSet<QUuid>& iconList, const Metadata* otherMetadata)
@@ -417,19 +455,23 @@ void Metadata::copyCustomIcons(const QSet<QUuid>& iconList, const Metadata* othe
         Q_ASSERT(otherMetadata->hasCustomIcon(uuid));
 
         if (!hasCustomIcon(uuid) && otherMetadata->hasCustomIcon(uuid)) {
-            addCustomIcon(uuid, otherMetadata->customIcon(uuid));
+            addCustomIcon(uuid, otherMetadata->customIconData(uuid));
         }
     }
 }
 
-QByteArray Metadata::hashImage(const QImage& image)
+QByteArray Metadata::encodeImage(const QImage& image)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    return data;
+}
+
+QByteArray Metadata::hashIconData(const QByteArray& iconData)
 {
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-    auto data = QByteArray(reinterpret_cast<const char*>(image.bits()), static_cast<int>(image.sizeInBytes()));
-#else
-    auto data = QByteArray(reinterpret_cast<const char*>(image.bits()), image.byteCount());
-#endif
-    return QCryptographicHash::hash(data, QCryptographicHash::Md5);
+    return QCryptographicHash::hash(iconData, QCryptographicHash::Md5);
 }
 
 void Metadata::setRecycleBinEnabled(bool value)
@@ -18,6 +18,7 @@
 #ifndef KEEPASSX_METADATA_H
 #define KEEPASSX_METADATA_H
 
+#include <QCache>
 #include <QDateTime>
 #include <QIcon>
 #include <QPointer>
@@ -79,6 +80,7 @@ public:
     bool protectUrl() const;
     bool protectNotes() const;
     QImage customIcon(const QUuid& uuid) const;
+    QByteArray customIconData(const QUuid& uuid) const;
     bool hasCustomIcon(const QUuid& uuid) const;
     QPixmap customIconPixmap(const QUuid& uuid, IconSize size = IconSize::Default) const;
     QHash<QUuid, QPixmap> customIconsPixmaps(IconSize size = IconSize::Default) const;
@@ -118,9 +120,11 @@ public:
     void setProtectUrl(bool value);
     void setProtectNotes(bool value);
     void addCustomIcon(const QUuid& uuid, const QImage& image);
+    void addCustomIcon(const QUuid& uuid, const QByteArray& iconData);
     void removeCustomIcon(const QUuid& uuid);
     void copyCustomIcons(const QSet<QUuid>& iconList, const Metadata* otherMetadata);
     QUuid findCustomIcon(const QImage& candidate);
+    QUuid findCustomIcon(const QByteArray& candidate);
     void setRecycleBinEnabled(bool value);
     void setRecycleBin(Group* group);
     void setRecycleBinChanged(const QDateTime& value);
@@ -148,12 +152,14 @@ private:
     template <class P, class V> bool set(P& property, const V& value);
     template <class P, class V> bool set(P& property, const V& value, QDateTime& dateTime);
 
-    QByteArray hashImage(const QImage& image);
+    static QByteArray encodeImage(const QImage& image);
+    static QByteArray hashIconData(const QByteArray& iconData);
 
     MetadataData m_data;
 
-    QHash<QUuid, QIcon> m_customIcons;
-    QHash<QUuid, QImage> m_customIconsRaw;
+    // Icons are kept as they are stored in the database and only decoded for display
+    QHash<QUuid, QByteArray> m_customIconsData;
+    mutable QCache<QUuid, QIcon> m_customIcons;
     QList<QUuid> m_customIconsOrder;
     QHash<QByteArray, QUuid> m_customIconsHashes;
 
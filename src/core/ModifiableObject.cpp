@@ -17,8 +17,12 @@
 
 #include "ModifiableObject.h"
 
+#include <atomic>
+
 namespace
 {
+    std::atomic<quint64> g_lastRevision{0};
+
     template <typename T> T findParent(const QObject* obj)
     {
         if (!obj) {
@@ -57,8 +61,27 @@ void ModifiableObject::setEmitModified(bool value)
     }
 }
 
+quint64 ModifiableObject::revision() const
+{
+    return m_revision;
+}
+
+/**
+ * @brief mark the data as changed without emitting the modified signal.
+ */
+void ModifiableObject::updateRevision()
+{
+    m_revision = nextRevision();
+}
+
+quint64 ModifiableObject::nextRevision()
+{
+    return ++g_lastRevision;
+}
+
 void ModifiableObject::emitModified()
 {
+    updateRevision();
     if (modifiedSignalEnabled()) {
         emit modified();
     }
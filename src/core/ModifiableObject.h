@@ -34,6 +34,12 @@ public:
      */
     bool modifiedSignalEnabled() const;
 
+    /**
+     * @brief revision of the object's data, unique across all objects.
+     * The revision changes on every modification, even while the modified signal is disabled.
+     */
+    quint64 revision() const;
+
 public slots:
     /**
      * @brief set whether the modified signal should be emitted from this object and all its children.
@@ -47,13 +53,17 @@ public slots:
 
 protected:
     void emitModified();
+    void updateRevision();
 
 signals:
     void modified();
     void emitModifiedChanged(bool value);
 
 private:
+    static quint64 nextRevision();
+
     bool m_emitModified{true};
+    quint64 m_revision{nextRevision()};
 };
 
 #endif // KEEPASSXC_MODIFIABLEOBJECT_H
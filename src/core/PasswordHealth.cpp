@@ -15,12 +15,25 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QCryptographicHash>
 #include <QString>
 
 #include "Group.h"
+#include "core/Clock.h"
+#include "crypto/Random.h"
 #include "PasswordHealth.h"
 #include "zxcvbn.h"
 
+namespace
+{
+    // Salt of the password hashes kept by PasswordHealthCache, unique to this process
+    const QByteArray& cacheSalt()
+    {
+        static const QByteArray salt = randomGen()->randomArray(32);
+        return salt;
+    }
+} // namespace
+
 PasswordHealth::PasswordHealth(double entropy)
     : m_score(entropy)
     , m_entropy(entropy)
@@ -92,11 +105,54 @@ PasswordHealth::Quality PasswordHealth::quality() const
     return Quality::Excellent;
 }
 
+/**
+ * Entropy of the given password, evaluated only if it is not cached yet.
+ */
+PasswordHealthCache::PasswordHealthCache(int maxSize)
+    : m_entropies(maxSize)
+{
+}
+
+double PasswordHealthCache::entropy(const QString& pwd)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(cacheSalt());
+    hash.addData(pwd.toUtf8());
+    const QByteArray key = hash.result();
+    {
+        QMutexLocker locker(&m_mutex);
+        const double* cached = m_entropies.object(key);
+        if (cached) {
+            return *cached;
+        }
+    }
+
+    // Evaluate without holding the lock so that other threads are not blocked
+    const double entropy = PasswordHealth(pwd).entropy();
+
+    QMutexLocker locker(&m_mutex);
+    m_entropies.insert(key, new double(entropy));
+    return entropy;
+}
+
+int PasswordHealthCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entropies.size();
+}
+
+void PasswordHealthCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entropies.clear();
+}
+
 /**
  * This class provides additional information about password health
  * than can be derived from the password itself (re-use, expiry).
  */
 HealthChecker::HealthChecker(QSharedPointer<Database> db)
+    : m_db(db)
 {
     // Build the cache of re-used passwords
     for (const auto* entry : db->rootGroup()->entriesRecursive()) {
@@ -120,13 +176,21 @@ QSharedPointer<PasswordHealth> HealthChecker::evaluate(const Entry* entry) const
         return {};
     }
 
+    return evaluate(entry->password(), entry->timeInfo());
+}
+
+/**
+ * Returns the health of a password with the given expiry, for callers
+ * that must not touch the entry from another thread.
+ */
+QSharedPointer<PasswordHealth> HealthChecker::evaluate(const QString& pwd, const TimeInfo& timeInfo) const
+{
     // First analyse the password itself
-    const auto pwd = entry->password();
-    auto health = QSharedPointer<PasswordHealth>(new PasswordHealth(pwd));
+    auto health = QSharedPointer<PasswordHealth>(new PasswordHealth(m_db->passwordHealthCache()->entropy(pwd)));
 
     // Second, if the password is in the database more than once,
     // reduce the score accordingly
-    const auto& used = m_reuse[pwd];
+    const auto used = m_reuse.value(pwd);
     const auto count = used.size();
     if (count > 1) {
         constexpr auto penalty = 15;
@@ -151,13 +215,13 @@ QSharedPointer<PasswordHealth> HealthChecker::evaluate(const Entry* entry) const
     // Third, if the password has already expired, reduce score to 0;
     // or, if the password is going to expire in the next 30 days,
     // reduce score by 2 points per day.
-    if (entry->isExpired()) {
+    if (timeInfo.expires() && timeInfo.expiryTime() < Clock::currentDateTimeUtc()) {
         health->setScore(0);
         health->addScoreReason(QObject::tr("Password has expired"));
         health->addScoreDetails(QObject::tr("Password expiry was %1")
-                                    .arg(entry->timeInfo().expiryTime().toString(Qt::DefaultLocaleShortDate)));
-    } else if (entry->timeInfo().expires()) {
-        const int days = QDateTime::currentDateTime().daysTo(entry->timeInfo().expiryTime());
+                                    .arg(timeInfo.expiryTime().toString(Qt::DefaultLocaleShortDate)));
+    } else if (timeInfo.expires()) {
+        const int days = QDateTime::currentDateTime().daysTo(timeInfo.expiryTime());
         if (days <= 30) {
             // First bring the score down into the "weak" range
             // so that the entry appears in Health Check. Then
@@ -170,7 +234,7 @@ QSharedPointer<PasswordHealth> HealthChecker::evaluate(const Entry* entry) const
 
             health->adjustScore((30 - days) * -2);
             health->addScoreDetails(QObject::tr("Password expires on %1")
-                                        .arg(entry->timeInfo().expiryTime().toString(Qt::DefaultLocaleShortDate)));
+                                        .arg(timeInfo.expiryTime().toString(Qt::DefaultLocaleShortDate)));
             if (days <= 2) {
                 health->addScoreReason(QObject::tr("Password is about to expire"));
             } else if (days <= 10) {
@@ -18,11 +18,14 @@
 #ifndef KEEPASSX_PASSWORDHEALTH_H
 #define KEEPASSX_PASSWORDHEALTH_H
 
+#include <QCache>
 #include <QHash>
+#include <QMutex>
 #include <QSharedPointer>
 
 class Database;
 class Entry;
+class TimeInfo;
 
 /**
  * Health status of a single password.
@@ -89,6 +92,32 @@ private:
     QStringList m_scoreDetails;
 };
 
+/**
+ * Entropy of the passwords of one database.
+ *
+ * Evaluating a password is expensive, so the result is shared by all
+ * entries and reports that use the same password. Values are keyed by
+ * a salted hash of the password, the salt is random for every process.
+ * A changed password simply misses the cache, the least recently used
+ * values are dropped once the cache is full.
+ * The cache is safe to use from multiple threads.
+ */
+class PasswordHealthCache
+{
+public:
+    static const int DefaultMaxSize = 10000;
+
+    explicit PasswordHealthCache(int maxSize = DefaultMaxSize);
+
+    double entropy(const QString& pwd);
+    int size() const;
+    void clear();
+
+private:
+    mutable QMutex m_mutex;
+    QCache<QByteArray, double> m_entropies;
+};
+
 /**
  * Password health check for all entries of a database.
  *
@@ -99,10 +128,12 @@ class HealthChecker
 public:
     explicit HealthChecker(QSharedPointer<Database>);
 
-    // Get the health status of an entry in the database
+    // Get the health status of an entry in the database, safe to call from multiple threads
     QSharedPointer<PasswordHealth> evaluate(const Entry* entry) const;
+    QSharedPointer<PasswordHealth> evaluate(const QString& password, const TimeInfo& timeInfo) const;
 
 private:
+    QSharedPointer<Database> m_db;
     // To determine password re-use: first = password, second = entries that use it
     QHash<QString, QStringList> m_reuse;
 };
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PlaceholderCache.h"
+
+#include "core/Global.h"
+
+/**
+ * Look up a previously resolved value.
+ *
+ * @param entry entry the text was resolved for
+ * @param text text containing the placeholders
+ * @param multiple true if all placeholders of the text were resolved
+ * @param value the cached value
+ * @return true if the value was found
+ */
+bool PlaceholderCache::value(const Entry* entry, const QString& text, bool multiple, QString& value) const
+{
+    QReadLocker locker(&m_lock);
+    auto it = m_values.constFind({entry, text, multiple});
+    if (it == m_values.constEnd()) {
+        return false;
+    }
+    value = it.value();
+    return true;
+}
+
+/**
+ * The generation changes on every invalidation. Pass the generation from
+ * before resolving a value to insert() so that values resolved while the
+ * database changed are not cached.
+ */
+quint64 PlaceholderCache::generation() const
+{
+    QReadLocker locker(&m_lock);
+    return m_generation;
+}
+
+void PlaceholderCache::insert(const Entry* entry,
+                              const QString& text,
+                              bool multiple,
+                              const QString& value,
+                              const QSet<const Entry*>& dependencies,
+                              bool dependsOnAll,
+                              quint64 generation)
+{
+    QWriteLocker locker(&m_lock);
+    if (generation != m_generation) {
+        return;
+    }
+
+    Key key{entry, text, multiple};
+    m_values.insert(key, value);
+    for (const auto dependency : dependencies) {
+        m_dependents[dependency].append(key);
+    }
+    if (dependsOnAll) {
+        m_globalDependents.append(key);
+    }
+}
+
+/**
+ * Drop all values that were resolved from the given entry.
+ */
+void PlaceholderCache::invalidate(const Entry* entry)
+{
+    QWriteLocker locker(&m_lock);
+    ++m_generation;
+
+    for (const auto& key : m_dependents.take(entry)) {
+        m_values.remove(key);
+    }
+    for (const auto& key : asConst(m_globalDependents)) {
+        m_values.remove(key);
+    }
+    m_globalDependents.clear();
+}
+
+void PlaceholderCache::clear()
+{
+    QWriteLocker locker(&m_lock);
+    ++m_generation;
+
+    m_values.clear();
+    m_dependents.clear();
+    m_globalDependents.clear();
+}
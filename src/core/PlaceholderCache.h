@@ -0,0 +1,77 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSX_PLACEHOLDERCACHE_H
+#define KEEPASSX_PLACEHOLDERCACHE_H
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+class Entry;
+
+/**
+ * Resolved placeholder values of the entries of one database.
+ *
+ * Every value remembers the entries it was resolved from and is dropped
+ * as soon as one of them changes. Values that depend on the search for
+ * an entry by a field other than its uuid are dropped on any change.
+ * The cache is safe to use from multiple threads.
+ */
+class PlaceholderCache
+{
+public:
+    bool value(const Entry* entry, const QString& text, bool multiple, QString& value) const;
+    quint64 generation() const;
+    void insert(const Entry* entry,
+                const QString& text,
+                bool multiple,
+                const QString& value,
+                const QSet<const Entry*>& dependencies,
+                bool dependsOnAll,
+                quint64 generation);
+    void invalidate(const Entry* entry);
+    void clear();
+
+private:
+    struct Key
+    {
+        const Entry* entry;
+        QString text;
+        bool multiple;
+
+        bool operator==(const Key& other) const
+        {
+            return entry == other.entry && multiple == other.multiple && text == other.text;
+        }
+
+        friend uint qHash(const Key& key, uint seed = 0)
+        {
+            return qHash(key.entry, seed) ^ qHash(key.text, seed) ^ static_cast<uint>(key.multiple);
+        }
+    };
+
+    mutable QReadWriteLock m_lock;
+    QHash<Key, QString> m_values;
+    QHash<const Entry*, QVector<Key>> m_dependents;
+    QVector<Key> m_globalDependents;
+    quint64 m_generation = 0;
+};
+
+#endif // KEEPASSX_PLACEHOLDERCACHE_H
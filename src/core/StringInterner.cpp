@@ -0,0 +1,81 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StringInterner.h"
+
+/**
+ * @return a string equal to str that shares its data with all earlier equal strings
+ */
+QString StringInterner::intern(const QString& str)
+{
+    if (str.isEmpty() || str.size() > MaxLength) {
+        return str;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_enabled) {
+        return str;
+    }
+    auto it = m_strings.constFind(str);
+    if (it == m_strings.constEnd()) {
+        return *m_strings.insert(str);
+    }
+    if (it->constData() != str.constData()) {
+        m_sharedBytes += str.size() * static_cast<qint64>(sizeof(QChar));
+    }
+    return *it;
+}
+
+bool StringInterner::isEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+/**
+ * While disabled, intern() returns its argument unchanged.
+ */
+void StringInterner::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_enabled = enabled;
+}
+
+int StringInterner::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_strings.size();
+}
+
+/**
+ * @return bytes of string data that did not have to be stored again
+ */
+qint64 StringInterner::sharedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sharedBytes;
+}
+
+/**
+ * Forget all strings, strings that were already interned keep sharing their data.
+ */
+void StringInterner::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_strings.clear();
+    m_sharedBytes = 0;
+}
@@ -0,0 +1,53 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_STRINGINTERNER_H
+#define KEEPASSXC_STRINGINTERNER_H
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+/**
+ * Shared copies of the strings that repeat across the entries and groups of
+ * one database: attribute keys, tags and group names.
+ *
+ * Equal strings passed to intern() share their data. Interned strings stay in
+ * memory until the database is closed, so attribute values are never passed
+ * here. The interner is safe to use from multiple threads.
+ */
+class StringInterner
+{
+public:
+    // Longer strings are rarely repeated and are not worth keeping
+    static const int MaxLength = 128;
+
+    QString intern(const QString& str);
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+    int size() const;
+    qint64 sharedBytes() const;
+    void clear();
+
+private:
+    mutable QMutex m_mutex;
+    QSet<QString> m_strings;
+    qint64 m_sharedBytes = 0;
+    bool m_enabled = true;
+};
+
+#endif // KEEPASSXC_STRINGINTERNER_H
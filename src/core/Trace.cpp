@@ -0,0 +1,141 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Trace.h"
+
+#include "core/Global.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        qint64 start;
+        qint64 duration;
+        quintptr thread;
+    };
+
+    QMutex s_mutex;
+    QElapsedTimer s_timer;
+    QString s_filePath;
+    QVector<Event> s_events;
+    bool s_stopAtExit = false;
+
+    void stopAtExit()
+    {
+        QString error;
+        if (!Trace::stop(&error)) {
+            qWarning("Failed to write trace: %s", qPrintable(error));
+        }
+    }
+} // namespace
+
+std::atomic<bool> Trace::s_enabled(false);
+
+/**
+ * Start recording, events recorded before are discarded.
+ *
+ * @param filePath trace file that is written by stop() or at exit
+ */
+void Trace::start(const QString& filePath)
+{
+    QMutexLocker locker(&s_mutex);
+    s_filePath = filePath;
+    s_events.clear();
+    if (!s_timer.isValid()) {
+        s_timer.start();
+    }
+    if (!s_stopAtExit) {
+        qAddPostRoutine(stopAtExit);
+        s_stopAtExit = true;
+    }
+    s_enabled.store(true, std::memory_order_release);
+}
+
+void Trace::startFromEnvironment()
+{
+    const QString filePath = QString::fromLocal8Bit(qgetenv("KEEPASSXC_TRACE"));
+    if (!filePath.isEmpty()) {
+        start(filePath);
+    }
+}
+
+/**
+ * Stop recording and write all events to the trace file.
+ *
+ * @return false if the trace file could not be written
+ */
+bool Trace::stop(QString* error)
+{
+    QMutexLocker locker(&s_mutex);
+    if (!s_enabled.exchange(false)) {
+        return true;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    for (const Event& event : asConst(s_events)) {
+        // Chrome expects microseconds
+        events.append(QJsonObject{{"name", QString::fromLatin1(event.name)},
+                                  {"cat", "keepassxc"},
+                                  {"ph", "X"},
+                                  {"ts", event.start / 1000.0},
+                                  {"dur", event.duration / 1000.0},
+                                  {"pid", pid},
+                                  {"tid", static_cast<qint64>(event.thread)}});
+    }
+    s_events.clear();
+
+    QFile file(s_filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || file.write(QJsonDocument(QJsonObject{{"traceEvents", events}, {"displayTimeUnit", "ms"}}).toJson(
+               QJsonDocument::Compact))
+               < 0) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+qint64 Trace::now()
+{
+    return s_timer.nsecsElapsed();
+}
+
+void Trace::record(const char* name, qint64 start)
+{
+    const qint64 end = now();
+    const auto thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+    QMutexLocker locker(&s_mutex);
+    // Scopes that were open while tracing stopped are dropped
+    if (isEnabled()) {
+        s_events.append({name, start, end - start, thread});
+    }
+}
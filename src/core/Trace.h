@@ -0,0 +1,76 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_TRACE_H
+#define KEEPASSXC_TRACE_H
+
+#include <QString>
+
+#include <atomic>
+
+/**
+ * Records how long slow operations take and writes them as a Chrome
+ * trace_event JSON file, which can be opened in chrome://tracing or Perfetto.
+ *
+ * Tracing is started by setting KEEPASSXC_TRACE to the path of the trace
+ * file, or with the --trace option of the GUI. The file is written when the
+ * application exits. While tracing is off a Scope costs one atomic load.
+ */
+class Trace
+{
+public:
+    class Scope
+    {
+    public:
+        // The name must be a string literal, only the pointer is kept
+        explicit Scope(const char* name)
+            : m_name(Trace::isEnabled() ? name : nullptr)
+            , m_start(m_name ? Trace::now() : 0)
+        {
+        }
+
+        ~Scope()
+        {
+            if (m_name) {
+                Trace::record(m_name, m_start);
+            }
+        }
+
+        Q_DISABLE_COPY(Scope)
+
+    private:
+        const char* const m_name;
+        const qint64 m_start;
+    };
+
+    static bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_acquire);
+    }
+
+    static void start(const QString& filePath);
+    static void startFromEnvironment();
+    static bool stop(QString* error = nullptr);
+
+private:
+    static qint64 now();
+    static void record(const char* name, qint64 start);
+
+    static std::atomic<bool> s_enabled;
+};
+
+#endif // KEEPASSXC_TRACE_H
@@ -19,6 +19,7 @@
 
 #include <QtConcurrent>
 
+#include "core/Trace.h"
 #include "crypto/CryptoHash.h"
 #include "crypto/SymmetricCipher.h"
 #include "format/KeePass2.h"
@@ -62,6 +63,7 @@ QVariantMap AesKdf::writeParameters()
 
 bool AesKdf::transform(const QByteArray& raw, QByteArray& result) const
 {
+    Trace::Scope trace("AesKdf::transform");
     QByteArray resultLeft;
     QByteArray resultRight;
 
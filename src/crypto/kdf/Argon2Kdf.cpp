@@ -20,6 +20,7 @@
 #include <QThread>
 #include <botan/pwdhash.h>
 
+#include "core/Trace.h"
 #include "format/KeePass2.h"
 
 /**
@@ -161,6 +162,7 @@ QVariantMap Argon2Kdf::writeParameters()
 
 bool Argon2Kdf::transform(const QByteArray& raw, QByteArray& result) const
 {
+    Trace::Scope trace("Argon2Kdf::transform");
     result.clear();
     result.resize(32);
     try {
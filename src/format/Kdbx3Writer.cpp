@@ -51,7 +51,7 @@ bool Kdbx3Writer::writeDatabase(QIODevice* device, Database* db)
         return false;
     }
 
-    if (!db->setKey(db->key(), false, true)) {
+    if (!db->rotateTransformSeed()) {
         raiseError(tr("Unable to calculate database key"));
         return false;
     }
@@ -19,6 +19,7 @@
 
 #include <QBuffer>
 #include <QJsonObject>
+#include <limits>
 
 #include "core/AsyncTask.h"
 #include "core/Endian.h"
@@ -27,6 +28,7 @@
 #include "format/KdbxXmlReader.h"
 #include "format/KeePass2RandomStream.h"
 #include "streams/HmacBlockStream.h"
+#include "streams/PipelineStream.h"
 #include "streams/StoreDataStream.h"
 #include "streams/SymmetricCipherStream.h"
 #include "streams/qtiocompressor.h"
@@ -90,7 +92,14 @@ bool Kdbx4Reader::readDatabaseImpl(QIODevice* device,
         raiseError(tr("Unknown cipher"));
         return false;
     }
-    SymmetricCipherStream cipherStream(&hmacStream);
+    // Verify block HMACs, decrypt and inflate ahead of the parser, each on its own thread
+    PipelineStream hmacPipeline(&hmacStream);
+    if (!hmacPipeline.open(QIODevice::ReadOnly)) {
+        raiseError(hmacPipeline.errorString());
+        return false;
+    }
+
+    SymmetricCipherStream cipherStream(&hmacPipeline);
     if (!cipherStream.init(mode, SymmetricCipher::Decrypt, finalKey, m_encryptionIV)) {
         raiseError(cipherStream.errorString());
         return false;
@@ -99,21 +108,32 @@ bool Kdbx4Reader::readDatabaseImpl(QIODevice* device,
         raiseError(cipherStream.errorString());
         return false;
     }
+    PipelineStream cipherPipeline(&cipherStream);
+    if (!cipherPipeline.open(QIODevice::ReadOnly)) {
+        raiseError(cipherPipeline.errorString());
+        return false;
+    }
     // clang-format on
 
     QIODevice* xmlDevice = nullptr;
     QScopedPointer<QtIOCompressor> ioCompressor;
+    QScopedPointer<PipelineStream> compressorPipeline;
 
     if (db->compressionAlgorithm() == Database::CompressionNone) {
-        xmlDevice = &cipherStream;
+        xmlDevice = &cipherPipeline;
     } else {
-        ioCompressor.reset(new QtIOCompressor(&cipherStream));
+        ioCompressor.reset(new QtIOCompressor(&cipherPipeline));
         ioCompressor->setStreamFormat(QtIOCompressor::GzipFormat);
         if (!ioCompressor->open(QIODevice::ReadOnly)) {
             raiseError(ioCompressor->errorString());
             return false;
         }
-        xmlDevice = ioCompressor.data();
+        compressorPipeline.reset(new PipelineStream(ioCompressor.data()));
+        if (!compressorPipeline->open(QIODevice::ReadOnly)) {
+            raiseError(compressorPipeline->errorString());
+            return false;
+        }
+        xmlDevice = compressorPipeline.data();
     }
 
     while (readInnerHeaderField(xmlDevice) && !hasError()) {
@@ -262,6 +282,10 @@ bool Kdbx4Reader::readInnerHeaderField(QIODevice* device)
         return false;
     }
 
+    if (fieldID == KeePass2::InnerHeaderFieldID::Binary) {
+        return readInnerHeaderBinary(device, fieldLen);
+    }
+
     QByteArray fieldData;
     if (fieldLen != 0) {
         fieldData = device->read(fieldLen);
@@ -283,17 +307,44 @@ bool Kdbx4Reader::readInnerHeaderField(QIODevice* device)
         setProtectedStreamKey(fieldData);
         break;
 
-    case KeePass2::InnerHeaderFieldID::Binary: {
-        if (fieldLen < 1) {
-            raiseError(tr("Invalid inner header binary size"));
-            return false;
-        }
-        auto data = fieldData.mid(1);
-        m_binaryPool.insert(QString::number(m_binaryPool.size()), data);
+    default:
         break;
     }
+
+    return true;
+}
+
+/**
+ * Read an inner header binary into the binary pool.
+ *
+ * The flags byte is consumed separately so the content is read straight into
+ * the buffer that the attachment store keeps, without further copies.
+ *
+ * @param device input device
+ * @param fieldLen length of the field including the flags byte
+ * @return true if the binary was read successfully
+ */
+bool Kdbx4Reader::readInnerHeaderBinary(QIODevice* device, quint32 fieldLen)
+{
+    char flags;
+    if (fieldLen < 1 || fieldLen - 1 > static_cast<quint32>(std::numeric_limits<int>::max())
+        || !device->getChar(&flags)) {
+        raiseError(tr("Invalid inner header binary size"));
+        return false;
+    }
+    Q_UNUSED(flags);
+
+    QByteArray data;
+    const int dataLen = static_cast<int>(fieldLen - 1);
+    if (dataLen != 0) {
+        data.resize(dataLen);
+        if (device->read(data.data(), dataLen) != dataLen) {
+            raiseError(tr("Invalid header data length"));
+            return false;
+        }
     }
 
+    m_binaryPool.insert(QString::number(m_binaryPool.size()), attachmentStore()->store(std::move(data)));
     return true;
 }
 
@@ -432,7 +483,7 @@ QVariantMap Kdbx4Reader::readVariantMap(QIODevice* device)
 /**
  * @return mapping from attachment keys to binary data
  */
-QHash<QString, QByteArray> Kdbx4Reader::binaryPool() const
+QHash<QString, QSharedPointer<const AttachmentData>> Kdbx4Reader::binaryPool() const
 {
     return m_binaryPool;
 }
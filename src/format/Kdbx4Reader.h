@@ -18,6 +18,7 @@
 #ifndef KEEPASSX_KDBX4READER_H
 #define KEEPASSX_KDBX4READER_H
 
+#include "core/AttachmentStore.h"
 #include "format/KdbxReader.h"
 
 /**
@@ -32,16 +33,17 @@ public:
                           const QByteArray& headerData,
                           QSharedPointer<const CompositeKey> key,
                           Database* db) override;
-    QHash<QString, QByteArray> binaryPool() const;
+    QHash<QString, QSharedPointer<const AttachmentData>> binaryPool() const;
 
 protected:
     bool readHeaderField(StoreDataStream& headerStream, Database* db) override;
 
 private:
     bool readInnerHeaderField(QIODevice* device);
+    bool readInnerHeaderBinary(QIODevice* device, quint32 fieldLen);
     QVariantMap readVariantMap(QIODevice* device);
 
-    QHash<QString, QByteArray> m_binaryPool;
+    QHash<QString, QSharedPointer<const AttachmentData>> m_binaryPool;
 };
 
 #endif // KEEPASSX_KDBX4READER_H
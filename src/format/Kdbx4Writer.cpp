@@ -24,6 +24,7 @@
 #include "format/KdbxXmlWriter.h"
 #include "format/KeePass2RandomStream.h"
 #include "streams/HmacBlockStream.h"
+#include "streams/PipelineStream.h"
 #include "streams/SymmetricCipherStream.h"
 #include "streams/qtiocompressor.h"
 
@@ -48,7 +49,7 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
     QByteArray protectedStreamKey = randomGen()->randomArray(64);
     QByteArray endOfHeader = "\r\n\r\n";
 
-    if (!db->setKey(db->key(), false, true)) {
+    if (!db->rotateTransformSeed()) {
         raiseError(tr("Unable to calculate database key: %1").arg(db->keyError()));
         return false;
     }
@@ -112,7 +113,9 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
     CHECK_RETURN_FALSE(writeData(device, headerHmac));
 
     QScopedPointer<HmacBlockStream> hmacBlockStream;
+    QScopedPointer<PipelineStream> hmacPipeline;
     QScopedPointer<SymmetricCipherStream> cipherStream;
+    QScopedPointer<PipelineStream> cipherPipeline;
 
     hmacBlockStream.reset(new HmacBlockStream(device, hmacKey));
     if (!hmacBlockStream->open(QIODevice::WriteOnly)) {
@@ -120,7 +123,14 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
         return false;
     }
 
-    cipherStream.reset(new SymmetricCipherStream(hmacBlockStream.data()));
+    // Compress, encrypt and authenticate behind the serializer, each on its own thread
+    hmacPipeline.reset(new PipelineStream(hmacBlockStream.data()));
+    if (!hmacPipeline->open(QIODevice::WriteOnly)) {
+        raiseError(hmacPipeline->errorString());
+        return false;
+    }
+
+    cipherStream.reset(new SymmetricCipherStream(hmacPipeline.data()));
 
     if (!cipherStream->init(mode, SymmetricCipher::Encrypt, finalKey, encryptionIV)) {
         raiseError(cipherStream->errorString());
@@ -131,19 +141,31 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
         return false;
     }
 
+    cipherPipeline.reset(new PipelineStream(cipherStream.data()));
+    if (!cipherPipeline->open(QIODevice::WriteOnly)) {
+        raiseError(cipherPipeline->errorString());
+        return false;
+    }
+
     QIODevice* outputDevice = nullptr;
     QScopedPointer<QtIOCompressor> ioCompressor;
+    QScopedPointer<PipelineStream> compressorPipeline;
 
     if (db->compressionAlgorithm() == Database::CompressionNone) {
-        outputDevice = cipherStream.data();
+        outputDevice = cipherPipeline.data();
     } else {
-        ioCompressor.reset(new QtIOCompressor(cipherStream.data()));
+        ioCompressor.reset(new QtIOCompressor(cipherPipeline.data()));
         ioCompressor->setStreamFormat(QtIOCompressor::GzipFormat);
         if (!ioCompressor->open(QIODevice::WriteOnly)) {
             raiseError(ioCompressor->errorString());
             return false;
         }
-        outputDevice = ioCompressor.data();
+        compressorPipeline.reset(new PipelineStream(ioCompressor.data()));
+        if (!compressorPipeline->open(QIODevice::WriteOnly)) {
+            raiseError(compressorPipeline->errorString());
+            return false;
+        }
+        outputDevice = compressorPipeline.data();
     }
 
     Q_ASSERT(outputDevice);
@@ -171,13 +193,25 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
 
     // Explicitly close/reset streams so they are flushed and we can detect
     // errors. QIODevice::close() resets errorString() etc.
+    if (compressorPipeline && !compressorPipeline->reset()) {
+        raiseError(compressorPipeline->errorString());
+        return false;
+    }
     if (ioCompressor) {
         ioCompressor->close();
     }
+    if (!cipherPipeline->reset()) {
+        raiseError(cipherPipeline->errorString());
+        return false;
+    }
     if (!cipherStream->reset()) {
         raiseError(cipherStream->errorString());
         return false;
     }
+    if (!hmacPipeline->reset()) {
+        raiseError(hmacPipeline->errorString());
+        return false;
+    }
     if (!hmacBlockStream->reset()) {
         raiseError(hmacBlockStream->errorString());
         return false;
@@ -211,24 +245,30 @@ bool Kdbx4Writer::writeInnerHeaderField(QIODevice* device, KeePass2::InnerHeader
     return true;
 }
 
-void Kdbx4Writer::writeAttachments(QIODevice* device, Database* db)
+/**
+ * Write a binary to the inner header. The flags byte is written on its own
+ * so the attachment data does not need to be copied.
+ */
+bool Kdbx4Writer::writeInnerHeaderBinary(QIODevice* device, const QByteArray& data)
 {
-    const QList<Entry*> allEntries = db->rootGroup()->entriesRecursive(true);
-    QSet<QByteArray> writtenAttachments;
-
-    for (Entry* entry : allEntries) {
-        const QList<QString> attachmentKeys = entry->attachments()->keys();
-        for (const QString& key : attachmentKeys) {
-            QByteArray data("\x01");
-            data.append(entry->attachments()->value(key));
+    QByteArray header;
+    header.append(static_cast<char>(KeePass2::InnerHeaderFieldID::Binary));
+    header.append(Endian::sizedIntToBytes(static_cast<quint32>(data.size() + 1), KeePass2::BYTEORDER));
+    // Flags byte, the attachment is marked as protected
+    header.append('\x01');
+    CHECK_RETURN_FALSE(writeData(device, header));
+    CHECK_RETURN_FALSE(writeData(device, data));
 
-            if (writtenAttachments.contains(data)) {
-                continue;
-            }
+    return true;
+}
 
-            writeInnerHeaderField(device, KeePass2::InnerHeaderFieldID::Binary, data);
-            writtenAttachments.insert(data);
-        }
+void Kdbx4Writer::writeAttachments(QIODevice* device, Database* db)
+{
+    // Same order as the attachment ids of KdbxXmlWriter
+    const QList<QSharedPointer<const AttachmentData>> attachments = KdbxXmlWriter::binaries(db);
+    for (const auto& attachment : attachments) {
+        // Page spilled attachments in one at a time
+        writeInnerHeaderBinary(device, attachment->data());
     }
 }
 
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "KdbxXmlFragmentCache.h"
+
+#include "core/Entry.h"
+
+/**
+ * Revisions of everything that is serialized for an entry, including its history.
+ * Revisions are unique across objects, so a recreated entry never matches a cached one.
+ */
+QVector<quint64> KdbxXmlFragmentCache::revisions(const Entry* entry)
+{
+    QVector<quint64> result;
+    result << entry->revision() << entry->attributes()->revision() << entry->attachments()->revision()
+           << entry->autoTypeAssociations()->revision() << entry->customData()->revision();
+
+    // A compact history only changes through its entry, which updates the revision of the entry
+    if (!entry->hasCompactHistory()) {
+        const QList<Entry*>& historyItems = entry->historyItems();
+        for (const Entry* item : historyItems) {
+            result << revisions(item);
+        }
+    }
+    return result;
+}
+
+/**
+ * Start a save. All fragments are dropped if they were written in a different context,
+ * e.g. for another format version or with other memory protection settings.
+ *
+ * @param context value that identifies everything besides the entries that fragments depend on
+ */
+void KdbxXmlFragmentCache::beginSave(quint64 context)
+{
+    QMutexLocker locker(&m_mutex);
+    if (context != m_context) {
+        m_fragments.clear();
+        m_context = context;
+    }
+    m_used.clear();
+}
+
+/**
+ * Look up the fragment of an entry.
+ *
+ * @return true if a fragment for the given revisions and depth was found
+ */
+bool KdbxXmlFragmentCache::fragment(const Entry* entry,
+                                    const QVector<quint64>& revisions,
+                                    int depth,
+                                    KdbxXmlFragmentCache::Fragment& fragment)
+{
+    QMutexLocker locker(&m_mutex);
+    m_used.insert(entry);
+    auto it = m_fragments.constFind(entry);
+    if (it == m_fragments.constEnd() || it->depth != depth || it->revisions != revisions) {
+        return false;
+    }
+    fragment = it.value();
+    return true;
+}
+
+void KdbxXmlFragmentCache::insert(const Entry* entry, const KdbxXmlFragmentCache::Fragment& fragment)
+{
+    QMutexLocker locker(&m_mutex);
+    m_fragments.insert(entry, fragment);
+}
+
+/**
+ * Finish a save, fragments of entries that were not written are dropped.
+ */
+void KdbxXmlFragmentCache::endSave()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_fragments.begin(); it != m_fragments.end();) {
+        if (m_used.contains(it.key())) {
+            ++it;
+        } else {
+            it = m_fragments.erase(it);
+        }
+    }
+    m_used.clear();
+}
+
+void KdbxXmlFragmentCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_fragments.clear();
+    m_used.clear();
+}
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSX_KDBXXMLFRAGMENTCACHE_H
+#define KEEPASSX_KDBXXMLFRAGMENTCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+class Entry;
+
+/**
+ * Serialized XML of the entries of one database, kept between saves.
+ *
+ * Fragments hold neither protected values nor attachment ids, the writer
+ * fills these holes in document order on every save so the inner random
+ * stream stays in sync. A fragment is only reused while the revisions of
+ * its entry, the entry's history and all their parts are unchanged.
+ */
+class KdbxXmlFragmentCache
+{
+public:
+    struct Hole
+    {
+        int offset;
+        // Protected attribute of an entry or of its history item at historyIndex,
+        // or the attachment with the given hash
+        const Entry* entry;
+        int historyIndex;
+        QString key;
+        QByteArray attachmentHash;
+    };
+
+    struct Fragment
+    {
+        QVector<quint64> revisions;
+        int depth = 0;
+        QByteArray xml;
+        QVector<Hole> holes;
+    };
+
+    static QVector<quint64> revisions(const Entry* entry);
+
+    void beginSave(quint64 context);
+    bool fragment(const Entry* entry, const QVector<quint64>& revisions, int depth, Fragment& fragment);
+    void insert(const Entry* entry, const Fragment& fragment);
+    void endSave();
+    void clear();
+
+private:
+    mutable QMutex m_mutex;
+    quint64 m_context = 0;
+    QHash<const Entry*, Fragment> m_fragments;
+    QSet<const Entry*> m_used;
+};
+
+#endif // KEEPASSX_KDBXXMLFRAGMENTCACHE_H
@@ -20,7 +20,9 @@
 #include "core/DatabaseIcons.h"
 #include "core/Endian.h"
 #include "core/Group.h"
+#include "core/StringInterner.h"
 #include "core/Tools.h"
+#include "core/Trace.h"
 #include "streams/qtiocompressor.h"
 
 #include <QBuffer>
@@ -40,7 +42,7 @@ KdbxXmlReader::KdbxXmlReader(quint32 version)
  * @param version KDBX version
  * @param binaryPool binary pool
  */
-KdbxXmlReader::KdbxXmlReader(quint32 version, QHash<QString, QByteArray> binaryPool)
+KdbxXmlReader::KdbxXmlReader(quint32 version, QHash<QString, QSharedPointer<const AttachmentData>> binaryPool)
     : m_kdbxVersion(version)
     , m_binaryPool(std::move(binaryPool))
 {
@@ -81,6 +83,7 @@ QSharedPointer<Database> KdbxXmlReader::readDatabase(QIODevice* device)
  */
 void KdbxXmlReader::readDatabase(QIODevice* device, Database* db, KeePass2RandomStream* randomStream)
 {
+    Trace::Scope trace("KdbxXmlReader::readDatabase");
     m_error = false;
     m_errorStr.clear();
 
@@ -120,8 +123,14 @@ void KdbxXmlReader::readDatabase(QIODevice* device, Database* db, KeePass2Random
         qWarning("KdbxXmlReader::readDatabase: found %d invalid entry reference(s)", m_tmpParent->children().size());
     }
 
+    // Histories whose attachments had to wait for the binary pool
+    for (auto it = m_pendingHistories.begin(); it != m_pendingHistories.end(); ++it) {
+        setEntryHistory(it.key(), it.value(), true);
+    }
+    m_pendingHistories.clear();
+
     const QSet<QString> poolKeys = asConst(m_binaryPool).keys().toSet();
-    const QSet<QString> entryKeys = asConst(m_binaryMap).keys().toSet();
+    const QSet<QString> entryKeys = asConst(m_binaryMap).keys().toSet() + m_historyBinaryKeys;
     const QSet<QString> unmappedKeys = entryKeys - poolKeys;
     const QSet<QString> unusedKeys = poolKeys - entryKeys;
 
@@ -136,7 +145,12 @@ void KdbxXmlReader::readDatabase(QIODevice* device, Database* db, KeePass2Random
     QHash<QString, QPair<Entry*, QString>>::const_iterator i;
     for (i = m_binaryMap.constBegin(); i != m_binaryMap.constEnd(); ++i) {
         const QPair<Entry*, QString>& target = i.value();
-        target.first->attachments()->set(target.second, m_binaryPool[i.key()]);
+        const auto data = m_binaryPool.value(i.key());
+        if (data) {
+            target.first->attachments()->set(target.second, data);
+        } else {
+            target.first->attachments()->set(target.second, QByteArray());
+        }
     }
 
     m_meta->setUpdateDatetime(true);
@@ -149,12 +163,8 @@ void KdbxXmlReader::readDatabase(QIODevice* device, Database* db, KeePass2Random
     QHash<QUuid, Entry*>::const_iterator iEntry;
     for (iEntry = m_entries.constBegin(); iEntry != m_entries.constEnd(); ++iEntry) {
         iEntry.value()->setUpdateTimeinfo(true);
-
-        const QList<Entry*> historyItems = iEntry.value()->historyItems();
-        for (Entry* histEntry : historyItems) {
-            histEntry->setUpdateTimeinfo(true);
-        }
     }
+    m_historyBinaryKeys.clear();
 }
 
 bool KdbxXmlReader::strictMode() const
@@ -346,7 +356,7 @@ void KdbxXmlReader::parseIcon()
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Icon");
 
     QUuid uuid;
-    QImage icon;
+    QByteArray iconData;
     bool uuidSet = false;
     bool iconSet = false;
 
@@ -355,7 +365,8 @@ void KdbxXmlReader::parseIcon()
             uuid = readUuid();
             uuidSet = !uuid.isNull();
         } else if (m_xml.name() == "Data") {
-            icon.loadFromData(readBinary());
+            // The icon is only decoded when it is displayed
+            iconData = readBinary();
             iconSet = true;
         } else {
             skipCurrentElement();
@@ -367,7 +378,7 @@ void KdbxXmlReader::parseIcon()
         if (m_meta->hasCustomIcon(uuid)) {
             uuid = QUuid::createUuid();
         }
-        m_meta->addCustomIcon(uuid, icon);
+        m_meta->addCustomIcon(uuid, iconData);
         return;
     }
 
@@ -392,7 +403,7 @@ void KdbxXmlReader::parseBinaries()
             qWarning("KdbxXmlReader::parseBinaries: overwriting binary item \"%s\"", qPrintable(id));
         }
 
-        m_binaryPool.insert(id, data);
+        m_binaryPool.insert(id, attachmentStore()->store(std::move(data)));
     }
 }
 
@@ -411,10 +422,17 @@ void KdbxXmlReader::parseCustomData(CustomData* customData)
 
 void KdbxXmlReader::parseCustomDataItem(CustomData* customData)
 {
-    Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Item");
-
     QString key;
     QString value;
+    if (readCustomDataItem(key, value)) {
+        customData->set(key, value);
+    }
+}
+
+bool KdbxXmlReader::readCustomDataItem(QString& key, QString& value)
+{
+    Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Item");
+
     bool keySet = false;
     bool valueSet = false;
 
@@ -431,11 +449,11 @@ void KdbxXmlReader::parseCustomDataItem(CustomData* customData)
     }
 
     if (keySet && valueSet) {
-        customData->set(key, value);
-        return;
+        return true;
     }
 
     raiseError(tr("Missing custom data key or value"));
+    return false;
 }
 
 bool KdbxXmlReader::parseRoot()
@@ -495,7 +513,7 @@ Group* KdbxXmlReader::parseGroup()
             continue;
         }
         if (m_xml.name() == "Name") {
-            group->setName(readString());
+            group->setName(m_db->stringInterner()->intern(readString()));
             continue;
         }
         if (m_xml.name() == "Notes") {
@@ -576,7 +594,7 @@ Group* KdbxXmlReader::parseGroup()
             continue;
         }
         if (m_xml.name() == "Entry") {
-            Entry* newEntry = parseEntry(false);
+            Entry* newEntry = parseEntry();
             if (newEntry) {
                 entries.append(newEntry);
             }
@@ -664,13 +682,13 @@ void KdbxXmlReader::parseDeletedObject()
     }
 }
 
-Entry* KdbxXmlReader::parseEntry(bool history)
+Entry* KdbxXmlReader::parseEntry()
 {
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Entry");
 
     auto entry = new Entry();
     entry->setUpdateTimeinfo(false);
-    QList<Entry*> historyItems;
+    QList<HistoryItem> historyItems;
     QList<StringPair> binaryRefs;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
@@ -718,7 +736,7 @@ Entry* KdbxXmlReader::parseEntry(bool history)
             continue;
         }
         if (m_xml.name() == "Tags") {
-            entry->setTags(readString());
+            entry->setTags(m_db->stringInterner()->intern(readString()));
             continue;
         }
         if (m_xml.name() == "Times") {
@@ -741,11 +759,7 @@ Entry* KdbxXmlReader::parseEntry(bool history)
             continue;
         }
         if (m_xml.name() == "History") {
-            if (history) {
-                raiseError(tr("History element in history entry"));
-            } else {
-                historyItems = parseEntryHistory();
-            }
+            historyItems = parseEntryHistory();
             continue;
         }
         if (m_xml.name() == "CustomData") {
@@ -760,30 +774,27 @@ Entry* KdbxXmlReader::parseEntry(bool history)
     }
 
     if (!entry->uuid().isNull()) {
-        if (history) {
-            entry->setUpdateTimeinfo(false);
-        } else {
-            Entry* tmpEntry = entry;
+        Entry* tmpEntry = entry;
 
-            entry = getEntry(tmpEntry->uuid());
-            entry->copyDataFrom(tmpEntry);
-            entry->setUpdateTimeinfo(false);
+        entry = getEntry(tmpEntry->uuid());
+        entry->copyDataFrom(tmpEntry);
+        entry->setUpdateTimeinfo(false);
 
-            delete tmpEntry;
-        }
+        delete tmpEntry;
     } else if (!hasError()) {
         raiseError(tr("No entry uuid found"));
     }
 
-    for (Entry* historyItem : asConst(historyItems)) {
-        if (historyItem->uuid() != entry->uuid()) {
-            if (m_strictMode) {
+    if (!historyItems.isEmpty()) {
+        for (const HistoryItem& historyItem : asConst(historyItems)) {
+            if (historyItem.uuid != entry->uuid() && m_strictMode) {
                 raiseError(tr("History element with different uuid"));
-            } else {
-                historyItem->setUuid(entry->uuid());
             }
         }
-        entry->addHistoryItem(historyItem);
+        // Attachments of the history can only be resolved once the binary pool is known
+        if (!setEntryHistory(entry, historyItems, false)) {
+            m_pendingHistories.insert(entry, historyItems);
+        }
     }
 
     for (const StringPair& ref : asConst(binaryRefs)) {
@@ -795,11 +806,25 @@ Entry* KdbxXmlReader::parseEntry(bool history)
 
 void KdbxXmlReader::parseEntryString(Entry* entry)
 {
-    Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "String");
-
     QString key;
     QString value;
     bool protect = false;
+    if (!readEntryString(key, value, protect)) {
+        return;
+    }
+
+    // the default attributes are always there so additionally check if it's empty
+    if (entry->attributes()->hasKey(key) && !entry->attributes()->value(key).isEmpty()) {
+        raiseError(tr("Duplicate custom attribute found"));
+        return;
+    }
+    entry->attributes()->set(m_db->stringInterner()->intern(key), value, protect);
+}
+
+bool KdbxXmlReader::readEntryString(QString& key, QString& value, bool& protect)
+{
+    Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "String");
+
     bool keySet = false;
     bool valueSet = false;
 
@@ -811,7 +836,6 @@ void KdbxXmlReader::parseEntryString(Entry* entry)
         }
 
         if (m_xml.name() == "Value") {
-            QXmlStreamAttributes attr = m_xml.attributes();
             bool isProtected;
             bool protectInMemory;
             value = readString(isProtected, protectInMemory);
@@ -824,26 +848,37 @@ void KdbxXmlReader::parseEntryString(Entry* entry)
     }
 
     if (keySet && valueSet) {
-        // the default attributes are always there so additionally check if it's empty
-        if (entry->attributes()->hasKey(key) && !entry->attributes()->value(key).isEmpty()) {
-            raiseError(tr("Duplicate custom attribute found"));
-            return;
-        }
-        entry->attributes()->set(key, value, protect);
-        return;
+        return true;
     }
 
     raiseError(tr("Entry string key or value missing"));
+    return false;
 }
 
 QPair<QString, QString> KdbxXmlReader::parseEntryBinary(Entry* entry)
 {
-    Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Binary");
-
-    QPair<QString, QString> poolRef;
-
     QString key;
     QByteArray value;
+    QString poolKey;
+    if (!readEntryBinary(key, value, poolKey)) {
+        return {};
+    }
+
+    if (entry->attachments()->hasKey(key) && entry->attachments()->value(key) != value) {
+        // NOTE: This only impacts KDBX 3.x databases
+        // Prepend a random string to the key to make it unique and prevent data loss
+        key = key.prepend(QUuid::createUuid().toString().mid(1, 8) + "_");
+        qWarning("Duplicate attachment name found, renamed to: %s", qPrintable(key));
+    }
+    entry->attachments()->set(key, value);
+
+    return poolKey.isEmpty() ? QPair<QString, QString>() : qMakePair(poolKey, key);
+}
+
+bool KdbxXmlReader::readEntryBinary(QString& key, QByteArray& value, QString& poolKey)
+{
+    Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Binary");
+
     bool keySet = false;
     bool valueSet = false;
 
@@ -857,7 +892,7 @@ QPair<QString, QString> KdbxXmlReader::parseEntryBinary(Entry* entry)
             QXmlStreamAttributes attr = m_xml.attributes();
 
             if (attr.hasAttribute("Ref")) {
-                poolRef = qMakePair(attr.value("Ref").toString(), key);
+                poolKey = attr.value("Ref").toString();
                 m_xml.skipCurrentElement();
             } else {
                 // format compatibility
@@ -871,18 +906,11 @@ QPair<QString, QString> KdbxXmlReader::parseEntryBinary(Entry* entry)
     }
 
     if (keySet && valueSet) {
-        if (entry->attachments()->hasKey(key) && entry->attachments()->value(key) != value) {
-            // NOTE: This only impacts KDBX 3.x databases
-            // Prepend a random string to the key to make it unique and prevent data loss
-            key = key.prepend(QUuid::createUuid().toString().mid(1, 8) + "_");
-            qWarning("Duplicate attachment name found, renamed to: %s", qPrintable(key));
-        }
-        entry->attachments()->set(key, value);
-    } else {
-        raiseError(tr("Entry binary key or value missing"));
+        return true;
     }
 
-    return poolRef;
+    raiseError(tr("Entry binary key or value missing"));
+    return false;
 }
 
 void KdbxXmlReader::parseAutoType(Entry* entry)
@@ -897,18 +925,20 @@ void KdbxXmlReader::parseAutoType(Entry* entry)
         } else if (m_xml.name() == "DefaultSequence") {
             entry->setDefaultAutoTypeSequence(readString());
         } else if (m_xml.name() == "Association") {
-            parseAutoTypeAssoc(entry);
+            AutoTypeAssociations::Association assoc;
+            if (readAutoTypeAssoc(assoc)) {
+                entry->autoTypeAssociations()->add(assoc);
+            }
         } else {
             skipCurrentElement();
         }
     }
 }
 
-void KdbxXmlReader::parseAutoTypeAssoc(Entry* entry)
+bool KdbxXmlReader::readAutoTypeAssoc(AutoTypeAssociations::Association& assoc)
 {
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Association");
 
-    AutoTypeAssociations::Association assoc;
     bool windowSet = false;
     bool sequenceSet = false;
 
@@ -925,21 +955,25 @@ void KdbxXmlReader::parseAutoTypeAssoc(Entry* entry)
     }
 
     if (windowSet && sequenceSet) {
-        entry->autoTypeAssociations()->add(assoc);
-        return;
+        return true;
     }
     raiseError(tr("Auto-type association window or sequence missing"));
+    return false;
 }
 
-QList<Entry*> KdbxXmlReader::parseEntryHistory()
+/**
+ * Read the history of an entry as plain values. No Entry objects are created
+ * for the items, they are only materialized when the history is accessed.
+ */
+QList<KdbxXmlReader::HistoryItem> KdbxXmlReader::parseEntryHistory()
 {
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "History");
 
-    QList<Entry*> historyItems;
+    QList<HistoryItem> historyItems;
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
         if (m_xml.name() == "Entry") {
-            historyItems.append(parseEntry(true));
+            historyItems.append(parseHistoryItem());
         } else {
             skipCurrentElement();
         }
@@ -948,6 +982,153 @@ QList<Entry*> KdbxXmlReader::parseEntryHistory()
     return historyItems;
 }
 
+KdbxXmlReader::HistoryItem KdbxXmlReader::parseHistoryItem()
+{
+    Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Entry");
+
+    HistoryItem item;
+    EntryHistory::Version& version = item.version;
+    version.data.iconNumber = Entry::DefaultIconNumber;
+    version.data.autoTypeEnabled = true;
+    version.data.autoTypeObfuscation = 0;
+    for (const QString& key : EntryAttributes::DefaultAttributes) {
+        version.attributes.insert(key, QString());
+    }
+
+    while (!m_xml.hasError() && m_xml.readNextStartElement()) {
+        if (m_xml.name() == "UUID") {
+            item.uuid = readUuid();
+            if (item.uuid.isNull() && m_strictMode) {
+                raiseError(tr("Null entry uuid"));
+            }
+        } else if (m_xml.name() == "IconID") {
+            int iconId = readNumber();
+            if (iconId < 0) {
+                if (m_strictMode) {
+                    raiseError(tr("Invalid entry icon number"));
+                }
+                iconId = 0;
+            }
+            version.data.iconNumber = iconId;
+            version.data.customIcon = QUuid();
+        } else if (m_xml.name() == "CustomIconUUID") {
+            QUuid uuid = readUuid();
+            if (!uuid.isNull()) {
+                version.data.customIcon = uuid;
+                version.data.iconNumber = 0;
+            }
+        } else if (m_xml.name() == "ForegroundColor") {
+            version.data.foregroundColor = readColor();
+        } else if (m_xml.name() == "BackgroundColor") {
+            version.data.backgroundColor = readColor();
+        } else if (m_xml.name() == "OverrideURL") {
+            version.data.overrideUrl = readString();
+        } else if (m_xml.name() == "Tags") {
+            version.data.tags = m_db->stringInterner()->intern(readString());
+        } else if (m_xml.name() == "Times") {
+            version.data.timeInfo = parseTimes();
+        } else if (m_xml.name() == "String") {
+            QString key;
+            QString value;
+            bool protect = false;
+            if (readEntryString(key, value, protect)) {
+                if (!version.attributes.value(key).isEmpty()) {
+                    raiseError(tr("Duplicate custom attribute found"));
+                    continue;
+                }
+                key = m_db->stringInterner()->intern(key);
+                version.attributes.insert(key, value);
+                if (protect) {
+                    version.protectedAttributes.insert(key);
+                }
+            }
+        } else if (m_xml.name() == "Binary") {
+            QString key;
+            QByteArray value;
+            QString poolKey;
+            if (readEntryBinary(key, value, poolKey)) {
+                bool duplicate = version.attachments.contains(key);
+                for (const StringPair& ref : asConst(item.binaryRefs)) {
+                    duplicate |= ref.second == key;
+                }
+                if (duplicate) {
+                    // Same as for entries, see parseEntryBinary()
+                    key = key.prepend(QUuid::createUuid().toString().mid(1, 8) + "_");
+                    qWarning("Duplicate attachment name found, renamed to: %s", qPrintable(key));
+                }
+                if (!poolKey.isEmpty()) {
+                    item.binaryRefs.append(qMakePair(poolKey, key));
+                } else {
+                    version.attachments.insert(key, attachmentStore()->store(value));
+                }
+            }
+        } else if (m_xml.name() == "AutoType") {
+            while (!m_xml.hasError() && m_xml.readNextStartElement()) {
+                if (m_xml.name() == "Enabled") {
+                    version.data.autoTypeEnabled = readBool();
+                } else if (m_xml.name() == "DataTransferObfuscation") {
+                    version.data.autoTypeObfuscation = readNumber();
+                } else if (m_xml.name() == "DefaultSequence") {
+                    version.data.defaultAutoTypeSequence = readString();
+                } else if (m_xml.name() == "Association") {
+                    AutoTypeAssociations::Association assoc;
+                    if (readAutoTypeAssoc(assoc)) {
+                        version.autoTypeAssociations.append(assoc);
+                    }
+                } else {
+                    skipCurrentElement();
+                }
+            }
+        } else if (m_xml.name() == "History") {
+            raiseError(tr("History element in history entry"));
+        } else if (m_xml.name() == "CustomData") {
+            while (!m_xml.hasError() && m_xml.readNextStartElement()) {
+                if (m_xml.name() == "Item") {
+                    QString key;
+                    QString value;
+                    if (readCustomDataItem(key, value)) {
+                        version.customData.insert(key, value);
+                    }
+                    continue;
+                }
+                skipCurrentElement();
+            }
+        } else {
+            skipCurrentElement();
+        }
+    }
+
+    return item;
+}
+
+/**
+ * Give the entry its history in compact form.
+ *
+ * @param poolComplete whether attachments missing in the binary pool are never going to be read
+ * @return false if the history waits for attachments that are not in the binary pool yet
+ */
+bool KdbxXmlReader::setEntryHistory(Entry* entry, QList<HistoryItem> historyItems, bool poolComplete)
+{
+    QScopedPointer<EntryHistory> history(new EntryHistory());
+    for (HistoryItem& item : historyItems) {
+        for (const StringPair& ref : asConst(item.binaryRefs)) {
+            m_historyBinaryKeys.insert(ref.first);
+            auto data = m_binaryPool.value(ref.first);
+            if (!data) {
+                if (!poolComplete) {
+                    return false;
+                }
+                data = attachmentStore()->store(QByteArray());
+            }
+            item.version.attachments.insert(ref.second, data);
+        }
+        history->append(item.version);
+    }
+
+    entry->setCompactHistory(history.take());
+    return true;
+}
+
 TimeInfo KdbxXmlReader::parseTimes()
 {
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Times");
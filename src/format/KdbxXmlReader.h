@@ -18,7 +18,9 @@
 #ifndef KEEPASSXC_KDBXXMLREADER_H
 #define KEEPASSXC_KDBXXMLREADER_H
 
+#include "core/AttachmentStore.h"
 #include "core/Database.h"
+#include "core/EntryHistory.h"
 #include "core/Metadata.h"
 
 #include <QCoreApplication>
@@ -39,7 +41,7 @@ class KdbxXmlReader
 
 public:
     explicit KdbxXmlReader(quint32 version);
-    explicit KdbxXmlReader(quint32 version, QHash<QString, QByteArray> binaryPool);
+    explicit KdbxXmlReader(quint32 version, QHash<QString, QSharedPointer<const AttachmentData>> binaryPool);
     virtual ~KdbxXmlReader() = default;
 
     virtual QSharedPointer<Database> readDatabase(const QString& filename);
@@ -57,6 +59,15 @@ public:
 protected:
     typedef QPair<QString, QString> StringPair;
 
+    // History item read without creating an Entry for it
+    struct HistoryItem
+    {
+        QUuid uuid;
+        EntryHistory::Version version;
+        // Binary pool keys and names of the attachments
+        QList<StringPair> binaryRefs;
+    };
+
     virtual bool parseKeePassFile();
     virtual void parseMeta();
     virtual void parseMemoryProtection();
@@ -65,16 +76,21 @@ protected:
     virtual void parseBinaries();
     virtual void parseCustomData(CustomData* customData);
     virtual void parseCustomDataItem(CustomData* customData);
+    virtual bool readCustomDataItem(QString& key, QString& value);
     virtual bool parseRoot();
     virtual Group* parseGroup();
     virtual void parseDeletedObjects();
     virtual void parseDeletedObject();
-    virtual Entry* parseEntry(bool history);
+    virtual Entry* parseEntry();
     virtual void parseEntryString(Entry* entry);
+    virtual bool readEntryString(QString& key, QString& value, bool& protect);
     virtual QPair<QString, QString> parseEntryBinary(Entry* entry);
+    virtual bool readEntryBinary(QString& key, QByteArray& value, QString& poolKey);
     virtual void parseAutoType(Entry* entry);
-    virtual void parseAutoTypeAssoc(Entry* entry);
-    virtual QList<Entry*> parseEntryHistory();
+    virtual bool readAutoTypeAssoc(AutoTypeAssociations::Association& assoc);
+    virtual QList<HistoryItem> parseEntryHistory();
+    virtual HistoryItem parseHistoryItem();
+    virtual bool setEntryHistory(Entry* entry, QList<HistoryItem> historyItems, bool poolComplete);
     virtual TimeInfo parseTimes();
 
     virtual QString readString();
@@ -108,8 +124,12 @@ protected:
     QHash<QUuid, Group*> m_groups;
     QHash<QUuid, Entry*> m_entries;
 
-    QHash<QString, QByteArray> m_binaryPool;
+    QHash<QString, QSharedPointer<const AttachmentData>> m_binaryPool;
     QHash<QString, QPair<Entry*, QString>> m_binaryMap;
+    // Pool keys that are used by history items
+    QSet<QString> m_historyBinaryKeys;
+    // Histories whose attachments can only be set once the binary pool is complete
+    QHash<Entry*, QList<HistoryItem>> m_pendingHistories;
     QByteArray m_headerHash;
 
     bool m_error = false;
@@ -19,8 +19,11 @@
 
 #include <QBuffer>
 #include <QFile>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include "core/Endian.h"
+#include "core/EntryHistory.h"
 #include "core/Metadata.h"
 #include "format/KeePass2RandomStream.h"
 #include "streams/qtiocompressor.h"
@@ -49,6 +52,19 @@ void KdbxXmlWriter::writeDatabase(QIODevice* device,
 
     generateIdMap();
 
+    // Unchanged entries are copied from the previous save, only possible while protected values are left out
+    m_fragmentCache = nullptr;
+    if (m_randomStream && !m_innerStreamProtectionDisabled) {
+        m_fragmentCache = db->xmlFragmentCache();
+        quint64 context = m_kdbxVersion;
+        context = (context << 1) | (m_meta->protectTitle() ? 1 : 0);
+        context = (context << 1) | (m_meta->protectUsername() ? 1 : 0);
+        context = (context << 1) | (m_meta->protectPassword() ? 1 : 0);
+        context = (context << 1) | (m_meta->protectUrl() ? 1 : 0);
+        context = (context << 1) | (m_meta->protectNotes() ? 1 : 0);
+        m_fragmentCache->beginSave(context);
+    }
+
     m_xml.setDevice(device);
     m_xml.writeStartDocument("1.0", true);
     m_xml.writeStartElement("KeePassFile");
@@ -62,6 +78,14 @@ void KdbxXmlWriter::writeDatabase(QIODevice* device,
     if (m_xml.hasError()) {
         raiseError(device->errorString());
     }
+
+    if (m_fragmentCache) {
+        if (m_error) {
+            m_fragmentCache->clear();
+        } else {
+            m_fragmentCache->endSave();
+        }
+    }
 }
 
 void KdbxXmlWriter::writeDatabase(const QString& filename, Database* db)
@@ -81,20 +105,45 @@ QString KdbxXmlWriter::errorString()
     return m_errorStr;
 }
 
-void KdbxXmlWriter::generateIdMap()
-{
-    const QList<Entry*> allEntries = m_db->rootGroup()->entriesRecursive(true);
-    int nextId = 0;
+/**
+ * Attachments of all entries and their history items without duplicates,
+ * the index of an attachment is its id in the saved database.
+ */
+QList<QSharedPointer<const AttachmentData>> KdbxXmlWriter::binaries(const Database* db)
+{
+    QList<QSharedPointer<const AttachmentData>> result;
+    QSet<QByteArray> hashes;
+    auto addAttachment = [&](const QSharedPointer<const AttachmentData>& data) {
+        if (data && !hashes.contains(data->hash())) {
+            hashes.insert(data->hash());
+            result.append(data);
+        }
+    };
 
-    for (Entry* entry : allEntries) {
+    const QList<Entry*> allEntries = db->rootGroup()->entriesRecursive();
+    for (const Entry* entry : allEntries) {
         const QList<QString> attachmentKeys = entry->attachments()->keys();
         for (const QString& key : attachmentKeys) {
-            QByteArray data = entry->attachments()->value(key);
-            if (!m_idMap.contains(data)) {
-                m_idMap.insert(data, nextId++);
+            addAttachment(entry->attachments()->attachmentData(key));
+        }
+        // Read the attachments of history items without materializing a compact history
+        const QList<EntryHistory::Version> versions = EntryHistory::historyVersions(entry);
+        for (const EntryHistory::Version& version : versions) {
+            for (const auto& data : version.attachments) {
+                addAttachment(data);
             }
         }
     }
+
+    return result;
+}
+
+void KdbxXmlWriter::generateIdMap()
+{
+    m_binaries = binaries(m_db);
+    for (int id = 0; id < m_binaries.size(); ++id) {
+        m_idMap.insert(m_binaries.at(id)->hash(), id);
+    }
 }
 
 void KdbxXmlWriter::writeMetadata()
@@ -156,65 +205,81 @@ void KdbxXmlWriter::writeCustomIcons()
 
     const QList<QUuid> customIconsOrder = m_meta->customIconsOrder();
     for (const QUuid& uuid : customIconsOrder) {
-        writeIcon(uuid, m_meta->customIcon(uuid));
+        writeIcon(uuid, m_meta->customIconData(uuid));
     }
 
     m_xml.writeEndElement();
 }
 
-void KdbxXmlWriter::writeIcon(const QUuid& uuid, const QImage& icon)
+void KdbxXmlWriter::writeIcon(const QUuid& uuid, const QByteArray& iconData)
 {
     m_xml.writeStartElement("Icon");
 
     writeUuid("UUID", uuid);
-
-    QByteArray ba;
-    QBuffer buffer(&ba);
-    buffer.open(QIODevice::WriteOnly);
-    // TODO: check !icon.save()
-    icon.save(&buffer, "PNG");
-    buffer.close();
-    writeBinary("Data", ba);
+    // Icons are written as they were read or added, without decoding them
+    writeBinary("Data", iconData);
 
     m_xml.writeEndElement();
 }
 
-void KdbxXmlWriter::writeBinaries()
+namespace
 {
-    m_xml.writeStartElement("Binaries");
+    QByteArray compressBinary(const QSharedPointer<const AttachmentData>& binary)
+    {
+        // Page spilled attachments in one at a time
+        const QByteArray value = binary->data();
 
-    QHash<QByteArray, int>::const_iterator i;
-    for (i = m_idMap.constBegin(); i != m_idMap.constEnd(); ++i) {
-        m_xml.writeStartElement("Binary");
+        QBuffer buffer;
+        buffer.open(QIODevice::ReadWrite);
 
-        m_xml.writeAttribute("ID", QString::number(i.value()));
+        QtIOCompressor compressor(&buffer);
+        compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+        compressor.open(QIODevice::WriteOnly);
 
-        QByteArray data;
-        if (m_db->compressionAlgorithm() == Database::CompressionGZip) {
-            m_xml.writeAttribute("Compressed", "True");
+        qint64 bytesWritten = compressor.write(value);
+        Q_ASSERT(bytesWritten == value.size());
+        Q_UNUSED(bytesWritten);
+        compressor.close();
 
-            QBuffer buffer;
-            buffer.open(QIODevice::ReadWrite);
+        return buffer.data();
+    }
+} // namespace
 
-            QtIOCompressor compressor(&buffer);
-            compressor.setStreamFormat(QtIOCompressor::GzipFormat);
-            compressor.open(QIODevice::WriteOnly);
+/**
+ * Write the binary pool of KDBX 3.1. Compressed binaries are gzipped in parallel,
+ * a batch of one per thread at a time so only a few of them are held in memory.
+ */
+void KdbxXmlWriter::writeBinaries()
+{
+    m_xml.writeStartElement("Binaries");
 
-            qint64 bytesWritten = compressor.write(i.key());
-            Q_ASSERT(bytesWritten == i.key().size());
-            Q_UNUSED(bytesWritten);
-            compressor.close();
+    const bool compress = m_db->compressionAlgorithm() == Database::CompressionGZip;
+    const int batchSize = compress ? qMax(1, QThread::idealThreadCount()) : 1;
 
-            buffer.seek(0);
-            data = buffer.readAll();
+    for (int first = 0; first < m_binaries.size(); first += batchSize) {
+        const QList<QSharedPointer<const AttachmentData>> batch = m_binaries.mid(first, batchSize);
+        QList<QByteArray> batchData;
+        if (compress) {
+            batchData = QtConcurrent::blockingMapped<QList<QByteArray>>(batch, compressBinary);
         } else {
-            data = i.key();
+            // Page spilled attachments in one at a time
+            batchData.append(batch.first()->data());
         }
 
-        if (!data.isEmpty()) {
-            m_xml.writeCharacters(QString::fromLatin1(data.toBase64()));
+        for (int i = 0; i < batchData.size(); ++i) {
+            m_xml.writeStartElement("Binary");
+
+            m_xml.writeAttribute("ID", QString::number(first + i));
+            if (compress) {
+                m_xml.writeAttribute("Compressed", "True");
+            }
+
+            const QByteArray& data = batchData.at(i);
+            if (!data.isEmpty()) {
+                m_xml.writeCharacters(QString::fromLatin1(data.toBase64()));
+            }
+            m_xml.writeEndElement();
         }
-        m_xml.writeEndElement();
     }
 
     m_xml.writeEndElement();
@@ -262,6 +327,7 @@ void KdbxXmlWriter::writeGroup(const Group* group)
     Q_ASSERT(!group->uuid().isNull());
 
     m_xml.writeStartElement("Group");
+    ++m_depth;
 
     writeUuid("UUID", group->uuid());
     writeString("Name", group->name());
@@ -295,6 +361,7 @@ void KdbxXmlWriter::writeGroup(const Group* group)
         writeGroup(child);
     }
 
+    --m_depth;
     m_xml.writeEndElement();
 }
 
@@ -341,6 +408,19 @@ void KdbxXmlWriter::writeEntry(const Entry* entry)
 
     m_xml.writeStartElement("Entry");
 
+    // History items are part of the fragment of their entry
+    if (m_fragmentCache && !m_fragment) {
+        writeEntryFragment(entry);
+    } else {
+        writeEntryContent(entry);
+    }
+}
+
+/**
+ * Write everything after the start tag of an entry, including the end tag.
+ */
+void KdbxXmlWriter::writeEntryContent(const Entry* entry)
+{
     writeUuid("UUID", entry->uuid());
     writeNumber("IconID", entry->iconNumber());
     if (!entry->iconUuid().isNull()) {
@@ -371,7 +451,18 @@ void KdbxXmlWriter::writeEntry(const Entry* entry)
         QString value;
 
         if (protect) {
-            if (!m_innerStreamProtectionDisabled && m_randomStream) {
+            if (m_fragment) {
+                m_xml.writeAttribute("Protected", "True");
+                // The value is protected and filled in when the fragment is written
+                if (!entry->attributes()->value(key).isEmpty()) {
+                    m_xml.writeCharacters(QString());
+                    if (m_historyEntry) {
+                        m_fragment->holes.append({m_fragment->xml.size(), m_historyEntry, m_historyIndex, key, {}});
+                    } else {
+                        m_fragment->holes.append({m_fragment->xml.size(), entry, -1, key, {}});
+                    }
+                }
+            } else if (!m_innerStreamProtectionDisabled && m_randomStream) {
                 m_xml.writeAttribute("Protected", "True");
                 bool ok;
                 QByteArray rawData = m_randomStream->process(entry->attributes()->value(key).toUtf8(), &ok);
@@ -402,7 +493,14 @@ void KdbxXmlWriter::writeEntry(const Entry* entry)
         writeString("Key", key);
 
         m_xml.writeStartElement("Value");
-        m_xml.writeAttribute("Ref", QString::number(m_idMap[entry->attachments()->value(key)]));
+        const auto data = entry->attachments()->attachmentData(key);
+        if (m_fragment) {
+            // The attachment id is filled in between the quotes when the fragment is written
+            m_xml.writeAttribute("Ref", QString());
+            m_fragment->holes.append({m_fragment->xml.size() - 1, nullptr, -1, QString(), data->hash()});
+        } else {
+            m_xml.writeAttribute("Ref", QString::number(m_idMap.value(data->hash())));
+        }
         m_xml.writeEndElement();
 
         m_xml.writeEndElement();
@@ -422,6 +520,82 @@ void KdbxXmlWriter::writeEntry(const Entry* entry)
     m_xml.writeEndElement();
 }
 
+/**
+ * Write the content of an entry from the fragment cache, serializing it
+ * into the cache first if it changed since the last save.
+ */
+void KdbxXmlWriter::writeEntryFragment(const Entry* entry)
+{
+    QIODevice* device = m_xml.device();
+    const QVector<quint64> revisions = KdbxXmlFragmentCache::revisions(entry);
+
+    KdbxXmlFragmentCache::Fragment fragment;
+    if (m_fragmentCache->fragment(entry, revisions, m_depth, fragment)) {
+        // Only update the state of the XML writer, the fragment holds the end tag
+        QBuffer discard;
+        discard.open(QIODevice::WriteOnly);
+        m_xml.setDevice(&discard);
+        m_xml.writeEndElement();
+        m_xml.setDevice(device);
+    } else {
+        fragment.revisions = revisions;
+        fragment.depth = m_depth;
+        QBuffer buffer(&fragment.xml);
+        buffer.open(QIODevice::WriteOnly);
+        m_xml.setDevice(&buffer);
+        m_fragment = &fragment;
+        writeEntryContent(entry);
+        m_fragment = nullptr;
+        m_xml.setDevice(device);
+        m_fragmentCache->insert(entry, fragment);
+    }
+
+    writeFragment(device, fragment);
+}
+
+/**
+ * Write a cached fragment, protecting its values with the inner random stream.
+ */
+void KdbxXmlWriter::writeFragment(QIODevice* device, const KdbxXmlFragmentCache::Fragment& fragment)
+{
+    QByteArray output;
+    output.reserve(fragment.xml.size());
+
+    int pos = 0;
+    QList<EntryHistory::Version> historyVersions;
+    for (const KdbxXmlFragmentCache::Hole& hole : fragment.holes) {
+        output.append(fragment.xml.constData() + pos, hole.offset - pos);
+        pos = hole.offset;
+
+        if (hole.entry) {
+            QString value;
+            if (hole.historyIndex < 0) {
+                value = hole.entry->attributes()->value(hole.key);
+            } else {
+                // All history items of a fragment belong to the same entry
+                if (historyVersions.isEmpty()) {
+                    historyVersions = EntryHistory::historyVersions(hole.entry);
+                }
+                value = historyVersions.at(hole.historyIndex).attributes.value(hole.key);
+            }
+
+            bool ok;
+            QByteArray rawData = m_randomStream->process(value.toUtf8(), &ok);
+            if (!ok) {
+                raiseError(m_randomStream->errorString());
+            }
+            output.append(rawData.toBase64());
+        } else {
+            output.append(QByteArray::number(m_idMap.value(hole.attachmentHash)));
+        }
+    }
+    output.append(fragment.xml.constData() + pos, fragment.xml.size() - pos);
+
+    if (device->write(output) != output.size()) {
+        raiseError(device->errorString());
+    }
+}
+
 void KdbxXmlWriter::writeAutoType(const Entry* entry)
 {
     m_xml.writeStartElement("AutoType");
@@ -452,10 +626,17 @@ void KdbxXmlWriter::writeEntryHistory(const Entry* entry)
 {
     m_xml.writeStartElement("History");
 
-    const QList<Entry*>& historyItems = entry->historyItems();
-    for (const Entry* item : historyItems) {
-        writeEntry(item);
-    }
+    // A compact history is only expanded while it is written, so cached fragments
+    // refer to protected values of history items by their index
+    entry->readHistoryItems([this, entry](const QList<Entry*>& historyItems) {
+        for (int i = 0; i < historyItems.size(); ++i) {
+            m_historyEntry = entry;
+            m_historyIndex = i;
+            writeEntry(historyItems.at(i));
+        }
+    });
+    m_historyEntry = nullptr;
+    m_historyIndex = -1;
 
     m_xml.writeEndElement();
 }
@@ -20,7 +20,9 @@
 
 #include <QXmlStreamWriter>
 
+#include "core/AttachmentStore.h"
 #include "core/Group.h"
+#include "format/KdbxXmlFragmentCache.h"
 
 class KeePass2RandomStream;
 class Metadata;
@@ -40,13 +42,15 @@ public:
     bool hasError();
     QString errorString();
 
+    static QList<QSharedPointer<const AttachmentData>> binaries(const Database* db);
+
 private:
     void generateIdMap();
 
     void writeMetadata();
     void writeMemoryProtection();
     void writeCustomIcons();
-    void writeIcon(const QUuid& uuid, const QImage& icon);
+    void writeIcon(const QUuid& uuid, const QByteArray& iconData);
     void writeBinaries();
     void writeCustomData(const CustomData* customData);
     void writeCustomDataItem(const QString& key, const QString& value);
@@ -56,6 +60,9 @@ private:
     void writeDeletedObjects();
     void writeDeletedObject(const DeletedObject& delObj);
     void writeEntry(const Entry* entry);
+    void writeEntryContent(const Entry* entry);
+    void writeEntryFragment(const Entry* entry);
+    void writeFragment(QIODevice* device, const KdbxXmlFragmentCache::Fragment& fragment);
     void writeAutoType(const Entry* entry);
     void writeAutoTypeAssoc(const AutoTypeAssociations::Association& assoc);
     void writeEntryHistory(const Entry* entry);
@@ -82,8 +89,17 @@ private:
     QPointer<const Database> m_db;
     QPointer<const Metadata> m_meta;
     KeePass2RandomStream* m_randomStream = nullptr;
+    // Attachment ids keyed by content hash, m_binaries holds the attachment of each id
     QHash<QByteArray, int> m_idMap;
+    QList<QSharedPointer<const AttachmentData>> m_binaries;
     QByteArray m_headerHash;
+    KdbxXmlFragmentCache* m_fragmentCache = nullptr;
+    // Entry of the history item that is currently written and the index of the item
+    const Entry* m_historyEntry = nullptr;
+    int m_historyIndex = -1;
+    // Fragment of the entry that is currently serialized for the cache
+    KdbxXmlFragmentCache::Fragment* m_fragment = nullptr;
+    int m_depth = 0;
 
     bool m_error = false;
 
@@ -17,6 +17,7 @@
 
 #include <QFile>
 
+#include "core/EntryHistory.h"
 #include "core/Group.h"
 #include "format/Kdbx3Writer.h"
 #include "format/Kdbx4Writer.h"
@@ -62,8 +63,8 @@ bool KeePass2Writer::implicitUpgradeNeeded(Database const* db) const
                 return true;
             }
 
-            for (const auto& historyItem : entry->historyItems()) {
-                if (historyItem->customData() && !historyItem->customData()->isEmpty()) {
+            for (const auto& version : EntryHistory::historyVersions(entry)) {
+                if (!version.customData.isEmpty()) {
                     return true;
                 }
             }
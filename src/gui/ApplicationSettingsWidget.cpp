@@ -199,6 +199,7 @@ void ApplicationSettingsWidget::loadSettings()
     m_generalUi->backupBeforeSaveCheckBox->setChecked(config()->get(Config::BackupBeforeSave).toBool());
 
     m_generalUi->backupFilePath->setText(config()->get(Config::BackupFilePathPattern).toString());
+    m_generalUi->precomputeDatabaseKeyCheckBox->setChecked(config()->get(Config::PrecomputeDatabaseKey).toBool());
 
     m_generalUi->useAlternativeSaveCheckBox->setChecked(!config()->get(Config::UseAtomicSaves).toBool());
     m_generalUi->alternativeSaveComboBox->setCurrentIndex(config()->get(Config::UseDirectWriteSaves).toBool() ? 1 : 0);
@@ -340,6 +341,7 @@ void ApplicationSettingsWidget::saveSettings()
     config()->set(Config::BackupBeforeSave, m_generalUi->backupBeforeSaveCheckBox->isChecked());
 
     config()->set(Config::BackupFilePathPattern, m_generalUi->backupFilePath->text());
+    config()->set(Config::PrecomputeDatabaseKey, m_generalUi->precomputeDatabaseKeyCheckBox->isChecked());
 
     config()->set(Config::UseAtomicSaves, !m_generalUi->useAlternativeSaveCheckBox->isChecked());
     config()->set(Config::UseDirectWriteSaves, m_generalUi->alternativeSaveComboBox->currentIndex() == 1);
@@ -30,6 +30,7 @@
 #include <core/Tools.h>
 
 #include "autotype/AutoType.h"
+#include "core/EntrySearchIndex.h"
 #include "core/EntrySearcher.h"
 #include "core/Merger.h"
 #include "gui/Clipboard.h"
@@ -81,9 +82,13 @@ DatabaseWidget::DatabaseWidget(QSharedPointer<Database> db, QWidget* parent)
     , m_groupView(new GroupView(m_db.data(), m_mainSplitter))
     , m_saveAttempts(0)
     , m_entrySearcher(new EntrySearcher(false))
+    , m_searchIndex(new EntrySearchIndex(this))
 {
     Q_ASSERT(m_db);
 
+    m_entrySearcher->setSearchIndex(m_searchIndex);
+    m_searchIndex->build(m_db->rootGroup());
+
     m_messageWidget->setHidden(true);
 
     auto* mainLayout = new QVBoxLayout();
@@ -203,6 +208,13 @@ DatabaseWidget::DatabaseWidget(QSharedPointer<Database> db, QWidget* parent)
 
     m_searchLimitGroup = config()->get(Config::SearchLimitGroup).toBool();
 
+    m_db->setKeyPrecomputationEnabled(config()->get(Config::PrecomputeDatabaseKey).toBool());
+    connect(config(), &Config::changed, this, [this](Config::ConfigKey key) {
+        if (key == Config::PrecomputeDatabaseKey) {
+            m_db->setKeyPrecomputationEnabled(config()->get(Config::PrecomputeDatabaseKey).toBool());
+        }
+    });
+
 #ifdef WITH_XC_KEESHARE
     // We need to reregister the database to allow exports
     // from a newly created database
@@ -388,6 +400,8 @@ void DatabaseWidget::replaceDatabase(QSharedPointer<Database> db)
     m_db = std::move(db);
     connectDatabaseSignals();
     m_groupView->changeDatabase(m_db);
+    m_searchIndex->build(m_db->rootGroup());
+    m_db->setKeyPrecomputationEnabled(config()->get(Config::PrecomputeDatabaseKey).toBool());
 
     // Restore the new parent group pointer, if not found default to the root group
     // this prevents data loss when merging a database while creating a new entry
@@ -1055,7 +1069,22 @@ void DatabaseWidget::mergeDatabase(bool accepted)
         }
 
         Merger merger(srcDb.data(), m_db.data());
-        QStringList changeList = merger.merge();
+        const Merger::Plan plan = merger.plan();
+        auto result = MessageBox::question(this,
+                                           tr("Merge Database"),
+                                           tr("%1 entries are missing, %2 entries differ and %3 entries are "
+                                              "identical.\nDo you want to merge the database files?")
+                                               .arg(plan.count(Merger::CreateEntry))
+                                               .arg(plan.count(Merger::UpdateEntry))
+                                               .arg(plan.count(Merger::KeepEntry)),
+                                           MessageBox::Merge | MessageBox::Cancel,
+                                           MessageBox::Merge);
+        if (result != MessageBox::Merge) {
+            switchToMainView();
+            return;
+        }
+
+        QStringList changeList = merger.merge(plan);
 
         if (!changeList.isEmpty()) {
             showMessage(tr("Successfully merged the database files."), MessageWidget::Information);
@@ -1601,7 +1630,10 @@ void DatabaseWidget::reloadDatabaseFile()
 
     QString error;
     auto db = QSharedPointer<Database>::create(m_db->filePath());
+    // Skips the KDF unless the file was saved with a different transform seed
+    db->offerTransformedKey(m_db.data());
     if (db->open(database()->key(), &error)) {
+        bool merged = false;
         if (m_db->isModified() || db->hasNonDataChanges()) {
             // Ask if we want to merge changes into new database
             auto result = MessageBox::question(
@@ -1614,23 +1646,21 @@ void DatabaseWidget::reloadDatabaseFile()
             if (result == MessageBox::Merge) {
                 // Merge the old database into the new one
                 Merger merger(m_db.data(), db.data());
-                merger.merge();
+                merged = !merger.merge().isEmpty();
             }
         }
 
-        QUuid groupBeforeReload = m_db->rootGroup()->uuid();
-        if (m_groupView && m_groupView->currentGroup()) {
-            groupBeforeReload = m_groupView->currentGroup()->uuid();
-        }
-
-        QUuid entryBeforeReload;
-        if (m_entryView && m_entryView->currentEntry()) {
-            entryBeforeReload = m_entryView->currentEntry()->uuid();
+        // Apply the new state in place so the views keep their state
+        m_db->reloadFrom(db.data());
+        // The index only notices changes through modified signals, which the reload suppresses
+        m_searchIndex->build(m_db->rootGroup());
+        if (merged) {
+            m_db->markAsModified();
+        } else {
+            m_db->markAsClean();
         }
 
-        replaceDatabase(db);
         processAutoOpen();
-        restoreGroupEntryFocus(groupBeforeReload, entryBeforeReload);
         m_blockAutoSave = false;
     } else {
         showMessage(tr("Could not open the new database file while attempting to autoreload.\nError: %1").arg(error),
@@ -40,6 +40,7 @@ class EditGroupWidget;
 class Entry;
 class EntryView;
 class EntrySearcher;
+class EntrySearchIndex;
 class Group;
 class GroupView;
 class QFile;
@@ -293,6 +294,7 @@ private:
 
     // Search state
     QScopedPointer<EntrySearcher> m_entrySearcher;
+    QPointer<EntrySearchIndex> m_searchIndex;
     QString m_lastSearchText;
     bool m_searchLimitGroup;
 
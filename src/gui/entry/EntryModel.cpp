@@ -24,6 +24,7 @@
 #include "core/Group.h"
 #include "core/Metadata.h"
 #include "core/PasswordHealth.h"
+#include "core/Trace.h"
 #include "gui/Icons.h"
 #include "gui/styles/StateColorPalette.h"
 #ifdef Q_OS_MACOS
@@ -58,6 +59,7 @@ void EntryModel::setGroup(Group* group)
         return;
     }
 
+    Trace::Scope trace("EntryModel::setGroup");
     beginResetModel();
 
     severConnections();
@@ -74,6 +76,7 @@ void EntryModel::setGroup(Group* group)
 
 void EntryModel::setEntries(const QList<Entry*>& entries)
 {
+    Trace::Scope trace("EntryModel::setEntries");
     beginResetModel();
 
     severConnections();
@@ -19,7 +19,6 @@
 #include "EntryURLModel.h"
 
 #include "core/EntryAttributes.h"
-#include "core/Tools.h"
 #include "gui/Icons.h"
 #include "gui/styles/StateColorPalette.h"
 
@@ -66,7 +65,7 @@ QVariant EntryURLModel::data(const QModelIndex& index, int role) const
     }
 
     const auto value = m_entryAttributes->value(key);
-    const auto urlValid = Tools::checkUrlValid(value);
+    const auto urlValid = m_entryAttributes->parsedUrl(key).isValid();
 
     if (role == Qt::BackgroundRole && !urlValid) {
         StateColorPalette statePalette;
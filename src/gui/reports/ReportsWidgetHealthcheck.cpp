@@ -18,7 +18,6 @@
 #include "ReportsWidgetHealthcheck.h"
 #include "ui_ReportsWidgetHealthcheck.h"
 
-#include "core/AsyncTask.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
 #include "core/PasswordHealth.h"
@@ -26,10 +25,14 @@
 #include "gui/Icons.h"
 #include "gui/styles/StateColorPalette.h"
 
+#include <QFutureWatcher>
 #include <QMenu>
+#include <QPointer>
 #include <QShortcut>
 #include <QSortFilterProxyModel>
 #include <QStandardItemModel>
+#include <QTimer>
+#include <QtConcurrentMap>
 
 namespace
 {
@@ -40,21 +43,20 @@ namespace
         {
             QPointer<Group> group;
             QPointer<Entry> entry;
+            // Copies of the evaluated data, the entry itself is only used on the GUI thread
+            QString password;
+            TimeInfo timeInfo;
             QSharedPointer<PasswordHealth> health;
             bool exclude = false;
 
-            Item(Group* g, Entry* e, QSharedPointer<PasswordHealth> h)
+            Item(Group* g, Entry* e)
                 : group(g)
                 , entry(e)
-                , health(h)
+                , password(e->password())
+                , timeInfo(e->timeInfo())
                 , exclude(e->excludeFromReports())
             {
             }
-
-            bool operator<(const Item& rhs) const
-            {
-                return health->score() < rhs.health->score();
-            }
         };
 
         explicit Health(QSharedPointer<Database>);
@@ -69,6 +71,13 @@ namespace
             return m_anyKnownBad;
         }
 
+        // Evaluate one item, called from the thread pool
+        QSharedPointer<Item> evaluate(const QSharedPointer<Item>& item) const
+        {
+            item->health = m_checker.evaluate(item->password, item->timeInfo);
+            return item;
+        }
+
     private:
         QSharedPointer<Database> m_db;
         HealthChecker m_checker;
@@ -76,6 +85,19 @@ namespace
         bool m_anyKnownBad = false;
     };
 
+    // Map functor for QtConcurrent::mapped(), keeps the health check alive while it runs
+    struct HealthEvaluator
+    {
+        typedef QSharedPointer<Health::Item> result_type;
+
+        QSharedPointer<const Health> health;
+
+        result_type operator()(const QSharedPointer<Health::Item>& item) const
+        {
+            return health->evaluate(item);
+        }
+    };
+
     class ReportSortProxyModel : public QSortFilterProxyModel
     {
     public:
@@ -118,22 +140,14 @@ Health::Health(QSharedPointer<Database> db)
                 continue;
             }
 
-            // Evaluate this entry
-            const auto item = QSharedPointer<Item>(new Item(group, entry, m_checker.evaluate(entry)));
+            // Collect this entry, the evaluation is done by evaluate()
+            const auto item = QSharedPointer<Item>(new Item(group, entry));
             if (item->exclude) {
                 m_anyKnownBad = true;
             }
-
-            // Add entry if its password isn't at least "good"
-            if (item->health->quality() < PasswordHealth::Quality::Good) {
-                m_items.append(item);
-            }
+            m_items.append(item);
         }
     }
-
-    // Sort the result so that the worst passwords (least score)
-    // are at the top
-    std::sort(m_items.begin(), m_items.end(), [](QSharedPointer<Item> x, QSharedPointer<Item> y) { return *x < *y; });
 }
 
 ReportsWidgetHealthcheck::ReportsWidgetHealthcheck(QWidget* parent)
@@ -160,6 +174,7 @@ ReportsWidgetHealthcheck::ReportsWidgetHealthcheck(QWidget* parent)
 
 ReportsWidgetHealthcheck::~ReportsWidgetHealthcheck()
 {
+    stopHealthCheck();
 }
 
 void ReportsWidgetHealthcheck::addHealthRow(QSharedPointer<PasswordHealth> health,
@@ -229,6 +244,7 @@ void ReportsWidgetHealthcheck::addHealthRow(QSharedPointer<PasswordHealth> healt
 
 void ReportsWidgetHealthcheck::loadSettings(QSharedPointer<Database> db)
 {
+    stopHealthCheck();
     m_db = std::move(db);
     m_healthCalculated = false;
     m_referencesModel->clear();
@@ -250,40 +266,79 @@ void ReportsWidgetHealthcheck::showEvent(QShowEvent* event)
     }
 }
 
+void ReportsWidgetHealthcheck::hideEvent(QHideEvent* event)
+{
+    QWidget::hideEvent(event);
+
+    // Entries may be edited or deleted while the report is hidden, start over when it is shown again
+    if (m_healthWatcher) {
+        stopHealthCheck();
+        m_healthCalculated = false;
+    }
+}
+
 void ReportsWidgetHealthcheck::calculateHealth()
 {
+    stopHealthCheck();
     m_referencesModel->clear();
-
-    // Perform the health check
-    const QScopedPointer<Health> health(AsyncTask::runAndWaitForFuture([this] { return new Health(m_db); }));
+    m_rowToEntry.clear();
 
     // Display entries that are marked as "known bad"?
     const auto showExcluded = m_ui->showKnownBadCheckBox->isChecked();
+    const auto excludeExpired = m_ui->excludeExpired->isChecked();
+
+    // Perform the health check on all cores, rows are added as soon as their entries are evaluated
+    const auto health = QSharedPointer<const Health>(new Health(m_db));
+    auto watcher = new QFutureWatcher<QSharedPointer<Health::Item>>(this);
+    m_healthWatcher = watcher;
+
+    connect(watcher, &QFutureWatcherBase::resultsReadyAt, this, [this, watcher, showExcluded, excludeExpired](
+                                                                    int begin, int end) {
+        const auto firstRows = m_referencesModel->rowCount() == 0;
+        for (int i = begin; i < end; ++i) {
+            const auto item = watcher->resultAt(i);
+            if (!item->entry || !item->group) {
+                continue;
+            }
 
-    // Display the entries
-    m_rowToEntry.clear();
-    for (const auto& item : health->items()) {
-        auto excluded = item->exclude || (item->entry->isExpired() && m_ui->excludeExpired->isChecked());
-        if (excluded && !showExcluded) {
-            // Exclude this entry from the report
-            continue;
+            // Add entry if its password isn't at least "good"
+            if (item->health->quality() >= PasswordHealth::Quality::Good) {
+                continue;
+            }
+
+            auto excluded = item->exclude || (item->entry->isExpired() && excludeExpired);
+            if (excluded && !showExcluded) {
+                // Exclude this entry from the report
+                continue;
+            }
+
+            // Show the entry in the report
+            addHealthRow(item->health, item->group, item->entry, item->exclude);
         }
 
-        // Show the entry in the report
-        addHealthRow(item->health, item->group, item->entry, item->exclude);
-    }
+        // Size the columns for the first rows, the final size is set when all rows are in
+        if (firstRows) {
+            m_ui->healthcheckTableView->resizeColumnsToContents();
+        }
+    });
 
-    // Set the table header
-    if (m_referencesModel->rowCount() == 0) {
-        m_referencesModel->setHorizontalHeaderLabels(QStringList() << tr("Congratulations, everything is healthy!"));
-    } else {
-        m_referencesModel->setHorizontalHeaderLabels(QStringList() << tr("") << tr("Title") << tr("Path") << tr("Score")
-                                                                   << tr("Reason"));
-        m_ui->healthcheckTableView->sortByColumn(0, Qt::AscendingOrder);
-    }
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher] {
+        m_healthWatcher = nullptr;
+        watcher->deleteLater();
+
+        if (m_referencesModel->rowCount() == 0) {
+            m_referencesModel->clear();
+            m_referencesModel->setHorizontalHeaderLabels(QStringList()
+                                                         << tr("Congratulations, everything is healthy!"));
+        }
+        m_ui->healthcheckTableView->resizeColumnsToContents();
+        m_ui->healthcheckTableView->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Fixed);
+    });
 
-    m_ui->healthcheckTableView->resizeColumnsToContents();
-    m_ui->healthcheckTableView->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Fixed);
+    // Set the table header, the worst passwords are sorted to the top while rows come in
+    m_referencesModel->setHorizontalHeaderLabels(QStringList() << tr("") << tr("Title") << tr("Path") << tr("Score")
+                                                               << tr("Reason"));
+    m_ui->healthcheckTableView->sortByColumn(0, Qt::AscendingOrder);
 
     // Show the "show known bad entries" checkbox if there's any known
     // bad entry in the database.
@@ -292,6 +347,24 @@ void ReportsWidgetHealthcheck::calculateHealth()
     } else {
         m_ui->showKnownBadCheckBox->hide();
     }
+
+    watcher->setFuture(QtConcurrent::mapped(health->items(), HealthEvaluator{health}));
+}
+
+/**
+ * Cancel a running health check and wait for the entries that are being evaluated.
+ */
+void ReportsWidgetHealthcheck::stopHealthCheck()
+{
+    if (!m_healthWatcher) {
+        return;
+    }
+
+    m_healthWatcher->disconnect(this);
+    m_healthWatcher->cancel();
+    m_healthWatcher->waitForFinished();
+    m_healthWatcher->deleteLater();
+    m_healthWatcher = nullptr;
 }
 
 void ReportsWidgetHealthcheck::emitEntryActivated(const QModelIndex& index)
@@ -305,6 +378,7 @@ void ReportsWidgetHealthcheck::emitEntryActivated(const QModelIndex& index)
     const auto group = row.first;
     const auto entry = row.second;
     if (group && entry) {
+        stopHealthCheck();
         emit entryActivated(const_cast<Entry*>(entry));
     }
 }
@@ -326,6 +400,7 @@ void ReportsWidgetHealthcheck::customMenuRequested(QPoint pos)
         connect(edit, &QAction::triggered, edit, [this, selected] {
             auto row = m_modelProxy->mapToSource(selected[0]).row();
             auto entry = m_rowToEntry[row].second;
+            stopHealthCheck();
             emit entryActivated(entry);
         });
     }
@@ -374,6 +449,8 @@ void ReportsWidgetHealthcheck::saveSettings()
 
 void ReportsWidgetHealthcheck::deleteSelectedEntries()
 {
+    stopHealthCheck();
+
     QList<Entry*> selectedEntries;
     for (auto index : m_ui->healthcheckTableView->selectionModel()->selectedRows()) {
         auto row = m_modelProxy->mapToSource(index).row();
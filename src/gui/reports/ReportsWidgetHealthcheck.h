@@ -25,6 +25,7 @@ class Database;
 class Entry;
 class Group;
 class PasswordHealth;
+class QFutureWatcherBase;
 class QSortFilterProxyModel;
 class QStandardItemModel;
 
@@ -45,6 +46,7 @@ public:
 
 protected:
     void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
 
 signals:
     void entryActivated(Entry*);
@@ -57,6 +59,7 @@ public slots:
 
 private:
     void addHealthRow(QSharedPointer<PasswordHealth>, Group*, Entry*, bool knownBad);
+    void stopHealthCheck();
 
     QScopedPointer<Ui::ReportsWidgetHealthcheck> m_ui;
 
@@ -65,6 +68,7 @@ private:
     QScopedPointer<QSortFilterProxyModel> m_modelProxy;
     QSharedPointer<Database> m_db;
     QList<QPair<Group*, Entry*>> m_rowToEntry;
+    QFutureWatcherBase* m_healthWatcher = nullptr;
 };
 
 #endif // KEEPASSXC_REPORTSWIDGETHEALTHCHECK_H
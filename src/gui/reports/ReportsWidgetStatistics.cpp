@@ -26,6 +26,7 @@
 
 #include <QFileInfo>
 #include <QStandardItemModel>
+#include <QtConcurrentFilter>
 
 namespace
 {
@@ -99,6 +100,7 @@ namespace
         void gatherStats(const QList<Group*>& groups)
         {
             auto checker = HealthChecker(m_db);
+            QList<const Entry*> evaluatedEntries;
 
             for (const auto* group : groups) {
                 // Don't count anything in the recycle bin
@@ -134,8 +136,8 @@ namespace
                         }
 
                         // Speed up Zxcvbn process by excluding very long passwords and most passphrases
-                        if (pwd.size() < 25 && checker.evaluate(entry)->quality() <= PasswordHealth::Quality::Weak) {
-                            ++weakPasswords;
+                        if (pwd.size() < 25) {
+                            evaluatedEntries << entry;
                         }
 
                         if (entry->excludeFromReports()) {
@@ -147,6 +149,11 @@ namespace
                     }
                 }
             }
+
+            // Evaluate the passwords on all cores
+            weakPasswords = QtConcurrent::blockingFiltered(evaluatedEntries, [&checker](const Entry* entry) {
+                                return checker.evaluate(entry)->quality() <= PasswordHealth::Quality::Weak;
+                            }).size();
         }
     };
 } // namespace
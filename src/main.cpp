@@ -23,6 +23,7 @@
 #include "cli/Utils.h"
 #include "config-keepassx.h"
 #include "core/Tools.h"
+#include "core/Trace.h"
 #include "crypto/Crypto.h"
 #include "gui/Application.h"
 #include "gui/MainWindow.h"
@@ -74,6 +75,7 @@ int main(int argc, char** argv)
     QCommandLineOption pwstdinOption("pw-stdin", QObject::tr("read password of the database from stdin"));
     QCommandLineOption allowScreenCaptureOption("allow-screencapture",
                                                 QObject::tr("allow app screen recordering and screenshots"));
+    QCommandLineOption traceOption("trace", QObject::tr("write a performance trace to a file on exit"), "trace");
 
     QCommandLineOption helpOption = parser.addHelpOption();
     QCommandLineOption versionOption = parser.addVersionOption();
@@ -84,6 +86,7 @@ int main(int argc, char** argv)
     parser.addOption(keyfileOption);
     parser.addOption(pwstdinOption);
     parser.addOption(debugInfoOption);
+    parser.addOption(traceOption);
 
     if (osUtils->canPreventScreenCapture()) {
         parser.addOption(allowScreenCaptureOption);
@@ -146,6 +149,9 @@ int main(int argc, char** argv)
 #endif
 
     Application::bootstrap();
+    if (parser.isSet(traceOption)) {
+        Trace::start(parser.value(traceOption));
+    }
 
     MainWindow mainWindow;
 
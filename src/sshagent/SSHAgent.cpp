@@ -19,6 +19,7 @@
 #include "SSHAgent.h"
 
 #include "core/Config.h"
+#include "core/Global.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
 #include "sshagent/BinaryStream.h"
@@ -159,39 +160,112 @@ bool SSHAgent::isAgentRunning() const
 
 bool SSHAgent::sendMessage(const QByteArray& in, QByteArray& out)
 {
-#ifdef Q_OS_WIN
-    if (usePageant() && !sendMessagePageant(in, out)) {
+    QList<QByteArray> responses;
+    if (!sendMessages({in}, responses)) {
         return false;
     }
-    if (useOpenSSH() && !sendMessageOpenSSH(in, out)) {
+
+    out = responses.first();
+    return true;
+}
+
+/**
+ * Send requests to the agent and read the responses in the same order.
+ *
+ * @param in requests
+ * @param out responses, on failure only those of the requests that were answered
+ * @return true on success
+ */
+bool SSHAgent::sendMessages(const QList<QByteArray>& in, QList<QByteArray>& out)
+{
+#ifdef Q_OS_WIN
+    if (usePageant()) {
+        out.clear();
+        for (const QByteArray& request : in) {
+            QByteArray response;
+            if (!sendMessagePageant(request, response)) {
+                return false;
+            }
+            out.append(response);
+        }
+    }
+    if (useOpenSSH() && !sendMessagesOpenSSH(in, out)) {
         return false;
     }
     return true;
 #else
-    return sendMessageOpenSSH(in, out);
+    return sendMessagesOpenSSH(in, out);
 #endif
 }
 
-bool SSHAgent::sendMessageOpenSSH(const QByteArray& in, QByteArray& out)
+/**
+ * Connect to the OpenSSH agent unless the connection of a previous request is still open.
+ *
+ * @param reused set to true if an existing connection is used
+ * @return true on success
+ */
+bool SSHAgent::connectOpenSSH(bool& reused)
 {
-    QLocalSocket socket;
-    BinaryStream stream(&socket);
+    const QString path = socketPath();
+    reused = m_socket && m_socket->state() == QLocalSocket::ConnectedState && m_socket->serverName() == path
+             && m_socket->bytesAvailable() == 0;
+    if (reused) {
+        return true;
+    }
 
-    socket.connectToServer(socketPath());
-    if (!socket.waitForConnected(500)) {
+    m_socket.reset(new QLocalSocket());
+    m_socket->connectToServer(path);
+    if (!m_socket->waitForConnected(500)) {
+        m_socket.reset();
         m_error = tr("Agent connection failed.");
         return false;
     }
 
-    stream.writeString(in);
-    stream.flush();
+    return true;
+}
+
+/**
+ * All requests are written before the first response is read, so a batch
+ * of requests costs a single round trip to the agent.
+ */
+bool SSHAgent::sendMessagesOpenSSH(const QList<QByteArray>& in, QList<QByteArray>& out)
+{
+    bool reused = false;
+    if (!connectOpenSSH(reused)) {
+        return false;
+    }
 
-    if (!stream.readString(out)) {
+    out.clear();
+    {
+        // The stream is a child of the socket and must be gone before the socket is reset
+        BinaryStream stream(m_socket.data());
+        for (const QByteArray& request : in) {
+            stream.writeString(request);
+        }
+        stream.flush();
+
+        for (int i = 0; i < in.size(); ++i) {
+            QByteArray response;
+            if (!stream.readString(response)) {
+                break;
+            }
+            out.append(response);
+        }
+    }
+
+    if (out.size() != in.size()) {
+        m_socket.reset();
+        // The agent may have closed the connection since the last request, resend what it did not answer
+        if (reused) {
+            QList<QByteArray> remaining;
+            const bool success = sendMessagesOpenSSH(in.mid(out.size()), remaining);
+            out.append(remaining);
+            return success;
+        }
         m_error = tr("Agent protocol error.");
         return false;
     }
 
-    socket.close();
     return true;
 }
 
@@ -270,70 +344,119 @@ bool SSHAgent::sendMessagePageant(const QByteArray& in, QByteArray& out)
  */
 bool SSHAgent::addIdentity(OpenSSHKey& key, const KeeAgentSettings& settings, const QUuid& databaseUuid)
 {
-    if (!isAgentRunning()) {
-        m_error = tr("No agent running, cannot add identity.");
+    QList<OpenSSHKey> keys{key};
+    const QString error = addIdentities(keys, {settings}, databaseUuid).first();
+    if (!error.isEmpty()) {
+        m_error = error;
         return false;
     }
+    return true;
+}
 
-    if (m_addedKeys.contains(key) && m_addedKeys[key].first != databaseUuid) {
-        m_error = tr("Key identity ownership conflict. Refusing to add.");
-        return false;
+/**
+ * Add identities to the SSH agent. All requests are sent before the
+ * first response is read, so adding many keys needs a single round trip.
+ *
+ * @param keys identities / keys to add
+ * @param settings constraints (lifetime, confirm), remove-on-lock of each key
+ * @param databaseUuid database that owns the keys for remove-on-lock
+ * @return error message for each key, empty if the key was added
+ */
+QStringList
+SSHAgent::addIdentities(QList<OpenSSHKey>& keys, const QList<KeeAgentSettings>& settings, const QUuid& databaseUuid)
+{
+    Q_ASSERT(keys.size() == settings.size());
+
+    QStringList errors;
+    if (!isAgentRunning()) {
+        for (int i = 0; i < keys.size(); ++i) {
+            errors << tr("No agent running, cannot add identity.");
+        }
+        return errors;
     }
 
-    QByteArray requestData;
-    BinaryStream request(&requestData);
-    bool isSecurityKey = key.type().startsWith("sk-");
+    QList<QByteArray> requests;
+    QList<int> requestKeys;
+    for (int i = 0; i < keys.size(); ++i) {
+        OpenSSHKey& key = keys[i];
+        if (m_addedKeys.contains(key) && m_addedKeys[key].first != databaseUuid) {
+            errors << tr("Key identity ownership conflict. Refusing to add.");
+            continue;
+        }
+        errors << QString();
 
-    request.write(
-        (settings.useLifetimeConstraintWhenAdding() || settings.useConfirmConstraintWhenAdding() || isSecurityKey)
-            ? SSH_AGENTC_ADD_ID_CONSTRAINED
-            : SSH_AGENTC_ADD_IDENTITY);
-    key.writePrivate(request);
+        QByteArray requestData;
+        BinaryStream request(&requestData);
+        bool isSecurityKey = key.type().startsWith("sk-");
 
-    if (settings.useLifetimeConstraintWhenAdding()) {
-        request.write(SSH_AGENT_CONSTRAIN_LIFETIME);
-        request.write(static_cast<quint32>(settings.lifetimeConstraintDuration()));
-    }
+        request.write((settings[i].useLifetimeConstraintWhenAdding() || settings[i].useConfirmConstraintWhenAdding()
+                       || isSecurityKey)
+                          ? SSH_AGENTC_ADD_ID_CONSTRAINED
+                          : SSH_AGENTC_ADD_IDENTITY);
+        key.writePrivate(request);
+
+        if (settings[i].useLifetimeConstraintWhenAdding()) {
+            request.write(SSH_AGENT_CONSTRAIN_LIFETIME);
+            request.write(static_cast<quint32>(settings[i].lifetimeConstraintDuration()));
+        }
+
+        if (settings[i].useConfirmConstraintWhenAdding()) {
+            request.write(SSH_AGENT_CONSTRAIN_CONFIRM);
+        }
 
-    if (settings.useConfirmConstraintWhenAdding()) {
-        request.write(SSH_AGENT_CONSTRAIN_CONFIRM);
+        if (isSecurityKey) {
+            request.write(SSH_AGENT_CONSTRAIN_EXTENSION);
+            request.writeString(QString("sk-provider@openssh.com"));
+            request.writeString(securityKeyProvider());
+        }
+
+        requests << requestData;
+        requestKeys << i;
     }
 
-    if (isSecurityKey) {
-        request.write(SSH_AGENT_CONSTRAIN_EXTENSION);
-        request.writeString(QString("sk-provider@openssh.com"));
-        request.writeString(securityKeyProvider());
+    if (requests.isEmpty()) {
+        return errors;
     }
 
-    QByteArray responseData;
-    if (!sendMessage(requestData, responseData)) {
-        return false;
+    // Keys the agent accepted before a failure are still recorded for remove-on-lock
+    QList<QByteArray> responses;
+    if (!sendMessages(requests, responses)) {
+        for (int r = responses.size(); r < requestKeys.size(); ++r) {
+            errors[requestKeys[r]] = m_error;
+        }
     }
 
-    if (responseData.length() < 1 || static_cast<quint8>(responseData[0]) != SSH_AGENT_SUCCESS) {
-        m_error =
-            tr("Agent refused this identity. Possible reasons include:") + "\n" + tr("The key has already been added.");
+    for (int r = 0; r < responses.size(); ++r) {
+        const int i = requestKeys[r];
+        const QByteArray& responseData = responses[r];
+        if (responseData.length() < 1 || static_cast<quint8>(responseData[0]) != SSH_AGENT_SUCCESS) {
+            QString error = tr("Agent refused this identity. Possible reasons include:") + "\n"
+                            + tr("The key has already been added.");
 
-        if (settings.useLifetimeConstraintWhenAdding()) {
-            m_error += "\n" + tr("Restricted lifetime is not supported by the agent (check options).");
-        }
+            if (settings[i].useLifetimeConstraintWhenAdding()) {
+                error += "\n" + tr("Restricted lifetime is not supported by the agent (check options).");
+            }
 
-        if (settings.useConfirmConstraintWhenAdding()) {
-            m_error += "\n" + tr("A confirmation request is not supported by the agent (check options).");
-        }
+            if (settings[i].useConfirmConstraintWhenAdding()) {
+                error += "\n" + tr("A confirmation request is not supported by the agent (check options).");
+            }
 
-        if (isSecurityKey) {
-            m_error +=
-                "\n" + tr("Security keys are not supported by the agent or the security key provider is unavailable.");
+            if (keys[i].type().startsWith("sk-")) {
+                error += "\n"
+                         + tr("Security keys are not supported by the agent or the security key provider is "
+                              "unavailable.");
+            }
+
+            errors[i] = error;
+            continue;
         }
 
-        return false;
+        OpenSSHKey keyCopy = keys[i];
+        keyCopy.clearPrivate();
+        m_addedKeys[keyCopy] = qMakePair(databaseUuid, settings[i].removeAtDatabaseClose());
     }
 
-    OpenSSHKey keyCopy = key;
-    keyCopy.clearPrivate();
-    m_addedKeys[keyCopy] = qMakePair(databaseUuid, settings.removeAtDatabaseClose());
-    return true;
+    return errors;
 }
 
 /**
@@ -514,6 +637,8 @@ void SSHAgent::databaseUnlocked(QSharedPointer<Database> db)
         return;
     }
 
+    QList<OpenSSHKey> keys;
+    QList<KeeAgentSettings> keySettings;
     for (Entry* e : db->rootGroup()->entriesRecursive()) {
         if (db->metadata()->recycleBinEnabled() && e->group() == db->metadata()->recycleBin()) {
             continue;
@@ -535,9 +660,23 @@ void SSHAgent::databaseUnlocked(QSharedPointer<Database> db)
             continue;
         }
 
-        // Add key to agent; ignore errors if we have previously added the key
-        bool known_key = m_addedKeys.contains(key);
-        if (!addIdentity(key, settings, db->uuid()) && !known_key) {
+        keys.append(key);
+        keySettings.append(settings);
+    }
+
+    if (keys.isEmpty()) {
+        return;
+    }
+
+    // Add all keys to the agent at once; ignore errors if we have previously added the key
+    QList<bool> knownKeys;
+    for (const OpenSSHKey& key : asConst(keys)) {
+        knownKeys << m_addedKeys.contains(key);
+    }
+    const QStringList errors = addIdentities(keys, keySettings, db->uuid());
+    for (int i = 0; i < errors.size(); ++i) {
+        if (!errors[i].isEmpty() && !knownKeys[i]) {
+            m_error = errors[i];
             emit error(m_error);
         }
     }
@@ -20,6 +20,7 @@
 #define KEEPASSXC_SSHAGENT_H
 
 #include <QHash>
+#include <QLocalSocket>
 
 #include "OpenSSHKey.h"
 
@@ -52,6 +53,8 @@ public:
     const QString errorString() const;
     bool isAgentRunning() const;
     bool addIdentity(OpenSSHKey& key, const KeeAgentSettings& settings, const QUuid& databaseUuid);
+    QStringList
+    addIdentities(QList<OpenSSHKey>& keys, const QList<KeeAgentSettings>& settings, const QUuid& databaseUuid);
     bool listIdentities(QList<QSharedPointer<OpenSSHKey>>& list);
     bool checkIdentity(const OpenSSHKey& key, bool& loaded);
     bool removeIdentity(OpenSSHKey& key);
@@ -80,7 +83,9 @@ private:
     const quint8 SSH_AGENT_CONSTRAIN_EXTENSION = 255;
 
     bool sendMessage(const QByteArray& in, QByteArray& out);
-    bool sendMessageOpenSSH(const QByteArray& in, QByteArray& out);
+    bool sendMessages(const QList<QByteArray>& in, QList<QByteArray>& out);
+    bool sendMessagesOpenSSH(const QList<QByteArray>& in, QList<QByteArray>& out);
+    bool connectOpenSSH(bool& reused);
 #ifdef Q_OS_WIN
     bool sendMessagePageant(const QByteArray& in, QByteArray& out);
 
@@ -90,6 +95,8 @@ private:
 
     QHash<OpenSSHKey, QPair<QUuid, bool>> m_addedKeys;
     QString m_error;
+    // Connection to the OpenSSH agent, kept open between requests
+    QScopedPointer<QLocalSocket> m_socket;
 };
 
 static inline SSHAgent* sshAgent()
@@ -0,0 +1,333 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PipelineStream.h"
+
+#include <QThread>
+
+namespace
+{
+    const int DefaultChunkSize = 256 * 1024;
+    const int DefaultQueueSize = 8;
+} // namespace
+
+class PipelineStream::Worker : public QThread
+{
+public:
+    Worker(PipelineStream* stream, bool reading)
+        : m_stream(stream)
+        , m_reading(reading)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        if (m_reading) {
+            m_stream->produce();
+        } else {
+            m_stream->consume();
+        }
+    }
+
+private:
+    PipelineStream* const m_stream;
+    const bool m_reading;
+};
+
+PipelineStream::PipelineStream(QIODevice* baseDevice)
+    : PipelineStream(baseDevice, DefaultChunkSize, DefaultQueueSize)
+{
+}
+
+PipelineStream::PipelineStream(QIODevice* baseDevice, int chunkSize, int queueSize)
+    : LayeredStream(baseDevice)
+    , m_chunkSize(chunkSize)
+    , m_queueSize(queueSize)
+    , m_threaded(isThreaded())
+{
+    Q_ASSERT(chunkSize > 0);
+    Q_ASSERT(queueSize > 0);
+}
+
+PipelineStream::~PipelineStream()
+{
+    close();
+}
+
+/**
+ * @return true if pipelines use a worker thread, false if they pass through
+ */
+bool PipelineStream::isThreaded()
+{
+    return QThread::idealThreadCount() > 1;
+}
+
+bool PipelineStream::open(QIODevice::OpenMode mode)
+{
+    if (!LayeredStream::open(mode)) {
+        return false;
+    }
+
+    resetState();
+    return true;
+}
+
+/**
+ * Wait until all data has been written to the base device, or discard all
+ * data that was read ahead.
+ *
+ * @return false if the worker failed to read or write the base device
+ */
+bool PipelineStream::reset()
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    bool ok = stopWorker();
+    resetState();
+    return ok;
+}
+
+void PipelineStream::close()
+{
+    if (isOpen()) {
+        stopWorker();
+    }
+
+    LayeredStream::close();
+}
+
+bool PipelineStream::atEnd() const
+{
+    if (!m_worker || !isReadable()) {
+        return m_bufferPos == m_buffer.size() && m_baseDevice->atEnd();
+    }
+    if (m_bufferPos < m_buffer.size()) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    while (m_queue.isEmpty() && !m_finished) {
+        m_queueChanged.wait(&m_mutex);
+    }
+    return m_queue.isEmpty();
+}
+
+qint64 PipelineStream::readData(char* data, qint64 maxSize)
+{
+    if (!m_threaded) {
+        qint64 bytesRead = m_baseDevice->read(data, maxSize);
+        if (bytesRead < 0) {
+            setErrorString(m_baseDevice->errorString());
+        }
+        return bytesRead;
+    }
+    if (!m_worker) {
+        startWorker();
+    }
+
+    qint64 bytesRead = 0;
+    while (bytesRead < maxSize) {
+        if (m_bufferPos == m_buffer.size()) {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.isEmpty() && !m_finished) {
+                m_queueChanged.wait(&m_mutex);
+            }
+            if (m_queue.isEmpty()) {
+                if (m_error && bytesRead == 0) {
+                    setErrorString(m_workerError);
+                    return -1;
+                }
+                break;
+            }
+            m_buffer = m_queue.dequeue();
+            m_bufferPos = 0;
+            m_queueChanged.wakeAll();
+        }
+
+        qint64 bytesToCopy = qMin(maxSize - bytesRead, static_cast<qint64>(m_buffer.size() - m_bufferPos));
+
+        memcpy(data + bytesRead, m_buffer.constData() + m_bufferPos, static_cast<size_t>(bytesToCopy));
+
+        bytesRead += bytesToCopy;
+        m_bufferPos += bytesToCopy;
+    }
+
+    return bytesRead;
+}
+
+qint64 PipelineStream::writeData(const char* data, qint64 maxSize)
+{
+    if (!m_threaded) {
+        qint64 bytesWritten = m_baseDevice->write(data, maxSize);
+        if (bytesWritten < 0) {
+            setErrorString(m_baseDevice->errorString());
+        }
+        return bytesWritten;
+    }
+    if (!m_worker) {
+        startWorker();
+    }
+
+    m_buffer.append(data, static_cast<int>(maxSize));
+    if (m_buffer.size() >= m_chunkSize) {
+        if (!enqueue(m_buffer)) {
+            return -1;
+        }
+        m_buffer.clear();
+    }
+
+    return maxSize;
+}
+
+void PipelineStream::resetState()
+{
+    m_queue.clear();
+    m_finished = false;
+    m_stopped = false;
+    m_error = false;
+    m_workerError.clear();
+    m_buffer.clear();
+    m_bufferPos = 0;
+}
+
+void PipelineStream::startWorker()
+{
+    m_worker.reset(new Worker(this, isReadable()));
+    m_worker->start();
+}
+
+bool PipelineStream::stopWorker()
+{
+    if (!m_worker) {
+        return true;
+    }
+
+    if (isWritable() && !m_buffer.isEmpty()) {
+        enqueue(m_buffer);
+        m_buffer.clear();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        // A reader drops whatever it read ahead, a writer finishes the queue first
+        if (isReadable()) {
+            m_stopped = true;
+        } else {
+            m_finished = true;
+        }
+        m_queueChanged.wakeAll();
+    }
+
+    m_worker->wait();
+    m_worker.reset();
+
+    if (m_error) {
+        setErrorString(m_workerError);
+        return false;
+    }
+    return true;
+}
+
+bool PipelineStream::enqueue(const QByteArray& chunk)
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_queue.size() >= m_queueSize && !m_error) {
+        m_queueChanged.wait(&m_mutex);
+    }
+    if (m_error) {
+        setErrorString(m_workerError);
+        return false;
+    }
+
+    m_queue.enqueue(chunk);
+    m_queueChanged.wakeAll();
+    return true;
+}
+
+/**
+ * Worker loop in read mode, reads ahead from the base device until it is
+ * exhausted or the stream is stopped.
+ */
+void PipelineStream::produce()
+{
+    while (true) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_stopped) {
+                return;
+            }
+        }
+
+        QByteArray chunk(m_chunkSize, Qt::Uninitialized);
+        qint64 bytesRead = m_baseDevice->read(chunk.data(), m_chunkSize);
+
+        QMutexLocker locker(&m_mutex);
+        if (bytesRead <= 0) {
+            if (bytesRead < 0) {
+                m_error = true;
+                m_workerError = m_baseDevice->errorString();
+            }
+            m_finished = true;
+            m_queueChanged.wakeAll();
+            return;
+        }
+
+        chunk.resize(static_cast<int>(bytesRead));
+        while (m_queue.size() >= m_queueSize && !m_stopped) {
+            m_queueChanged.wait(&m_mutex);
+        }
+        if (m_stopped) {
+            return;
+        }
+        m_queue.enqueue(chunk);
+        m_queueChanged.wakeAll();
+    }
+}
+
+/**
+ * Worker loop in write mode, writes queued chunks to the base device until
+ * the queue is finished or writing fails.
+ */
+void PipelineStream::consume()
+{
+    while (true) {
+        QByteArray chunk;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.isEmpty() && !m_finished) {
+                m_queueChanged.wait(&m_mutex);
+            }
+            if (m_queue.isEmpty()) {
+                return;
+            }
+            chunk = m_queue.dequeue();
+            m_queueChanged.wakeAll();
+        }
+
+        if (m_baseDevice->write(chunk) != chunk.size()) {
+            QMutexLocker locker(&m_mutex);
+            m_error = true;
+            m_workerError = m_baseDevice->errorString();
+            m_queue.clear();
+            m_queueChanged.wakeAll();
+            return;
+        }
+    }
+}
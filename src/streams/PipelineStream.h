@@ -0,0 +1,92 @@
+/*
+ *  Copyright (C) 2021 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSX_PIPELINESTREAM_H
+#define KEEPASSX_PIPELINESTREAM_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QQueue>
+#include <QScopedPointer>
+#include <QWaitCondition>
+
+#include "streams/LayeredStream.h"
+
+class QThread;
+
+/**
+ * Moves the work of the base device onto a worker thread.
+ *
+ * In read mode the worker reads ahead from the base device, in write mode it
+ * writes to the base device behind the caller. Chunks are handed over through
+ * a bounded queue, so stacking pipelines between the layers of a stream runs
+ * each layer on its own core. The worker is started on the first read or
+ * write. If only one core is available the stream passes all calls straight
+ * through to the base device.
+ *
+ * The base device must not be used by anyone else while the stream is open.
+ */
+class PipelineStream : public LayeredStream
+{
+    Q_OBJECT
+
+public:
+    explicit PipelineStream(QIODevice* baseDevice);
+    PipelineStream(QIODevice* baseDevice, int chunkSize, int queueSize);
+    ~PipelineStream() override;
+
+    bool open(QIODevice::OpenMode mode) override;
+    bool reset() override;
+    void close() override;
+
+    bool atEnd() const override;
+
+    static bool isThreaded();
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    class Worker;
+
+    void resetState();
+    void startWorker();
+    bool stopWorker();
+    bool enqueue(const QByteArray& chunk);
+    void produce();
+    void consume();
+
+    const int m_chunkSize;
+    const int m_queueSize;
+    const bool m_threaded;
+    QScopedPointer<QThread> m_worker;
+
+    mutable QMutex m_mutex;
+    mutable QWaitCondition m_queueChanged;
+    QQueue<QByteArray> m_queue;
+    bool m_finished = false;
+    bool m_stopped = false;
+    bool m_error = false;
+    QString m_workerError;
+
+    // Chunk currently read from or written to by the caller
+    QByteArray m_buffer;
+    int m_bufferPos = 0;
+};
+
+#endif // KEEPASSX_PIPELINESTREAM_H
@@ -372,6 +372,52 @@ void TestBrowser::testSearchEntriesWithAdditionalURLs()
     QCOMPARE(additionalResult[0]->url(), QString("https://github.com/"));
 }
 
+void TestBrowser::testSearchEntriesAfterChanges()
+{
+    auto db = QSharedPointer<Database>::create();
+    auto* root = db->rootGroup();
+    auto* group = new Group();
+    group->setParent(root);
+
+    QStringList urls = {"https://github.com/", "https://www.example.com"};
+    auto entries = createEntries(urls, group);
+    QStringList rootUrls = {"https://github.com/login"};
+    auto rootEntries = createEntries(rootUrls, root);
+
+    // Entries are returned in tree order
+    auto result = m_browserService->searchEntries(db, "https://github.com", "https://github.com/session");
+    QCOMPARE(result.length(), 2);
+    QCOMPARE(result[0], rootEntries[0]);
+    QCOMPARE(result[1], entries[0]);
+
+    // A changed URL is found under its new domain only
+    entries[1]->setUrl("https://gist.github.com/");
+    result = m_browserService->searchEntries(db, "https://gist.github.com", "https://gist.github.com");
+    QCOMPARE(result.length(), 3);
+    QCOMPARE(m_browserService->searchEntries(db, "https://www.example.com", "https://www.example.com").length(), 0);
+
+    entries[0]->attributes()->set(BrowserService::ADDITIONAL_URL, "https://www.example.com");
+    result = m_browserService->searchEntries(db, "https://www.example.com", "https://www.example.com");
+    QCOMPARE(result.length(), 1);
+    QCOMPARE(result[0], entries[0]);
+
+    // Removed entries are not found anymore
+    delete rootEntries[0];
+    delete entries[1];
+    result = m_browserService->searchEntries(db, "https://github.com", "https://github.com/session");
+    QCOMPARE(result.length(), 1);
+    QCOMPARE(result[0], entries[0]);
+
+    // Entries of a new root group replace the old ones
+    auto* oldRoot = db->rootGroup();
+    auto* newRoot = new Group();
+    db->setRootGroup(newRoot);
+    delete oldRoot;
+    QCOMPARE(m_browserService->searchEntries(db, "https://github.com", "https://github.com/session").length(), 0);
+    createEntries(urls, newRoot);
+    QCOMPARE(m_browserService->searchEntries(db, "https://github.com", "https://github.com/session").length(), 1);
+}
+
 void TestBrowser::testInvalidEntries()
 {
     auto db = QSharedPointer<Database>::create();
@@ -46,6 +46,7 @@ private slots:
     void testSearchEntriesByUUID();
     void testSearchEntriesWithPort();
     void testSearchEntriesWithAdditionalURLs();
+    void testSearchEntriesAfterChanges();
     void testInvalidEntries();
     void testSubdomainsAndPaths();
     void testValidURLs();
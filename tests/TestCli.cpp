@@ -41,6 +41,7 @@
 #include "cli/Export.h"
 #include "cli/Generate.h"
 #include "cli/Help.h"
+#include "cli/HibpIndex.h"
 #include "cli/Import.h"
 #include "cli/Info.h"
 #include "cli/List.h"
@@ -231,6 +232,7 @@ void TestCli::testBatchCommands()
     QVERIFY(Commands::getCommand("export"));
     QVERIFY(Commands::getCommand("generate"));
     QVERIFY(Commands::getCommand("help"));
+    QVERIFY(Commands::getCommand("hibp-index"));
     QVERIFY(Commands::getCommand("import"));
     QVERIFY(Commands::getCommand("ls"));
     QVERIFY(Commands::getCommand("merge"));
@@ -242,7 +244,7 @@ void TestCli::testBatchCommands()
     QVERIFY(Commands::getCommand("show"));
     QVERIFY(Commands::getCommand("search"));
     QVERIFY(!Commands::getCommand("doesnotexist"));
-    QCOMPARE(Commands::getCommands().size(), 25);
+    QCOMPARE(Commands::getCommands().size(), 26);
 }
 
 void TestCli::testInteractiveCommands()
@@ -263,6 +265,7 @@ void TestCli::testInteractiveCommands()
     QVERIFY(Commands::getCommand("exit"));
     QVERIFY(Commands::getCommand("generate"));
     QVERIFY(Commands::getCommand("help"));
+    QVERIFY(Commands::getCommand("hibp-index"));
     QVERIFY(Commands::getCommand("ls"));
     QVERIFY(Commands::getCommand("merge"));
     QVERIFY(Commands::getCommand("mkdir"));
@@ -274,7 +277,7 @@ void TestCli::testInteractiveCommands()
     QVERIFY(Commands::getCommand("show"));
     QVERIFY(Commands::getCommand("search"));
     QVERIFY(!Commands::getCommand("doesnotexist"));
-    QCOMPARE(Commands::getCommands().size(), 25);
+    QCOMPARE(Commands::getCommands().size(), 26);
 }
 
 void TestCli::testAdd()
@@ -442,6 +445,45 @@ void TestCli::testAnalyze()
     QVERIFY(output.contains("123"));
     m_stderr->readLine(); // Skip password prompt
     QCOMPARE(m_stderr->readAll(), QByteArray());
+
+    // The test file is not ordered by hash, which is noticed and the whole file is read
+    setInput("a");
+    execCmd(analyzeCmd, {"analyze", "--hibp", hibpPath, "--hibp-ordered", m_dbFile->fileName()});
+    output = m_stdout->readAll();
+    QVERIFY(output.contains("Sample Entry"));
+    QVERIFY(output.contains("123"));
+    m_stderr->readLine(); // Skip password prompt
+    QCOMPARE(m_stderr->readAll(), QByteArray());
+}
+
+void TestCli::testHibpIndex()
+{
+    HibpIndex hibpIndexCmd;
+    QVERIFY(!hibpIndexCmd.name.isEmpty());
+    QVERIFY(hibpIndexCmd.getDescriptionLine().contains(hibpIndexCmd.name));
+
+    const QString hibpPath = QString(KEEPASSX_TEST_DATA_DIR).append("/hibp.txt");
+    QScopedPointer<QTemporaryDir> testDir(new QTemporaryDir());
+    const QString indexPath = testDir->path() + "/hibp.index";
+
+    execCmd(hibpIndexCmd, {"hibp-index", hibpPath, indexPath});
+    QCOMPARE(m_stderr->readAll(), QByteArray());
+    QVERIFY(m_stdout->readAll().contains("Successfully created HIBP index."));
+
+    // The index gives the same result as the HIBP file
+    Analyze analyzeCmd;
+    setInput("a");
+    execCmd(analyzeCmd, {"analyze", "--hibp", indexPath, m_dbFile->fileName()});
+    auto output = m_stdout->readAll();
+    QVERIFY(output.contains("Sample Entry"));
+    QVERIFY(output.contains("123"));
+    m_stderr->readLine(); // Skip password prompt
+    QCOMPARE(m_stderr->readAll(), QByteArray());
+
+    // Should refuse to overwrite an existing file
+    execCmd(hibpIndexCmd, {"hibp-index", hibpPath, indexPath});
+    QCOMPARE(m_stdout->readAll(), QByteArray());
+    QCOMPARE(m_stderr->readAll(), QString("File " + indexPath + " already exists.\n").toUtf8());
 }
 
 void TestCli::testAttachmentExport()
@@ -1534,6 +1576,7 @@ void TestCli::testMerge()
     QVERIFY(outLines2.at(0).contains("Overwriting Internet"));
     QVERIFY(outLines2.at(1).contains("Creating missing Some Website"));
     QCOMPARE(outLines2.at(2), QByteArray("Database was not modified by merge operation."));
+    QCOMPARE(outLines2.at(3), QByteArray("Entries: 1 missing, 0 differing, 2 identical."));
 
     mergedDb = QSharedPointer<Database>::create();
     QVERIFY(mergedDb->open(targetFile2.fileName(), oldKey));
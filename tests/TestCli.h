@@ -66,6 +66,7 @@ private slots:
     void testKeyFileOption();
     void testNoPasswordOption();
     void testHelp();
+    void testHibpIndex();
     void testInteractiveCommands();
     void testList();
     void testMerge();
@@ -100,6 +100,46 @@ void TestDatabase::testSave()
     QVERIFY(!QFile::exists(backupFilePath));
 }
 
+void TestDatabase::testSavePrecomputedKey()
+{
+    TemporaryFile tempFile;
+    QVERIFY(tempFile.copyFromFile(dbFileName));
+
+    auto db = QSharedPointer<Database>::create();
+    auto key = QSharedPointer<CompositeKey>::create();
+    key->addKey(QSharedPointer<PasswordKey>::create("a"));
+
+    QString error;
+    QVERIFY(db->open(tempFile.fileName(), key, &error));
+    db->setKeyPrecomputationEnabled(true);
+    QVERIFY(db->isKeyPrecomputationEnabled());
+
+    // Every save has to use a fresh seed, precomputed or not
+    QByteArray seed = db->kdf()->seed();
+    QByteArray transformedKey = db->transformedDatabaseKey();
+    db->metadata()->setName("test");
+    QVERIFY2(db->save(Database::Atomic, {}, &error), error.toLatin1());
+    QVERIFY(db->kdf()->seed() != seed);
+    QVERIFY(db->transformedDatabaseKey() != transformedKey);
+
+    seed = db->kdf()->seed();
+    transformedKey = db->transformedDatabaseKey();
+    db->metadata()->setName("test2");
+    QVERIFY2(db->save(Database::Atomic, {}, &error), error.toLatin1());
+    QVERIFY(db->kdf()->seed() != seed);
+    QVERIFY(db->transformedDatabaseKey() != transformedKey);
+
+    // A precomputed key must not survive a change of the composite key
+    auto newKey = QSharedPointer<CompositeKey>::create();
+    newKey->addKey(QSharedPointer<PasswordKey>::create("b"));
+    QVERIFY(db->setKey(newKey));
+    QVERIFY2(db->save(Database::Atomic, {}, &error), error.toLatin1());
+
+    auto reopened = QSharedPointer<Database>::create();
+    QVERIFY2(reopened->open(tempFile.fileName(), newKey, &error), error.toLatin1());
+    QCOMPARE(reopened->metadata()->name(), QString("test2"));
+}
+
 void TestDatabase::testSignals()
 {
     TemporaryFile tempFile;
@@ -139,6 +179,37 @@ void TestDatabase::testSignals()
     QCOMPARE(spyDiscarded.count(), 1);
 }
 
+void TestDatabase::testReloadFrom()
+{
+    auto key = QSharedPointer<CompositeKey>::create();
+    key->addKey(QSharedPointer<PasswordKey>::create("a"));
+    auto db = QSharedPointer<Database>::create();
+    QVERIFY(db->open(dbFileName, key));
+    auto newDb = QSharedPointer<Database>::create();
+    QVERIFY(newDb->open(dbFileName, key));
+
+    auto target = new Entry();
+    target->setUuid(QUuid::createUuid());
+    target->setPassword("old");
+    target->setGroup(db->rootGroup());
+    auto referencing = new Entry();
+    referencing->setUuid(QUuid::createUuid());
+    referencing->setPassword(QString("{REF:P@I:%1}").arg(target->uuidToHex()));
+    referencing->setGroup(db->rootGroup());
+    QCOMPARE(referencing->resolveMultiplePlaceholders(referencing->password()), QString("old"));
+
+    auto newTarget = target->clone(Entry::CloneNoFlags);
+    newTarget->setPassword("new");
+    newTarget->setGroup(newDb->rootGroup());
+    referencing->clone(Entry::CloneNoFlags)->setGroup(newDb->rootGroup());
+
+    // The reference resolves to the reloaded value although no modified signal was emitted
+    db->reloadFrom(newDb.data());
+    QCOMPARE(db->rootGroup()->findEntryByUuid(target->uuid()), target);
+    QCOMPARE(target->password(), QString("new"));
+    QCOMPARE(referencing->resolveMultiplePlaceholders(referencing->password()), QString("new"));
+}
+
 void TestDatabase::testEmptyRecycleBinOnDisabled()
 {
     QString filename = QString(KEEPASSX_TEST_DATA_DIR).append("/RecycleBinDisabled.kdbx");
@@ -29,7 +29,9 @@ private slots:
     void initTestCase();
     void testOpen();
     void testSave();
+    void testSavePrecomputedKey();
     void testSignals();
+    void testReloadFrom();
     void testEmptyRecycleBinOnDisabled();
     void testEmptyRecycleBinOnNotCreated();
     void testEmptyRecycleBinOnEmpty();
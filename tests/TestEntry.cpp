@@ -17,11 +17,14 @@
  */
 
 #include <QTest>
+#include <QtConcurrent>
 
 #include "TestEntry.h"
+#include "core/AttachmentStore.h"
 #include "core/Clock.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
+#include "core/StringInterner.h"
 #include "core/TimeInfo.h"
 #include "crypto/Crypto.h"
 
@@ -47,6 +50,68 @@ void TestEntry::testHistoryItemDeletion()
     QVERIFY(historyEntry.isNull());
 }
 
+void TestEntry::testCompactHistory()
+{
+    Database db;
+    db.metadata()->setHistoryMaxItems(3);
+    db.metadata()->setHistoryMaxSize(-1);
+    auto* entry = new Entry();
+    entry->setUuid(QUuid::createUuid());
+    entry->setGroup(db.rootGroup());
+    entry->setTitle("title");
+    entry->setNotes("notes");
+
+    for (int i = 0; i < 5; ++i) {
+        entry->beginUpdate();
+        entry->setPassword(QString("password%1").arg(i));
+        if (i == 2) {
+            entry->attributes()->set("custom", "value", true);
+        } else if (i == 3) {
+            entry->attributes()->remove("custom");
+        }
+        entry->endUpdate();
+    }
+
+    // Edits are recorded compactly and truncated like materialized items
+    QVERIFY(entry->hasCompactHistory());
+    QScopedPointer<Entry> clone(entry->clone(Entry::CloneIncludeHistory));
+    QVERIFY(clone->hasCompactHistory());
+
+    const QList<Entry*> history = entry->historyItems();
+    QVERIFY(!entry->hasCompactHistory());
+    QCOMPARE(history.size(), 3);
+    QCOMPARE(history[0]->password(), QString("password1"));
+    QVERIFY(!history[0]->attributes()->hasKey("custom"));
+    QCOMPARE(history[1]->password(), QString("password2"));
+    QCOMPARE(history[1]->attributes()->value("custom"), QString("value"));
+    QVERIFY(history[1]->attributes()->isProtected("custom"));
+    QCOMPARE(history[2]->password(), QString("password3"));
+    QVERIFY(!history[2]->attributes()->hasKey("custom"));
+    for (const Entry* item : history) {
+        QCOMPARE(item->uuid(), entry->uuid());
+        QCOMPARE(item->title(), QString("title"));
+        QCOMPARE(item->notes(), QString("notes"));
+    }
+
+    // Materialized and compact histories compare equal
+    QVERIFY(entry->equals(clone.data()));
+    entry->compactHistory();
+    QVERIFY(entry->hasCompactHistory());
+    QVERIFY(entry->equals(clone.data()));
+    QCOMPARE(entry->historyItems().at(1)->attributes()->value("custom"), QString("value"));
+
+    // Readers of a shared const entry expand the history only once
+    entry->compactHistory();
+    const Entry* constEntry = entry;
+    QList<QFuture<const Entry*>> futures;
+    for (int i = 0; i < 8; ++i) {
+        futures.append(QtConcurrent::run([constEntry] { return constEntry->historyItems().first(); }));
+    }
+    for (auto& future : futures) {
+        QCOMPARE(future.result(), constEntry->historyItems().first());
+    }
+}
+
 void TestEntry::testCopyDataFrom()
 {
     QScopedPointer<Entry> entry(new Entry());
@@ -82,6 +147,56 @@ void TestEntry::testCopyDataFrom()
     QCOMPARE(entry2->autoTypeAssociations()->get(1).window, QString("3"));
 }
 
+void TestEntry::testAttachmentStore()
+{
+    const int threshold = attachmentStore()->spillThreshold();
+    attachmentStore()->setSpillThreshold(16);
+    const int count = attachmentStore()->count();
+    const qint64 spilledSize = attachmentStore()->spilledSize();
+
+    const QByteArray small("small");
+    const QByteArray large(1000, 'x');
+
+    QScopedPointer<Entry> entry1(new Entry());
+    QScopedPointer<Entry> entry2(new Entry());
+    entry1->attachments()->set("small", small);
+    entry1->attachments()->set("large", large);
+    entry2->attachments()->set("copy", large);
+
+    // Identical content is only stored once
+    QCOMPARE(attachmentStore()->count(), count + 2);
+    QCOMPARE(entry1->attachments()->attachmentData("large"), entry2->attachments()->attachmentData("copy"));
+    QVERIFY(!entry1->attachments()->attachmentData("small")->isSpilled());
+    QVERIFY(entry1->attachments()->attachmentData("large")->isSpilled());
+    QCOMPARE(attachmentStore()->spilledSize(), spilledSize + large.size());
+
+    QCOMPARE(entry1->attachments()->value("small"), small);
+    QCOMPARE(entry1->attachments()->value("large"), large);
+    QCOMPARE(entry2->attachments()->value("copy"), large);
+    QCOMPARE(entry2->attachments()->attachmentsSize(), large.size());
+
+    entry1->attachments()->remove("large");
+    QCOMPARE(attachmentStore()->spilledSize(), spilledSize + large.size());
+    entry2.reset();
+    QCOMPARE(attachmentStore()->spilledSize(), spilledSize);
+    entry1.reset();
+    QCOMPARE(attachmentStore()->count(), count);
+
+    // Replacing data while other data is alive does not grow the temporary file without bound
+    QScopedPointer<Entry> entry3(new Entry());
+    entry3->attachments()->set("kept", large);
+    for (int i = 0; i < 10; ++i) {
+        entry3->attachments()->set("replaced", QByteArray(1000, static_cast<char>(i)));
+        QVERIFY(attachmentStore()->spillFileSize() <= 2 * attachmentStore()->spilledSize());
+    }
+    QCOMPARE(entry3->attachments()->value("kept"), large);
+    QCOMPARE(entry3->attachments()->value("replaced"), QByteArray(1000, 9));
+    entry3.reset();
+    QCOMPARE(attachmentStore()->spilledSize(), spilledSize);
+
+    attachmentStore()->setSpillThreshold(threshold);
+}
+
 void TestEntry::testClone()
 {
     QScopedPointer<Entry> entryOrg(new Entry());
@@ -232,6 +347,88 @@ void TestEntry::testResolveUrlPlaceholders()
     QCOMPARE(entry.resolvePlaceholder("{URL:FRAGMENT}"), fragment);
 }
 
+void TestEntry::testParsedUrl()
+{
+    Entry entry;
+    entry.setUrl("https://user@login.example.co.uk:8080/path?q=1#fragment");
+
+    auto url = entry.attributes()->parsedUrl(EntryAttributes::URLKey);
+    QVERIFY(url.hasScheme());
+    QVERIFY(url.isValid());
+    QCOMPARE(url.scheme(), QString("https"));
+    QCOMPARE(url.host(), QString("login.example.co.uk"));
+    QCOMPARE(url.domain(), QString("example.co.uk"));
+    QCOMPARE(url.port(), 8080);
+    QCOMPARE(url.path(), QString("/path"));
+    QCOMPARE(url.normalized(), QUrl("https://login.example.co.uk:8080/path?q=1"));
+
+    // URLs without a scheme are parsed as user input
+    entry.setUrl("example.com");
+    url = entry.attributes()->parsedUrl(EntryAttributes::URLKey);
+    QVERIFY(!url.hasScheme());
+    QCOMPARE(url.host(), QString("example.com"));
+    QCOMPARE(url.domain(), QString("example.com"));
+    QCOMPARE(url.port(), -1);
+    QCOMPARE(url.normalized(), QUrl("https://example.com/"));
+
+    entry.setUrl("");
+    url = entry.attributes()->parsedUrl(EntryAttributes::URLKey);
+    QVERIFY(url.text().isEmpty());
+    QVERIFY(url.host().isEmpty());
+
+    // Additional URLs follow their attribute
+    entry.attributes()->set("KP2A_URL", "https://keepassxc.org");
+    QCOMPARE(entry.attributes()->parsedUrl("KP2A_URL").host(), QString("keepassxc.org"));
+    entry.attributes()->rename("KP2A_URL", "KP2A_URL_1");
+    QVERIFY(entry.attributes()->parsedUrl("KP2A_URL").text().isEmpty());
+    QCOMPARE(entry.attributes()->parsedUrl("KP2A_URL_1").host(), QString("keepassxc.org"));
+
+    Entry other;
+    other.attributes()->copyDataFrom(entry.attributes());
+    entry.attributes()->copyDataFrom(other.attributes());
+    QCOMPARE(other.attributes()->parsedUrl("KP2A_URL_1").host(), QString("keepassxc.org"));
+    entry.attributes()->clear();
+    QVERIFY(entry.attributes()->parsedUrl("KP2A_URL_1").text().isEmpty());
+
+    // Invalid URLs are flagged
+    entry.setUrl("https://example.com/{}<>");
+    url = entry.attributes()->parsedUrl(EntryAttributes::URLKey);
+    QVERIFY(!url.isValid());
+    QVERIFY(url.hasIllegalCharacters());
+}
+
+void TestEntry::testInternedAttributes()
+{
+    Database db;
+    auto entry1 = new Entry();
+    entry1->setGroup(db.rootGroup());
+    auto entry2 = new Entry();
+    entry2->setGroup(db.rootGroup());
+
+    // Equal keys of entries in the same database share their data
+    entry1->attributes()->set(QString("otp"), QString("otpauth://totp/user"));
+    entry2->attributes()->set(QString("otp"), QString("otpauth://totp/user"));
+    const QStringList keys1 = entry1->attributes()->keys();
+    const QStringList keys2 = entry2->attributes()->keys();
+    QCOMPARE(keys1, keys2);
+    QCOMPARE(keys1.at(keys1.indexOf("otp")).constData(), keys2.at(keys2.indexOf("otp")).constData());
+    QCOMPARE(db.stringInterner()->sharedBytes(), qint64(2 * 3));
+
+    // Values are never kept by the database, protected or not, only the new key is
+    QVERIFY(entry1->attributes()->value("otp").constData() != entry2->attributes()->value("otp").constData());
+    const int size = db.stringInterner()->size();
+    entry1->attributes()->set(EntryAttributes::PasswordKey, QString("secret"), true);
+    entry2->attributes()->set(EntryAttributes::PasswordKey, QString("secret"), true);
+    entry1->attributes()->set(QString("otp"), QString("otpauth://totp/other"));
+    QCOMPARE(db.stringInterner()->size(), size + 1);
+    QVERIFY(entry1->password().constData() != entry2->password().constData());
+
+    // A disabled interner leaves keys alone
+    db.stringInterner()->setEnabled(false);
+    entry1->attributes()->set(QString("note"), QString("a"));
+    QCOMPARE(db.stringInterner()->size(), size + 1);
+}
+
 void TestEntry::testResolveRecursivePlaceholders()
 {
     Database db;
@@ -511,6 +708,57 @@ void TestEntry::testResolveNonIdPlaceholdersToUuid()
     }
 }
 
+void TestEntry::testResolvePlaceholderCache()
+{
+    Database db;
+    auto* root = db.rootGroup();
+
+    auto* source = new Entry();
+    source->setGroup(root);
+    source->setUuid(QUuid::createUuid());
+    source->setTitle("Source");
+    source->setPassword("first");
+
+    auto* byUuid = new Entry();
+    byUuid->setGroup(root);
+    byUuid->setUuid(QUuid::createUuid());
+    byUuid->setPassword(QString("{REF:P@I:%1}").arg(source->uuidToHex()));
+
+    auto* byTitle = new Entry();
+    byTitle->setGroup(root);
+    byTitle->setUuid(QUuid::createUuid());
+    byTitle->setPassword("{REF:P@T:Source}");
+
+    QCOMPARE(byUuid->resolvePlaceholder(byUuid->password()), QString("first"));
+    QCOMPARE(byTitle->resolvePlaceholder(byTitle->password()), QString("first"));
+
+    // Modifying the referenced entry invalidates the cached values
+    source->setPassword("second");
+    QCOMPARE(byUuid->resolvePlaceholder(byUuid->password()), QString("second"));
+    QCOMPARE(byTitle->resolvePlaceholder(byTitle->password()), QString("second"));
+
+    // Searches by title are affected by changes to any entry
+    source->setTitle("Renamed");
+    QCOMPARE(byTitle->resolvePlaceholder(byTitle->password()), QString());
+    auto* other = new Entry();
+    other->setUuid(QUuid::createUuid());
+    other->setTitle("Source");
+    other->setPassword("third");
+    other->setGroup(root);
+    QCOMPARE(byTitle->resolvePlaceholder(byTitle->password()), QString("third"));
+
+    // Removing the referenced entry invalidates the cached values
+    delete source;
+    QCOMPARE(byUuid->resolvePlaceholder(byUuid->password()), QString());
+
+    // Modifying the entry itself invalidates its own values
+    byUuid->setPassword("{TITLE}");
+    byUuid->setTitle("Title");
+    QCOMPARE(byUuid->resolvePlaceholder(byUuid->password()), QString("Title"));
+    byUuid->setTitle("Changed");
+    QCOMPARE(byUuid->resolvePlaceholder(byUuid->password()), QString("Changed"));
+}
+
 void TestEntry::testResolveClonedEntry()
 {
     Database db;
@@ -29,13 +29,18 @@ class TestEntry : public QObject
 private slots:
     void initTestCase();
     void testHistoryItemDeletion();
+    void testCompactHistory();
     void testCopyDataFrom();
+    void testAttachmentStore();
     void testClone();
     void testResolveUrl();
     void testResolveUrlPlaceholders();
+    void testParsedUrl();
+    void testInternedAttributes();
     void testResolveRecursivePlaceholders();
     void testResolveReferencePlaceholders();
     void testResolveNonIdPlaceholdersToUuid();
+    void testResolvePlaceholderCache();
     void testResolveClonedEntry();
     void testIsRecycled();
     void testMove();
@@ -16,6 +16,7 @@
  */
 
 #include "TestEntrySearcher.h"
+#include "core/EntrySearchIndex.h"
 #include "core/Group.h"
 
 #include <QTest>
@@ -372,3 +373,93 @@ void TestEntrySearcher::testSkipProtected()
         m_entrySearcher.search("_testAttribute:testE1 _testProtected:apple _testAttribute:testE2", m_rootGroup);
     QCOMPARE(m_searchResult, {});
 }
+
+void TestEntrySearcher::testSearchIndex()
+{
+    Entry* entry1 = new Entry();
+    entry1->setUuid(QUuid::createUuid());
+    entry1->setTitle("Banking");
+    entry1->setUsername("alice");
+    entry1->setUrl("https://bank.example.com");
+    entry1->setGroup(m_rootGroup);
+
+    Entry* entry2 = new Entry();
+    entry2->setUuid(QUuid::createUuid());
+    entry2->setTitle("Mail");
+    entry2->setNotes("Recovery codes are in the safe");
+    entry2->setGroup(m_rootGroup);
+
+    EntrySearchIndex index;
+    index.build(m_rootGroup);
+    m_entrySearcher.setSearchIndex(&index);
+
+    m_searchResult = m_entrySearcher.search("bank", m_rootGroup);
+    QCOMPARE(m_searchResult, QList<Entry*>() << entry1);
+
+    m_searchResult = m_entrySearcher.search("SAFE codes", m_rootGroup);
+    QCOMPARE(m_searchResult, QList<Entry*>() << entry2);
+
+    m_searchResult = m_entrySearcher.search("ba*ing", m_rootGroup);
+    QCOMPARE(m_searchResult, QList<Entry*>() << entry1);
+
+    m_searchResult = m_entrySearcher.search("-bank", m_rootGroup);
+    QCOMPARE(m_searchResult, QList<Entry*>() << entry2);
+
+    // Modified entries are picked up again
+    entry2->setTitle("Bank statements");
+    m_searchResult = m_entrySearcher.search("bank", m_rootGroup);
+    QCOMPARE(m_searchResult, QList<Entry*>() << entry1 << entry2);
+
+    // New entries are found before they are indexed
+    Entry* entry3 = new Entry();
+    entry3->setUuid(QUuid::createUuid());
+    entry3->setTitle("Online banking");
+    entry3->setGroup(m_rootGroup);
+    m_searchResult = m_entrySearcher.search("banking", m_rootGroup);
+    QCOMPARE(m_searchResult, QList<Entry*>() << entry1 << entry3);
+    QVERIFY(index.isIndexed(entry3));
+
+    // Placeholders can resolve to anything and are never filtered out
+    Entry* entry4 = new Entry();
+    entry4->setUuid(QUuid::createUuid());
+    entry4->setTitle("{TITLE}");
+    entry4->setUsername("{USERNAME}");
+    entry4->setGroup(m_rootGroup);
+    m_searchResult = m_entrySearcher.search("title", m_rootGroup);
+    QCOMPARE(m_searchResult, QList<Entry*>() << entry4);
+
+    // Deleted entries are dropped from the index
+    delete entry1;
+    m_searchResult = m_entrySearcher.search("banking", m_rootGroup);
+    QCOMPARE(m_searchResult, QList<Entry*>() << entry3);
+
+    m_entrySearcher.setSearchIndex(nullptr);
+}
+
+void TestEntrySearcher::testParallelSearch()
+{
+    Group* group1 = new Group();
+    group1->setParent(m_rootGroup);
+    Group* group2 = new Group();
+    group2->setParent(m_rootGroup);
+
+    for (int i = 0; i < 500; ++i) {
+        Entry* entry = new Entry();
+        entry->setUuid(QUuid::createUuid());
+        entry->setTitle(QString("entry %1").arg(i));
+        entry->setNotes(i % 3 == 0 ? "fizz" : "buzz");
+        entry->setGroup(i % 2 == 0 ? group1 : group2);
+    }
+
+    m_entrySearcher.setParallelThreshold(-1);
+    auto serialResult = m_entrySearcher.search("fizz", m_rootGroup);
+    QCOMPARE(serialResult.size(), 167);
+
+    // Parallel evaluation returns the same entries in tree order
+    m_entrySearcher.setParallelThreshold(0);
+    m_searchResult = m_entrySearcher.search("fizz", m_rootGroup);
+    QCOMPARE(m_searchResult, serialResult);
+
+    m_searchResult = m_entrySearcher.searchEntries("buzz", m_rootGroup->entriesRecursive());
+    QCOMPARE(m_searchResult.size(), 333);
+}
@@ -38,6 +38,8 @@ private slots:
     void testCustomAttributesAreSearched();
     void testGroup();
     void testSkipProtected();
+    void testSearchIndex();
+    void testParallelSearch();
 
 private:
     Group* m_rootGroup;
@@ -555,6 +555,63 @@ void TestGroup::testFindEntry()
     QVERIFY(!entry);
 }
 
+void TestGroup::testFindByUuidIndex()
+{
+    QScopedPointer<Database> db(new Database());
+    QScopedPointer<Database> db2(new Database());
+
+    auto group1 = new Group();
+    group1->setUuid(QUuid::createUuid());
+    group1->setParent(db->rootGroup());
+
+    auto group2 = new Group();
+    group2->setUuid(QUuid::createUuid());
+    group2->setParent(group1);
+
+    auto entry = new Entry();
+    entry->setUuid(QUuid::createUuid());
+    entry->setGroup(group2);
+
+    QCOMPARE(db->entryByUuid(entry->uuid()), entry);
+    QCOMPARE(db->groupByUuid(group2->uuid()), group2);
+    QCOMPARE(group1->findEntryByUuid(entry->uuid()), entry);
+    QVERIFY(!group1->findEntryByUuid(entry->uuid(), false));
+    QCOMPARE(group2->findEntryByUuid(entry->uuid(), false), entry);
+    QCOMPARE(group1->findGroupByUuid(group2->uuid()), group2);
+    QVERIFY(!group2->findGroupByUuid(group1->uuid()));
+
+    // Changing the uuid updates the index
+    QUuid oldUuid = entry->uuid();
+    entry->setUuid(QUuid::createUuid());
+    QVERIFY(!db->entryByUuid(oldUuid));
+    QCOMPARE(db->entryByUuid(entry->uuid()), entry);
+
+    oldUuid = group2->uuid();
+    group2->setUuid(QUuid::createUuid());
+    QVERIFY(!db->groupByUuid(oldUuid));
+    QCOMPARE(db->groupByUuid(group2->uuid()), group2);
+
+    // Moving a subtree to another database moves its index entries
+    group1->setParent(db2->rootGroup());
+    QVERIFY(!db->entryByUuid(entry->uuid()));
+    QVERIFY(!db->groupByUuid(group2->uuid()));
+    QCOMPARE(db2->entryByUuid(entry->uuid()), entry);
+    QCOMPARE(db2->groupByUuid(group2->uuid()), group2);
+
+    // Moving an entry within the database keeps it indexed
+    entry->setGroup(db2->rootGroup());
+    QCOMPARE(db2->entryByUuid(entry->uuid()), entry);
+    QVERIFY(!group2->findEntryByUuid(entry->uuid()));
+
+    // Deleted objects are removed from the index
+    const QUuid entryUuid = entry->uuid();
+    const QUuid groupUuid = group2->uuid();
+    delete entry;
+    delete group2;
+    QVERIFY(!db2->entryByUuid(entryUuid));
+    QVERIFY(!db2->groupByUuid(groupUuid));
+}
+
 void TestGroup::testFindGroupByPath()
 {
     QScopedPointer<Database> db(new Database());
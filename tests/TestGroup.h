@@ -37,6 +37,7 @@ private slots:
     void testClone();
     void testCopyCustomIcons();
     void testFindEntry();
+    void testFindByUuidIndex();
     void testFindGroupByPath();
     void testPrint();
     void testAddEntryWithPath();
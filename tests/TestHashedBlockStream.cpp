@@ -22,6 +22,7 @@
 #include "FailDevice.h"
 #include "crypto/Crypto.h"
 #include "streams/HashedBlockStream.h"
+#include "streams/PipelineStream.h"
 
 QTEST_GUILESS_MAIN(TestHashedBlockStream)
 
@@ -101,3 +102,55 @@ void TestHashedBlockStream::testWriteFailure()
     QVERIFY(!writer.reset());
     QCOMPARE(writer.errorString(), QString("FAILDEVICE"));
 }
+
+void TestHashedBlockStream::testPipelineWriteRead()
+{
+    QByteArray data(10000, '\0');
+    for (int i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 7);
+    }
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+
+    {
+        HashedBlockStream writer(&buffer, 100);
+        QVERIFY(writer.open(QIODevice::WriteOnly));
+        PipelineStream pipeline(&writer, 64, 2);
+        QVERIFY(pipeline.open(QIODevice::WriteOnly));
+
+        for (int i = 0; i < data.size(); i += 1000) {
+            QCOMPARE(pipeline.write(data.mid(i, 1000)), qint64(1000));
+        }
+        QVERIFY(pipeline.reset());
+        QVERIFY(writer.reset());
+    }
+
+    buffer.reset();
+    HashedBlockStream reader(&buffer);
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+    PipelineStream pipeline(&reader, 64, 2);
+    QVERIFY(pipeline.open(QIODevice::ReadOnly));
+
+    QCOMPARE(pipeline.read(10), data.left(10));
+    QCOMPARE(pipeline.readAll(), data.mid(10));
+    QVERIFY(pipeline.atEnd());
+}
+
+void TestHashedBlockStream::testPipelineWriteFailure()
+{
+    FailDevice failDevice(1500);
+    QVERIFY(failDevice.open(QIODevice::WriteOnly));
+
+    QByteArray input(2000, 'Z');
+
+    HashedBlockStream writer(&failDevice, 500);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+    PipelineStream pipeline(&writer, 64, 2);
+    QVERIFY(pipeline.open(QIODevice::WriteOnly));
+
+    // Depending on the worker the failure shows up while writing or when flushing
+    bool ok = pipeline.write(input) == input.size() && pipeline.reset();
+    QVERIFY(!ok);
+    QCOMPARE(pipeline.errorString(), QString("FAILDEVICE"));
+}
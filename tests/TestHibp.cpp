@@ -20,9 +20,11 @@
 #include "core/Group.h"
 #include "core/HibpOffline.h"
 #include "crypto/Crypto.h"
+#include "util/TemporaryFile.h"
 
 #include <QBuffer>
 #include <QByteArray>
+#include <QElapsedTimer>
 #include <QList>
 #include <QTest>
 
@@ -118,3 +120,134 @@ void TestHibp::testPwned()
     QCOMPARE(findings[1].first, entry4);
     QCOMPARE(findings[1].second, 456);
 }
+
+void TestHibp::testIndex()
+{
+    // Not ordered by hash, the index has to be sorted
+    QByteArray hibpContents(TEST_HIBP_CONTENTS);
+    hibpContents.append("00000000A8DAE4228F821FB418F59826079BF368:2\n");
+    QBuffer hibpBuffer(&hibpContents);
+    QVERIFY(hibpBuffer.open(QIODevice::ReadOnly));
+    QVERIFY(!HibpOffline::isIndex(hibpBuffer));
+
+    TemporaryFile indexFile;
+    QVERIFY(indexFile.open());
+    QString error;
+    QVERIFY(HibpOffline::convertToIndex(hibpBuffer, indexFile, &error));
+    QCOMPARE(error, QString());
+    QVERIFY(indexFile.seek(0));
+    QVERIFY(HibpOffline::isIndex(indexFile));
+
+    Group* root = m_db->rootGroup();
+
+    Entry* entry1 = new Entry();
+    entry1->setPassword("foo");
+    entry1->setGroup(root);
+
+    Entry* entry2 = new Entry();
+    entry2->setPassword("xyz");
+    entry2->setGroup(root);
+
+    Entry* entry3 = new Entry();
+    entry3->setPassword("foo");
+    m_db->recycleEntry(entry3);
+
+    Entry* entry4 = new Entry();
+    entry4->setPassword("bar");
+    entry4->setGroup(root);
+
+    QList<QPair<const Entry*, int>> findings;
+    QVERIFY(HibpOffline::indexReport(m_db, indexFile, findings, &error));
+    QCOMPARE(error, QString());
+    QCOMPARE(findings.size(), 2);
+    QCOMPARE(findings[0].first, entry1);
+    QCOMPARE(findings[0].second, 123);
+    QCOMPARE(findings[1].first, entry4);
+    QCOMPARE(findings[1].second, 456);
+
+    // A text file is not accepted as an index
+    TemporaryFile textFile;
+    QVERIFY(textFile.open());
+    QVERIFY(textFile.write(TEST_HIBP_CONTENTS) > 0);
+    QVERIFY(!HibpOffline::indexReport(m_db, textFile, findings, &error));
+    QVERIFY(!error.isEmpty());
+}
+
+void TestHibp::testOrderedByHash()
+{
+    Entry* entry1 = new Entry();
+    entry1->setPassword("foo");
+    entry1->setGroup(m_db->rootGroup());
+
+    // Reading stops after the hash of "foo", so the broken line is never parsed
+    QByteArray hibpContents("0000000000000000000000000000000000000000:1\r\n"
+                            "0BEEC7B5EA3F0FDBC95D0DD47F3C5BC275DA8A33:123\r\n"
+                            "62CDB7020FF920E5AA642C3D4066950DD1F01F4D:456\r\n"
+                            "barf:nope\r\n");
+    QBuffer hibpBuffer(&hibpContents);
+    QVERIFY(hibpBuffer.open(QIODevice::ReadOnly));
+
+    QList<QPair<const Entry*, int>> findings;
+    QString error;
+    QVERIFY(HibpOffline::report(m_db, hibpBuffer, findings, &error, true));
+    QCOMPARE(error, QString());
+    QCOMPARE(findings.size(), 1);
+    QCOMPARE(findings[0].first, entry1);
+    QCOMPARE(findings[0].second, 123);
+
+    // Without the order the whole file is read, from a memory mapped file as well
+    TemporaryFile hibpFile;
+    QVERIFY(hibpFile.open());
+    QCOMPARE(hibpFile.write(hibpContents), qint64(hibpContents.size()));
+    QVERIFY(hibpFile.seek(0));
+    findings.clear();
+    QVERIFY(!HibpOffline::report(m_db, hibpFile, findings, &error));
+    QCOMPARE(error, QString("HIBP file, line 4: parse error"));
+}
+
+void TestHibp::benchmarkScan()
+{
+    QByteArray env = qgetenv("BENCHMARK");
+
+    if (env.isEmpty() || env == "0" || env == "no") {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    // Synthetic dump of 1 GiB with lines like the HIBP ones, ordered by hash
+    const qint64 size = 1024 * 1024 * 1024;
+    TemporaryFile hibpFile;
+    QVERIFY(hibpFile.open());
+    QByteArray chunk;
+    quint64 hash = 0;
+    while (hibpFile.size() < size) {
+        chunk.clear();
+        for (int i = 0; i < 16 * 1024; ++i) {
+            hash += Q_UINT64_C(0x000000B5EA3F0FDB);
+            chunk.append(QByteArray::number(hash, 16).rightJustified(16, '0').toUpper());
+            chunk.append("C95D0DD47F3C5BC275DA8A33:");
+            chunk.append(QByteArray::number(i % 1000 + 1));
+            chunk.append("\r\n");
+        }
+        QCOMPARE(hibpFile.write(chunk), qint64(chunk.size()));
+    }
+    QVERIFY(hibpFile.flush());
+
+    // The entries are not in the file, so all of it is parsed
+    Entry* entry = new Entry();
+    entry->setPassword("foo");
+    entry->setGroup(m_db->rootGroup());
+
+    QVERIFY(hibpFile.seek(0));
+    QList<QPair<const Entry*, int>> findings;
+    QString error;
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(HibpOffline::report(m_db, hibpFile, findings, &error));
+    const auto elapsed = timer.nsecsElapsed();
+    QCOMPARE(findings.size(), 0);
+
+    qInfo("Scanned %lld MiB in %lld ms: %.2f GB/s",
+          hibpFile.size() / (1024 * 1024),
+          elapsed / 1000000,
+          double(hibpFile.size()) / double(elapsed));
+}
@@ -34,6 +34,9 @@ private slots:
     void testEmpty();
     void testIoError();
     void testPwned();
+    void testIndex();
+    void testOrderedByHash();
+    void benchmarkScan();
 
 private:
     QSharedPointer<Database> m_db;
@@ -27,6 +27,7 @@
 #include "keys/FileKey.h"
 #include "keys/PasswordKey.h"
 #include "mock/MockChallengeResponseKey.h"
+#include <QTemporaryFile>
 #include <QTest>
 
 int main(int argc, char* argv[])
@@ -444,6 +445,74 @@ void TestKdbx4Argon2::testCustomData()
     QCOMPARE(newEntry->customData()->value(customDataKey2), customData2);
 }
 
+/**
+ * @return peak resident set size of this process in KiB, -1 if unknown
+ */
+static qint64 peakResidentSize()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> lines = status.readAll().split('\n');
+    for (const QByteArray& line : lines) {
+        if (line.startsWith("VmHWM:")) {
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    return -1;
+}
+
+void TestKdbx4Argon2::testAttachmentPeakMemory()
+{
+    QByteArray env = qgetenv("BENCHMARK");
+
+    if (env.isEmpty() || env == "0" || env == "no") {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    // 500 attachments of 1 MiB, all with distinct content
+    const int attachmentCount = 500;
+    const int attachmentSize = 1024 * 1024;
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    {
+        Database db;
+        db.changeKdf(fastKdf(KeePass2::uuidToKdf(KeePass2::KDF_AES_KDBX4)));
+        auto* entry = new Entry();
+        entry->setUuid(QUuid::createUuid());
+        entry->setGroup(db.rootGroup());
+        for (int i = 0; i < attachmentCount; ++i) {
+            QByteArray data(attachmentSize, static_cast<char>(i));
+            data.replace(0, sizeof(i), reinterpret_cast<const char*>(&i), sizeof(i));
+            entry->attachments()->set(QString::number(i), data);
+        }
+
+        KeePass2Writer writer;
+        QVERIFY2(writer.writeDatabase(&file, &db), qPrintable(writer.errorString()));
+    }
+
+    // Reset the peak resident size so only reading the database is measured
+    QFile clearRefs("/proc/self/clear_refs");
+    if (peakResidentSize() < 0 || !clearRefs.open(QIODevice::WriteOnly) || clearRefs.write("5") != 1) {
+        QSKIP("Peak resident size is not available on this platform.");
+    }
+    clearRefs.close();
+    const qint64 baseline = peakResidentSize();
+
+    QVERIFY(file.seek(0));
+    KeePass2Reader reader;
+    auto db = QSharedPointer<Database>::create();
+    QVERIFY(reader.readDatabase(&file, QSharedPointer<CompositeKey>::create(), db.data()));
+    QCOMPARE(db->rootGroup()->entries().first()->attachments()->keys().size(), attachmentCount);
+
+    qInfo("Peak resident size while reading %d MiB of attachments: %lld KiB above %lld KiB baseline",
+          attachmentCount * attachmentSize / (1024 * 1024),
+          peakResidentSize() - baseline,
+          baseline);
+}
+
 void TestKdbx4AesKdf::initTestCaseImpl()
 {
     m_xmlDb->changeKdf(fastKdf(KeePass2::uuidToKdf(KeePass2::KDF_AES_KDBX4)));
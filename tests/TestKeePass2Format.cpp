@@ -27,6 +27,7 @@
 
 #include "FailDevice.h"
 #include "config-keepassx-tests.h"
+#include <QThread>
 #include <QtTest>
 
 void TestKeePass2Format::initTestCase()
@@ -802,6 +803,211 @@ void TestKeePass2Format::testDuplicateAttachments()
     QCOMPARE(db->rootGroup()->entries()[2]->attachments()->value("c3"), attachment3);
 }
 
+void TestKeePass2Format::testManyAttachments()
+{
+    auto db = QSharedPointer<Database>::create();
+    db->setKey(QSharedPointer<CompositeKey>::create());
+
+    // More attachments than threads, so KDBX 3.1 compresses them in several batches
+    const int count = 4 * QThread::idealThreadCount() + 1;
+    for (int i = 0; i < count; ++i) {
+        auto entry = new Entry();
+        entry->setGroup(db->rootGroup());
+        entry->setUuid(QUuid::createUuid());
+        entry->attachments()->set("attachment", QByteArray(i * 100, static_cast<char>(i)));
+    }
+
+    QBuffer buffer;
+    buffer.open(QBuffer::ReadWrite);
+
+    bool hasError = false;
+    QString errorString;
+    writeKdbx(&buffer, db.data(), hasError, errorString);
+    QVERIFY2(!hasError, qPrintable(errorString));
+
+    buffer.seek(0);
+    auto newDb = QSharedPointer<Database>::create();
+    readKdbx(&buffer, QSharedPointer<CompositeKey>::create(), newDb, hasError, errorString);
+    QVERIFY2(!hasError, qPrintable(errorString));
+
+    QCOMPARE(newDb->rootGroup()->entries().size(), count);
+    for (int i = 0; i < count; ++i) {
+        QCOMPARE(newDb->rootGroup()->entries().at(i)->attachments()->value("attachment"),
+                 QByteArray(i * 100, static_cast<char>(i)));
+    }
+}
+
+void TestKeePass2Format::testIncrementalSave()
+{
+    auto key = QSharedPointer<CompositeKey>::create();
+    key->addKey(QSharedPointer<PasswordKey>::create("test"));
+    auto db = QSharedPointer<Database>::create();
+    db->changeKdf(fastKdf(KeePass2::uuidToKdf(m_kdbxSourceDb->kdf()->uuid())));
+    db->setKey(key);
+
+    auto group = new Group();
+    group->setUuid(QUuid::createUuid());
+    group->setParent(db->rootGroup());
+
+    QList<Entry*> entries;
+    for (int i = 0; i < 3; ++i) {
+        auto entry = new Entry();
+        entry->setUuid(QUuid::createUuid());
+        entry->setGroup(db->rootGroup());
+        entry->setTitle(QString("Entry %1").arg(i));
+        entry->setPassword(QString("Password %1").arg(i));
+        entry->attachments()->set("attachment", QByteArray::number(i));
+        entries.append(entry);
+    }
+    entries[1]->beginUpdate();
+    entries[1]->setPassword("Changed");
+    entries[1]->endUpdate();
+
+    bool hasError = false;
+    QString errorString;
+    auto saveAndReload = [&]() -> QSharedPointer<Database> {
+        QBuffer buffer;
+        buffer.open(QBuffer::ReadWrite);
+        writeKdbx(&buffer, db.data(), hasError, errorString);
+        if (hasError) {
+            return {};
+        }
+        buffer.seek(0);
+        auto newDb = QSharedPointer<Database>::create();
+        readKdbx(&buffer, key, newDb, hasError, errorString);
+        return newDb;
+    };
+
+    // The second save reuses all entries of the first one
+    auto newDb = saveAndReload();
+    QVERIFY2(!hasError, qPrintable(errorString));
+    newDb = saveAndReload();
+    QVERIFY2(!hasError, qPrintable(errorString));
+    QCOMPARE(newDb->rootGroup()->entries().size(), 3);
+    for (int i = 0; i < 3; ++i) {
+        const Entry* entry = newDb->rootGroup()->entries().at(i);
+        QCOMPARE(entry->title(), QString("Entry %1").arg(i));
+        QCOMPARE(entry->attachments()->value("attachment"), QByteArray::number(i));
+    }
+    QCOMPARE(newDb->rootGroup()->entries().at(0)->password(), QString("Password 0"));
+    QCOMPARE(newDb->rootGroup()->entries().at(1)->password(), QString("Changed"));
+    QCOMPARE(newDb->rootGroup()->entries().at(1)->historyItems().at(0)->password(), QString("Password 1"));
+
+    // Change one entry, move another one deeper into the tree and renumber the attachments of the third one
+    entries[0]->setPassword("New password");
+    entries[1]->setGroup(group);
+    entries[0]->attachments()->set("attachment", QByteArray("new"));
+    newDb = saveAndReload();
+    QVERIFY2(!hasError, qPrintable(errorString));
+    QCOMPARE(newDb->rootGroup()->entries().size(), 2);
+    QCOMPARE(newDb->rootGroup()->entries().at(0)->password(), QString("New password"));
+    QCOMPARE(newDb->rootGroup()->entries().at(0)->attachments()->value("attachment"), QByteArray("new"));
+    QCOMPARE(newDb->rootGroup()->entries().at(1)->password(), QString("Password 2"));
+    QCOMPARE(newDb->rootGroup()->entries().at(1)->attachments()->value("attachment"), QByteArray("2"));
+    const Entry* movedEntry = newDb->rootGroup()->children().at(0)->entries().at(0);
+    QCOMPARE(movedEntry->password(), QString("Changed"));
+    QCOMPARE(movedEntry->attachments()->value("attachment"), QByteArray("1"));
+    QCOMPARE(movedEntry->historyItems().at(0)->password(), QString("Password 1"));
+
+    // Changing the memory protection settings serializes all entries again
+    db->metadata()->setProtectTitle(true);
+    newDb = saveAndReload();
+    QVERIFY2(!hasError, qPrintable(errorString));
+    QCOMPARE(newDb->rootGroup()->entries().at(0)->title(), QString("Entry 0"));
+    QVERIFY(newDb->rootGroup()->entries().at(0)->attributes()->isProtected(EntryAttributes::TitleKey));
+}
+
+void TestKeePass2Format::testKdbxCustomIconData()
+{
+    QImage image(16, 16, QImage::Format_RGB32);
+    image.fill(qRgb(1, 2, 3));
+    // Uncompressed PNG, which differs from the encoding used for added images
+    QByteArray iconData;
+    QBuffer iconBuffer(&iconData);
+    iconBuffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&iconBuffer, "PNG", 100));
+    iconBuffer.close();
+
+    auto key = QSharedPointer<CompositeKey>::create();
+    key->addKey(QSharedPointer<PasswordKey>::create("test"));
+    auto db = QSharedPointer<Database>::create();
+    db->changeKdf(fastKdf(KeePass2::uuidToKdf(m_kdbxSourceDb->kdf()->uuid())));
+    db->setKey(key);
+    const QUuid iconUuid = QUuid::createUuid();
+    db->metadata()->addCustomIcon(iconUuid, iconData);
+    QCOMPARE(db->metadata()->findCustomIcon(iconData), iconUuid);
+
+    QBuffer buffer;
+    buffer.open(QBuffer::ReadWrite);
+    bool hasError = false;
+    QString errorString;
+    writeKdbx(&buffer, db.data(), hasError, errorString);
+    QVERIFY2(!hasError, qPrintable(errorString));
+    buffer.seek(0);
+    auto newDb = QSharedPointer<Database>::create();
+    readKdbx(&buffer, key, newDb, hasError, errorString);
+    QVERIFY2(!hasError, qPrintable(errorString));
+
+    // The icon is saved as it was added and decoded on demand
+    QCOMPARE(newDb->metadata()->customIconData(iconUuid), iconData);
+    QCOMPARE(newDb->metadata()->customIcon(iconUuid).pixel(0, 0), qRgb(1, 2, 3));
+    QCOMPARE(newDb->metadata()->findCustomIcon(iconData), iconUuid);
+}
+
+void TestKeePass2Format::testKdbxCompactHistory()
+{
+    auto db = QSharedPointer<Database>::create();
+    db->setKey(QSharedPointer<CompositeKey>::create());
+
+    auto entry = new Entry();
+    entry->setGroup(db->rootGroup());
+    entry->setUuid(QUuid::createUuid());
+    entry->setPassword("Password 0");
+    entry->setTags("history");
+    entry->customData()->set("key", "value");
+    AutoTypeAssociations::Association assoc;
+    assoc.window = "window";
+    assoc.sequence = "{USERNAME}";
+    entry->autoTypeAssociations()->add(assoc);
+    entry->attachments()->set("attachment", QByteArray("history"));
+    for (int i = 1; i < 3; ++i) {
+        entry->beginUpdate();
+        entry->setPassword(QString("Password %1").arg(i));
+        entry->endUpdate();
+    }
+    entry->attachments()->set("attachment", QByteArray("current"));
+
+    QBuffer buffer;
+    buffer.open(QBuffer::ReadWrite);
+    bool hasError = false;
+    QString errorString;
+    writeKdbx(&buffer, db.data(), hasError, errorString);
+    QVERIFY2(!hasError, qPrintable(errorString));
+    buffer.seek(0);
+    auto newDb = QSharedPointer<Database>::create();
+    readKdbx(&buffer, QSharedPointer<CompositeKey>::create(), newDb, hasError, errorString);
+    QVERIFY2(!hasError, qPrintable(errorString));
+
+    // The history is not expanded while the database is read
+    Entry* newEntry = newDb->rootGroup()->entries().at(0);
+    QVERIFY(newEntry->hasCompactHistory());
+    QCOMPARE(newEntry->attachments()->value("attachment"), QByteArray("current"));
+
+    const QList<Entry*> historyItems = newEntry->historyItems();
+    QVERIFY(!newEntry->hasCompactHistory());
+    QCOMPARE(historyItems.size(), 2);
+    for (int i = 0; i < 2; ++i) {
+        QCOMPARE(historyItems.at(i)->uuid(), newEntry->uuid());
+        QCOMPARE(historyItems.at(i)->password(), QString("Password %1").arg(i));
+        QCOMPARE(historyItems.at(i)->attachments()->value("attachment"), QByteArray("history"));
+        QVERIFY(historyItems.at(i)->attributes()->isProtected(EntryAttributes::PasswordKey));
+        QCOMPARE(historyItems.at(i)->tags(), QString("history"));
+        QCOMPARE(historyItems.at(i)->customData()->value("key"), QString("value"));
+        QCOMPARE(historyItems.at(i)->autoTypeAssociations()->size(), 1);
+        QCOMPARE(historyItems.at(i)->autoTypeAssociations()->get(0).window, QString("window"));
+    }
+}
+
 /**
  * @return fast "dummy" KDF
  */
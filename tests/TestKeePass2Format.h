@@ -62,6 +62,10 @@ private slots:
     void testKdbxKeyChange();
     void testKdbxKeyChange_data();
     void testDuplicateAttachments();
+    void testManyAttachments();
+    void testIncrementalSave();
+    void testKdbxCustomIconData();
+    void testKdbxCompactHistory();
 
 protected:
     virtual void initTestCaseImpl() = 0;
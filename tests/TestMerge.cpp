@@ -174,6 +174,33 @@ void TestMerge::testResolveConflictNewer()
     }
 }
 
+void TestMerge::testMergeCompactSourceHistory()
+{
+    QScopedPointer<Database> dbDestination(createTestDatabase());
+    QScopedPointer<Database> dbSource(
+        createTestDatabaseStructureClone(dbDestination.data(), Entry::CloneNoFlags, Group::CloneIncludeEntries));
+
+    Entry* entrySource = dbSource->rootGroup()->findEntryByPath("entry1");
+    QVERIFY(entrySource);
+    m_clock->advanceSecond(1);
+    entrySource->beginUpdate();
+    entrySource->setPassword("password");
+    entrySource->endUpdate();
+    entrySource->compactHistory();
+    QVERIFY(entrySource->hasCompactHistory());
+
+    m_clock->advanceSecond(1);
+    Merger merger(dbSource.data(), dbDestination.data());
+    merger.merge();
+
+    // Reading the source does not expand its history
+    QVERIFY(entrySource->hasCompactHistory());
+    Entry* entryDestination = dbDestination->rootGroup()->findEntryByPath("entry1");
+    QVERIFY(entryDestination);
+    QCOMPARE(entryDestination->password(), QString("password"));
+    QCOMPARE(entryDestination->historyItems().size(), 1);
+}
+
 /**
  * If the entry is updated in the source database, and the
  * destination database after, the entry should remain the
@@ -1504,6 +1531,250 @@ void TestMerge::testMergeModified()
     QTRY_VERIFY(!modifiedSignalSpy.empty());
 }
 
+/**
+ * Deleting a group in the source removes its subgroups and their entries,
+ * except for the parents of entries that changed after the deletion.
+ */
+void TestMerge::testDeletedNestedGroups()
+{
+    QScopedPointer<Database> dbDestination(new Database());
+    auto* group1 = new Group();
+    group1->setUuid(QUuid::createUuid());
+    group1->setParent(dbDestination->rootGroup());
+    auto* group2 = new Group();
+    group2->setUuid(QUuid::createUuid());
+    group2->setParent(group1);
+    auto* group3 = new Group();
+    group3->setUuid(QUuid::createUuid());
+    group3->setParent(group2);
+    auto* entry = new Entry();
+    entry->setUuid(QUuid::createUuid());
+    entry->setGroup(group3);
+    auto* group4 = new Group();
+    group4->setUuid(QUuid::createUuid());
+    group4->setParent(group1);
+
+    const QUuid group1Uuid = group1->uuid();
+    const QUuid group2Uuid = group2->uuid();
+    const QUuid group3Uuid = group3->uuid();
+    const QUuid entryUuid = entry->uuid();
+    const QUuid group4Uuid = group4->uuid();
+
+    QScopedPointer<Database> dbSource(
+        createTestDatabaseStructureClone(dbDestination.data(), Entry::CloneNoFlags, Group::CloneIncludeEntries));
+
+    m_clock->advanceSecond(1);
+
+    delete dbSource->rootGroup()->findGroupByUuid(group1Uuid);
+    QVERIFY(dbSource->containsDeletedObject(group1Uuid));
+    QVERIFY(dbSource->containsDeletedObject(group3Uuid));
+
+    m_clock->advanceSecond(1);
+
+    // An entry changed after the deletion keeps all of its parents
+    QScopedPointer<Database> dbModified(
+        createTestDatabaseStructureClone(dbDestination.data(), Entry::CloneNoFlags, Group::CloneIncludeEntries));
+    Entry* modifiedEntry = dbModified->rootGroup()->findEntryByUuid(entryUuid);
+    modifiedEntry->beginUpdate();
+    modifiedEntry->setTitle("changed");
+    modifiedEntry->endUpdate();
+
+    Merger merger1(dbSource.data(), dbModified.data());
+    merger1.merge();
+
+    QVERIFY(dbModified->rootGroup()->findGroupByUuid(group1Uuid));
+    QVERIFY(dbModified->rootGroup()->findGroupByUuid(group2Uuid));
+    QVERIFY(dbModified->rootGroup()->findGroupByUuid(group3Uuid));
+    QVERIFY(dbModified->rootGroup()->findEntryByUuid(entryUuid));
+    QVERIFY(!dbModified->rootGroup()->findGroupByUuid(group4Uuid));
+    QVERIFY(dbModified->containsDeletedObject(group4Uuid));
+    QVERIFY(!dbModified->containsDeletedObject(group1Uuid));
+
+    // Otherwise the whole tree is removed
+    Merger merger2(dbSource.data(), dbDestination.data());
+    merger2.merge();
+
+    QCOMPARE(dbDestination->rootGroup()->children().size(), 0);
+    QCOMPARE(dbDestination->deletedObjects().size(), 5);
+    QVERIFY(dbDestination->containsDeletedObject(group1Uuid));
+    QVERIFY(dbDestination->containsDeletedObject(group2Uuid));
+    QVERIFY(dbDestination->containsDeletedObject(group3Uuid));
+    QVERIFY(dbDestination->containsDeletedObject(entryUuid));
+    QVERIFY(dbDestination->containsDeletedObject(group4Uuid));
+}
+
+void TestMerge::benchmarkMergeDeletions()
+{
+    QByteArray env = qgetenv("BENCHMARK");
+
+    if (env.isEmpty() || env == "0" || env == "no") {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    // 50000 entries in 500 groups that were all deleted in the source
+    QScopedPointer<Database> dbDestination(new Database());
+    for (int i = 0; i < 500; ++i) {
+        auto* group = new Group();
+        group->setUuid(QUuid::createUuid());
+        group->setName(QString("group%1").arg(i));
+        group->setParent(dbDestination->rootGroup());
+        for (int j = 0; j < 100; ++j) {
+            auto* entry = new Entry();
+            entry->setUuid(QUuid::createUuid());
+            entry->setGroup(group);
+        }
+    }
+
+    QScopedPointer<Database> dbSource(
+        createTestDatabaseStructureClone(dbDestination.data(), Entry::CloneNoFlags, Group::CloneIncludeEntries));
+
+    m_clock->advanceSecond(1);
+
+    const auto sourceGroups = dbSource->rootGroup()->children();
+    qDeleteAll(sourceGroups);
+    QCOMPARE(dbSource->deletedObjects().size(), 50500);
+
+    m_clock->advanceSecond(1);
+
+    Merger merger(dbSource.data(), dbDestination.data());
+    QBENCHMARK_ONCE
+    {
+        merger.merge();
+    }
+
+    QCOMPARE(dbDestination->rootGroup()->children().size(), 0);
+    QCOMPARE(dbDestination->deletedObjects().size(), 50500);
+}
+
+void TestMerge::testPlan()
+{
+    QScopedPointer<Database> dbDestination(createTestDatabase());
+    QScopedPointer<Database> dbSource(
+        createTestDatabaseStructureClone(dbDestination.data(), Entry::CloneNoFlags, Group::CloneIncludeEntries));
+
+    m_clock->advanceSecond(1);
+
+    Entry* sourceEntry1 = dbSource->rootGroup()->findEntryByPath("entry1");
+    QVERIFY(sourceEntry1);
+    sourceEntry1->beginUpdate();
+    sourceEntry1->setTitle("entry1 modified");
+    sourceEntry1->endUpdate();
+
+    auto* newEntry = new Entry();
+    newEntry->setUuid(QUuid::createUuid());
+    newEntry->setTitle("entry3");
+    newEntry->setGroup(dbSource->rootGroup()->findChildByName("group2"));
+
+    Merger merger(dbSource.data(), dbDestination.data());
+    const Merger::Plan plan = merger.plan();
+    QCOMPARE(plan.entries.size(), 3);
+    QCOMPARE(plan.entries.value(sourceEntry1->uuid()), Merger::UpdateEntry);
+    QCOMPARE(plan.entries.value(newEntry->uuid()), Merger::CreateEntry);
+    QCOMPARE(plan.count(Merger::KeepEntry), 1);
+
+    // Planning leaves the target untouched
+    QCOMPARE(dbDestination->rootGroup()->entriesRecursive().size(), 2);
+    QVERIFY(dbDestination->rootGroup()->findEntryByPath("entry1"));
+
+    merger.merge(plan);
+    QCOMPARE(dbDestination->rootGroup()->entriesRecursive().size(), 3);
+    QVERIFY(dbDestination->rootGroup()->findEntryByPath("entry1 modified"));
+    QVERIFY(dbDestination->rootGroup()->findEntryByPath("entry3"));
+
+    // Nothing differs after the merge
+    QCOMPARE(merger.plan().count(Merger::KeepEntry), 3);
+}
+
+/**
+ * Mirroring makes the destination identical to the source and updates
+ * existing entries and groups in place.
+ */
+void TestMerge::testMirror()
+{
+    QScopedPointer<Database> dbDestination(createTestDatabase());
+    QScopedPointer<Database> dbSource(createTestDatabaseStructureClone(
+        dbDestination.data(), Entry::CloneIncludeHistory, Group::CloneIncludeEntries));
+
+    QPointer<Group> groupDestination1 = dbDestination->rootGroup()->findChildByName("group1");
+    QPointer<Group> groupDestination2 = dbDestination->rootGroup()->findChildByName("group2");
+    QPointer<Entry> entryDestination1 = dbDestination->rootGroup()->findEntryByPath("/group1/entry1");
+    QPointer<Entry> entryDestination2 = dbDestination->rootGroup()->findEntryByPath("/group1/entry2");
+    QVERIFY(groupDestination1 && groupDestination2 && entryDestination1 && entryDestination2);
+
+    // Local changes are discarded
+    auto* localEntry = new Entry();
+    localEntry->setUuid(QUuid::createUuid());
+    localEntry->setTitle("local");
+    localEntry->setGroup(groupDestination1);
+    QPointer<Entry> localEntryPointer = localEntry;
+    auto* localGroup = new Group();
+    localGroup->setUuid(QUuid::createUuid());
+    localGroup->setName("local");
+    localGroup->setParent(groupDestination1);
+    QPointer<Group> localGroupPointer = localGroup;
+
+    m_clock->advanceSecond(1);
+
+    Group* groupSource2 = dbSource->rootGroup()->findChildByName("group2");
+    Entry* entrySource1 = dbSource->rootGroup()->findEntryByPath("/group1/entry1");
+    Entry* entrySource2 = dbSource->rootGroup()->findEntryByPath("/group1/entry2");
+    entrySource1->beginUpdate();
+    entrySource1->setTitle("entry1 changed");
+    entrySource1->endUpdate();
+    entrySource2->setGroup(groupSource2);
+
+    auto* groupSource3 = new Group();
+    groupSource3->setUuid(QUuid::createUuid());
+    groupSource3->setName("group3");
+    groupSource3->setParent(groupSource2);
+    auto* entrySource3 = new Entry();
+    entrySource3->setUuid(QUuid::createUuid());
+    entrySource3->setTitle("entry3");
+    entrySource3->setGroup(groupSource3);
+
+    // Moving a group to the front of its parent
+    groupSource2->setParent(dbSource->rootGroup(), 0);
+
+    // An icon that changed under the same uuid
+    const QUuid iconUuid = QUuid::createUuid();
+    dbDestination->metadata()->addCustomIcon(iconUuid, QByteArray("old icon"));
+    dbSource->metadata()->addCustomIcon(iconUuid, QByteArray("new icon"));
+
+    Merger merger(dbSource.data(), dbDestination.data());
+    QVERIFY(!merger.mirror().isEmpty());
+    QCOMPARE(dbDestination->metadata()->customIconData(iconUuid), QByteArray("new icon"));
+
+    // Existing items are updated in place
+    QVERIFY(groupDestination1 && groupDestination2 && entryDestination1 && entryDestination2);
+    QCOMPARE(entryDestination1->title(), QString("entry1 changed"));
+    QCOMPARE(entryDestination1->historyItems().count(), entrySource1->historyItems().count());
+    QCOMPARE(entryDestination2->group(), groupDestination2.data());
+    QCOMPARE(dbDestination->rootGroup()->children().indexOf(groupDestination2), 0);
+
+    QVERIFY(!localEntryPointer);
+    QVERIFY(!localGroupPointer);
+
+    const QList<Entry*> sourceEntries = dbSource->rootGroup()->entriesRecursive();
+    QCOMPARE(dbDestination->rootGroup()->entriesRecursive().size(), sourceEntries.size());
+    for (const Entry* sourceEntry : sourceEntries) {
+        const Entry* destinationEntry = dbDestination->rootGroup()->findEntryByUuid(sourceEntry->uuid());
+        QVERIFY(destinationEntry);
+        QVERIFY(destinationEntry->equals(sourceEntry, CompareItemDefault));
+        QCOMPARE(destinationEntry->group()->uuid(), sourceEntry->group()->uuid());
+    }
+    const QList<Group*> sourceGroups = dbSource->rootGroup()->groupsRecursive(true);
+    QCOMPARE(dbDestination->rootGroup()->groupsRecursive(true).size(), sourceGroups.size());
+    for (const Group* sourceGroup : sourceGroups) {
+        const Group* destinationGroup = dbDestination->rootGroup()->findGroupByUuid(sourceGroup->uuid());
+        QVERIFY(destinationGroup);
+        QVERIFY(destinationGroup->equals(sourceGroup, CompareItemDefault));
+    }
+    QVERIFY(dbDestination->deletedObjects() == dbSource->deletedObjects());
+
+    // Nothing to do for identical databases
+    QVERIFY(Merger(dbSource.data(), dbDestination.data()).mirror().isEmpty());
+}
+
 Database* TestMerge::createTestDatabase()
 {
     Database* db = new Database();
@@ -31,6 +31,7 @@ private slots:
     void testMergeIntoNew();
     void testMergeNoChanges();
     void testResolveConflictNewer();
+    void testMergeCompactSourceHistory();
     void testResolveConflictExisting();
     void testResolveGroupConflictOlder();
     void testMergeNotModified();
@@ -61,6 +62,10 @@ private slots:
     void testDeletedGroup();
     void testDeletedRevertedEntry();
     void testDeletedRevertedGroup();
+    void testDeletedNestedGroups();
+    void benchmarkMergeDeletions();
+    void testPlan();
+    void testMirror();
 
 private:
     Database* createTestDatabase();
@@ -17,6 +17,7 @@
 
 #include "TestPasswordHealth.h"
 
+#include "core/Group.h"
 #include "core/PasswordHealth.h"
 
 #include <QTest>
@@ -64,3 +65,53 @@ void TestPasswordHealth::testNoDb()
     QVERIFY(excellent.scoreReason().isEmpty());
     QVERIFY(excellent.scoreDetails().isEmpty());
 }
+
+void TestPasswordHealth::testHealthCache()
+{
+    auto db = QSharedPointer<Database>::create();
+    auto weak = new Entry();
+    weak->setPassword("Yohb2ChR4");
+    weak->setGroup(db->rootGroup());
+    auto reused1 = new Entry();
+    reused1->setPassword("MIhIN9UKrgtPL2hp");
+    reused1->setGroup(db->rootGroup());
+    auto reused2 = new Entry();
+    reused2->setPassword("MIhIN9UKrgtPL2hp");
+    reused2->setGroup(db->rootGroup());
+
+    // The cached entropy is the same as the one of the password
+    auto cache = db->passwordHealthCache();
+    QCOMPARE(cache->entropy("Yohb2ChR4"), PasswordHealth("Yohb2ChR4").entropy());
+    QCOMPARE(cache->entropy("Yohb2ChR4"), PasswordHealth("Yohb2ChR4").entropy());
+    QCOMPARE(weak->passwordHealth()->score(), 47);
+
+    // The least recently used passwords are dropped once the cache is full
+    PasswordHealthCache smallCache(2);
+    QCOMPARE(smallCache.entropy("Yohb2ChR4"), PasswordHealth("Yohb2ChR4").entropy());
+    smallCache.entropy("MIhIN9UKrgtPL2hp");
+    smallCache.entropy("prompter-ream-oversleep");
+    QCOMPARE(smallCache.size(), 2);
+    QCOMPARE(smallCache.entropy("Yohb2ChR4"), PasswordHealth("Yohb2ChR4").entropy());
+
+    // Re-use and expiry are still applied to cached passwords
+    HealthChecker checker(db);
+    QCOMPARE(checker.evaluate(weak)->score(), 47);
+    QCOMPARE(checker.evaluate(reused1)->score(), 63);
+    QCOMPARE(checker.evaluate(reused1)->quality(), PasswordHealth::Quality::Weak);
+    QCOMPARE(reused2->passwordHealth()->score(), 78);
+
+    // A changed password is evaluated again
+    weak->setPassword("prompter-ream-oversleep-step-extortion-quarrel-reflected-prefix");
+    QCOMPARE(weak->passwordHealth()->score(), 164);
+    QCOMPARE(checker.evaluate(weak)->score(), 164);
+
+    weak->setPassword("Yohb2ChR4");
+    weak->setExpires(true);
+    weak->setExpiryTime(QDateTime::currentDateTimeUtc().addDays(-1));
+    QCOMPARE(checker.evaluate(weak)->score(), 0);
+
+    // Copied values give the same result as the entry
+    const auto copied = checker.evaluate(reused1->password(), weak->timeInfo());
+    QCOMPARE(copied->score(), 0);
+    QVERIFY(copied->scoreReason().contains("used 2 time"));
+}
@@ -27,6 +27,7 @@ class TestPasswordHealth : public QObject
 private slots:
     void initTestCase();
     void testNoDb();
+    void testHealthCache();
 };
 
 #endif // KEEPASSX_TESTPASSWORDHEALTH_H
@@ -19,13 +19,63 @@
 #include "config-keepassx-tests.h"
 #include "core/Config.h"
 #include "crypto/Crypto.h"
+#include "sshagent/BinaryStream.h"
 #include "sshagent/KeeAgentSettings.h"
 #include "sshagent/SSHAgent.h"
 
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSemaphore>
+#include <QTemporaryDir>
 #include <QTest>
+#include <QThread>
 
 QTEST_GUILESS_MAIN(TestSSHAgent)
 
+namespace
+{
+    // Agent that accepts the first request of a connection and drops the connection before answering the others
+    class FailingAgent : public QThread
+    {
+    public:
+        explicit FailingAgent(const QString& socketName)
+            : m_socketName(socketName)
+        {
+        }
+
+        QSemaphore listening;
+        QSemaphore done;
+
+    protected:
+        void run() override
+        {
+            QLocalServer server;
+            server.listen(m_socketName);
+            listening.release();
+
+            if (server.waitForNewConnection(5000)) {
+                QLocalSocket* socket = server.nextPendingConnection();
+                {
+                    BinaryStream stream(socket);
+                    QByteArray request;
+                    if (stream.readString(request)) {
+                        stream.writeString(QByteArray(1, 6)); // SSH_AGENT_SUCCESS
+                        stream.flush();
+                        socket->waitForBytesWritten(1000);
+                    }
+                }
+                socket->disconnectFromServer();
+            }
+
+            // Keep the socket file until the test is done with the agent
+            done.acquire();
+        }
+
+    private:
+        QString m_socketName;
+    };
+} // namespace
+
 void TestSSHAgent::initTestCase()
 {
     QVERIFY(Crypto::init());
@@ -137,6 +187,71 @@ void TestSSHAgent::testIdentity()
     QVERIFY(agent.checkIdentity(m_key, keyInAgent) && !keyInAgent);
 }
 
+void TestSSHAgent::testAddIdentities()
+{
+    SSHAgent agent;
+    agent.setEnabled(true);
+    agent.setAuthSockOverride(m_agentSocketFileName);
+
+    QVERIFY(agent.isAgentRunning());
+
+    KeeAgentSettings settings;
+    KeeAgentSettings lifetimeSettings;
+    lifetimeSettings.setUseLifetimeConstraintWhenAdding(true);
+    lifetimeSettings.setLifetimeConstraintDuration(60);
+    bool keyInAgent;
+
+    // all requests of a batch are answered in order
+    QList<OpenSSHKey> keys{m_key, m_key};
+    auto errors = agent.addIdentities(keys, {settings, lifetimeSettings}, m_uuid);
+    QCOMPARE(errors, QStringList({QString(), QString()}));
+    QVERIFY(agent.checkIdentity(m_key, keyInAgent) && keyInAgent);
+
+    // conflicting keys are refused without affecting the others
+    QUuid secondUuid("{11111111-1111-1111-1111-111111111111}");
+    errors = agent.addIdentities(keys, {settings, settings}, secondUuid);
+    QCOMPARE(errors.size(), 2);
+    QVERIFY(!errors[0].isEmpty());
+    QVERIFY(!errors[1].isEmpty());
+
+    // the connection is reused for the following requests
+    QVERIFY(agent.removeIdentity(m_key));
+    QVERIFY(agent.checkIdentity(m_key, keyInAgent) && !keyInAgent);
+    QVERIFY(agent.addIdentity(m_key, settings, m_uuid));
+    QVERIFY(agent.removeIdentity(m_key));
+}
+
+void TestSSHAgent::testAddIdentitiesPartialFailure()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString socketName = dir.filePath("agent");
+    FailingAgent fakeAgent(socketName);
+    fakeAgent.start();
+    fakeAgent.listening.acquire();
+
+    SSHAgent agent;
+    agent.setEnabled(true);
+    agent.setAuthSockOverride(socketName);
+    QVERIFY(agent.isAgentRunning());
+
+    // The key accepted before the connection was lost is added, only the unanswered one fails
+    KeeAgentSettings settings;
+    QList<OpenSSHKey> keys{m_key, m_key};
+    const auto errors = agent.addIdentities(keys, {settings, settings}, m_uuid);
+    QCOMPARE(errors.size(), 2);
+    QVERIFY(errors[0].isEmpty());
+    QVERIFY(!errors[1].isEmpty());
+
+    // The accepted key is owned by the database, so it is removed on lock
+    QUuid secondUuid("{11111111-1111-1111-1111-111111111111}");
+    QVERIFY(!agent.addIdentity(m_key, settings, secondUuid));
+    QCOMPARE(agent.errorString(), QString("Key identity ownership conflict. Refusing to add."));
+
+    fakeAgent.done.release();
+    QVERIFY(fakeAgent.wait(5000));
+}
+
 void TestSSHAgent::testRemoveOnClose()
 {
     SSHAgent agent;
@@ -31,6 +31,8 @@ private slots:
     void initTestCase();
     void testConfiguration();
     void testIdentity();
+    void testAddIdentities();
+    void testAddIdentitiesPartialFailure();
     void testRemoveOnClose();
     void testLifetimeConstraint();
     void testConfirmConstraint();
@@ -18,7 +18,13 @@
 #include "TestTools.h"
 
 #include "core/Clock.h"
+#include "core/Trace.h"
 
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
 #include <QTest>
 
 QTEST_GUILESS_MAIN(TestTools)
@@ -162,3 +168,38 @@ void TestTools::testBackupFilePatternSubstitution()
 
     QCOMPARE(Tools::substituteBackupFilePath(pattern, dbFilePath), expectedSubstitution);
 }
+
+void TestTools::testTrace()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filePath = tempDir.filePath("trace.json");
+
+    {
+        Trace::Scope trace("not recorded");
+    }
+    QVERIFY(!Trace::isEnabled());
+
+    Trace::start(filePath);
+    QVERIFY(Trace::isEnabled());
+    {
+        Trace::Scope outer("outer");
+        Trace::Scope inner("inner");
+    }
+    QVERIFY(Trace::stop());
+    QVERIFY(!Trace::isEnabled());
+
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QJsonArray events = QJsonDocument::fromJson(file.readAll()).object().value("traceEvents").toArray();
+    QCOMPARE(events.size(), 2);
+    // Scopes are recorded when they end
+    const QJsonObject inner = events.at(0).toObject();
+    const QJsonObject outer = events.at(1).toObject();
+    QCOMPARE(inner.value("name").toString(), QString("inner"));
+    QCOMPARE(inner.value("ph").toString(), QString("X"));
+    QCOMPARE(outer.value("name").toString(), QString("outer"));
+    QVERIFY(outer.value("ts").toDouble() <= inner.value("ts").toDouble());
+    QVERIFY(outer.value("dur").toDouble() >= inner.value("dur").toDouble());
+    QCOMPARE(outer.value("tid").toDouble(), inner.value("tid").toDouble());
+}
@@ -31,6 +31,7 @@ private slots:
     void testValidUuid();
     void testBackupFilePatternSubstitution_data();
     void testBackupFilePatternSubstitution();
+    void testTrace();
 };
 
 #endif // KEEPASSX_TESTTOOLS_H
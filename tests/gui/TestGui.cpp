@@ -317,6 +317,8 @@ void TestGui::testMergeDatabase()
     auto* editPasswordMerge = QApplication::focusWidget();
     QVERIFY(editPasswordMerge->isVisible());
 
+    // confirm the merge after seeing the planned changes
+    MessageBox::setNextAnswer(MessageBox::Merge);
     QTest::keyClicks(editPasswordMerge, "a");
     QTest::keyClick(editPasswordMerge, Qt::Key_Enter);
 
@@ -342,8 +344,9 @@ void TestGui::testAutoreloadDatabase()
     // Overwrite the current database with the temp data
     QVERIFY(m_dbFile.copyFromFile(QString(KEEPASSX_TEST_DATA_DIR).append("/MergeDatabase.kdbx")));
 
-    QTRY_VERIFY(m_db != m_dbWidget->database());
-    m_db = m_dbWidget->database();
+    // The database is reloaded in place
+    QTRY_COMPARE(m_db->rootGroup()->findChildByName("General")->entries().size(), 1);
+    QCOMPARE(m_dbWidget->database(), m_db);
 
     // the General group contains one entry from the new db data
     QCOMPARE(m_db->rootGroup()->findChildByName("General")->entries().size(), 1);
@@ -379,13 +382,35 @@ void TestGui::testAutoreloadDatabase()
     // Overwrite the current database with the temp data
     QVERIFY(m_dbFile.copyFromFile(QString(KEEPASSX_TEST_DATA_DIR).append("/MergeDatabase.kdbx")));
 
-    QTRY_VERIFY(m_db != m_dbWidget->database());
-    m_db = m_dbWidget->database();
-
-    QCOMPARE(m_db->rootGroup()->findChildByName("General")->entries().size(), 1);
+    QTRY_COMPARE(m_db->rootGroup()->findChildByName("General")->entries().size(), 1);
     QTRY_VERIFY(m_tabWidget->tabText(m_tabWidget->currentIndex()).endsWith("*"));
 }
 
+void TestGui::testAutoreloadSearch()
+{
+    config()->set(Config::AutoReloadOnChange, true);
+
+    // Change the title of an entry in the file behind the back of the open database
+    auto db = QSharedPointer<Database>::create();
+    QVERIFY(db->open(m_dbFilePath, m_db->key()));
+    Entry* changedEntry = db->rootGroup()->entriesRecursive().first();
+    changedEntry->setTitle("Reloaded title");
+    QString error;
+    QVERIFY2(db->save(Database::Atomic, {}, &error), qPrintable(error));
+
+    Entry* entry = m_db->rootGroup()->findEntryByUuid(changedEntry->uuid());
+    QVERIFY(entry);
+    QTRY_COMPARE(entry->title(), QString("Reloaded title"));
+
+    // The search index was built from the previous title
+    auto* entryView = m_dbWidget->findChild<EntryView*>("entryView");
+    m_dbWidget->search("Reloaded");
+    QTRY_VERIFY(m_dbWidget->isSearchActive());
+    QTRY_COMPARE(entryView->model()->rowCount(), 1);
+    QCOMPARE(entryView->entryFromIndex(entryView->model()->index(0, 1)), entry);
+    m_dbWidget->endSearch();
+}
+
 void TestGui::testTabs()
 {
     QCOMPARE(m_tabWidget->count(), 1);
@@ -41,6 +41,7 @@ private slots:
     void testCreateDatabase();
     void testMergeDatabase();
     void testAutoreloadDatabase();
+    void testAutoreloadSearch();
     void testTabs();
     void testEditEntry();
     void testSearchEditEntry();